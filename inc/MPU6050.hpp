@@ -0,0 +1,237 @@
+/*
+ * MPU6050.hpp
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_HPP
+#define MPU6050_HPP
+
+// The static constexpr members below are only defined (inline variables) from C++17 on
+#if __cplusplus < 201703L
+#error "MPU6050.hpp requires C++17"
+#endif
+
+#include "MPU6050_LIB.h"
+
+/*  NOTE: Header-only C++17 front end of the library. The configuration is a set of
+	template parameters, so the register values and the conversion factors are
+	compile-time constants and invalid combinations fail to compile (static_assert).
+	The sensor burst is read straight through Bus and decoded inline with those
+	constants: no transport indirection, scale lookup or division per sample.
+
+	Bus is any type with the static read/write functions of MPU6050_Transport
+	(DefaultBus uses the transport selected by MPU6050_TRANSPORT). The device keeps an
+	MPU6050_ConfigTypeDef filled with the same values, so every C function (init,
+	calibration, FIFO, profiles...) is called on config(). A C setter that changes the
+	full-scale range leaves the compile-time factors of getAllSensors stale: use the C
+	getters after runtime reconfiguration. */
+
+namespace mpu6050 {
+
+// REG_ACCEL_CONFIG full-scale range
+enum class AccelScale : uint8_t {
+	G2 = ACCEL_CONFIG_SCALE_0,
+	G4 = ACCEL_CONFIG_SCALE_1,
+	G8 = ACCEL_CONFIG_SCALE_2,
+	G16 = ACCEL_CONFIG_SCALE_3
+};
+
+// REG_GYRO_CONFIG full-scale range
+enum class GyroScale : uint8_t {
+	Dps250 = GYRO_CONFIG_SCALE_0,
+	Dps500 = GYRO_CONFIG_SCALE_1,
+	Dps1000 = GYRO_CONFIG_SCALE_2,
+	Dps2000 = GYRO_CONFIG_SCALE_3
+};
+
+// REG_CONFIG DLPF_CFG, named by the accelerometer bandwidth
+enum class Dlpf : uint8_t {
+	Hz260 = DLPF_CONFIG_0,		// Gyroscope output rate 8kHz
+	Hz184 = DLPF_CONFIG_1,
+	Hz94 = DLPF_CONFIG_2,
+	Hz44 = DLPF_CONFIG_3,
+	Hz21 = DLPF_CONFIG_4,
+	Hz10 = DLPF_CONFIG_5,
+	Hz5 = DLPF_CONFIG_6
+};
+
+// Transport selected by MPU6050_TRANSPORT, called directly
+struct DefaultBus {
+	static HAL_StatusTypeDef read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_STM32_HAL
+		return HAL_I2C_Mem_Read(hi2c, address<<1, reg, I2C_MEMADD_SIZE_8BIT, data, len, MPU6050_TIMEOUT_MS);
+#else
+		return MPU6050_DefaultTransport.read(hi2c, address, reg, data, len);
+#endif
+	}
+
+	static HAL_StatusTypeDef write(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_STM32_HAL
+		return HAL_I2C_Mem_Write(hi2c, address<<1, reg, I2C_MEMADD_SIZE_8BIT, data, len, MPU6050_TIMEOUT_MS);
+#else
+		return MPU6050_DefaultTransport.write(hi2c, address, reg, data, len);
+#endif
+	}
+};
+
+template <typename Bus, uint8_t Address, AccelScale Accel = AccelScale::G2, GyroScale Gyro = GyroScale::Dps250,
+		  Dlpf Filter = Dlpf::Hz44, uint8_t SmplRateDiv = 0, uint8_t ClkSel = CLKSEL_CONFIG_1>
+class Mpu6050 {
+	static_assert(Address == MPU6050_ADDRESS_AD0_L || Address == MPU6050_ADDRESS_AD0_H, "MPU6050 address must be MPU6050_ADDRESS_AD0_L or MPU6050_ADDRESS_AD0_H");
+	static_assert(ClkSel <= CLKSEL_CONFIG_5, "CLKSEL 6 is reserved and CLKSEL 7 stops the clock");
+
+public:
+	// Register values
+	static constexpr uint8_t dlpfFsyncConfig = static_cast<uint8_t>(Filter);
+	static constexpr uint8_t smplRateDivConfig = SmplRateDiv;
+	static constexpr uint8_t pwrMgmt1Config = ClkSel;
+	static constexpr uint8_t pwrMgmt2Config = 0;
+	static constexpr uint8_t accelConfig = static_cast<uint8_t>(Accel);
+	static constexpr uint8_t gyroConfig = static_cast<uint8_t>(Gyro);
+
+	// Sample rate = gyroscope output rate / (1 + SMPLRT_DIV). Up to 8kHz with Dlpf::Hz260, the
+	// accelerometer samples then repeat above its 1kHz output rate
+	static constexpr uint32_t gyroOutputRateHz = (Dlpf::Hz260 == Filter) ? GYRO_OUTPUT_RATE_HZ_DLPF_OFF : GYRO_OUTPUT_RATE_HZ_DLPF_ON;
+	static constexpr uint32_t sampleRateHz = gyroOutputRateHz / (1u + SmplRateDiv);
+
+private:
+	static constexpr uint16_t accelLsbSen[4] = {ACCEL_LSB_SEN_0, ACCEL_LSB_SEN_1, ACCEL_LSB_SEN_2, ACCEL_LSB_SEN_3};
+	static constexpr float gyroLsbSen[4] = {GYRO_LSB_SEN_0, GYRO_LSB_SEN_1, GYRO_LSB_SEN_2, GYRO_LSB_SEN_3};
+	static constexpr uint8_t accelIndex = (accelConfig & GET_ACCEL_FS_CONFIG) >> FS_CONFIG_SHIFT;
+	static constexpr uint8_t gyroIndex = (gyroConfig & GET_GYRO_FS_CONFIG) >> FS_CONFIG_SHIFT;
+#if MPU6050_GYRO_UNITS == MPU6050_GYRO_RADS
+	static constexpr float gyroUnitFactor = DEG_TO_RAD;
+#else
+	static constexpr float gyroUnitFactor = 1.0f;
+#endif
+
+public:
+	// Conversion factors, same expressions as the tables of MPU6050_UpdateScales (bit-exact results)
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+	static constexpr int32_t accelScale = MPU6050_Q16(1000.0 / accelLsbSen[accelIndex]);
+	static constexpr int32_t gyroScale = MPU6050_Q16(1000.0 * gyroUnitFactor / gyroLsbSen[gyroIndex]);
+#else
+	static constexpr float accelScale = GRAVITY_ACCEL / accelLsbSen[accelIndex];
+	static constexpr float gyroScale = gyroUnitFactor / gyroLsbSen[gyroIndex];
+#endif
+
+	static constexpr MPU6050_Transport transport = {&Bus::read, &Bus::write, nullptr, nullptr};
+
+	explicit Mpu6050(I2C_HandleTypeDef *hi2c) : config_() {
+		config_.hi2c = hi2c;
+		config_.address = Address;
+		config_.transport = &transport;
+		config_.dlpfFsyncConfig = dlpfFsyncConfig;
+		config_.smplRateDivConfig = smplRateDivConfig;
+		config_.pwrMgmt1Config = pwrMgmt1Config;
+		config_.pwrMgmt2Config = pwrMgmt2Config;
+		config_.accelConfig = accelConfig;
+		config_.gyroConfig = gyroConfig;
+	}
+
+	// Configuration used by the C API
+	MPU6050_ConfigTypeDef *config() {
+		return &config_;
+	}
+
+	uint8_t init() {
+		return MPU6050_Init(&config_);
+	}
+
+	// One burst read of REG_ACCEL_XOUT_H..REG_GYRO_ZOUT_L, any output pointer can be nullptr
+	// Connection health and stats (STATS_GET_ALL) are kept by the C library hooks
+	uint8_t getAllSensors(MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+		uint8_t data[MPU6050_SENSORS_BURST_LEN];
+		uint32_t callTicks;
+
+		if(CONN_OK != MPU6050_CallBegin(&config_, &callTicks)){
+			return MPU6050_CallEnd(&config_, STATS_GET_ALL, callTicks, ERR_CONN_0);
+		}
+
+		uint32_t timestampUs = MPU6050_GetTimeUs(&config_);
+		uint32_t startTicks = MPU6050_TransferBegin(&config_);
+		HAL_StatusTypeDef status = Bus::read(config_.hi2c, Address, REG_ACCEL_XOUT_H, data, sizeof(data));
+		MPU6050_TransferEnd(&config_, startTicks, status, sizeof(data), 0);
+		if(HAL_OK != status){
+			return MPU6050_CallEnd(&config_, STATS_GET_ALL, callTicks, ERR_CONN_0);
+		}
+
+		decode(data, timestampUs, accel, rota, temp);
+
+		return MPU6050_CallEnd(&config_, STATS_GET_ALL, callTicks, CONN_OK);
+	}
+
+	// Decodes a REG_ACCEL_XOUT_H..REG_GYRO_ZOUT_L burst read at timestampUs (e.g. from the asynchronous reader)
+	static void decode(const uint8_t *data, uint32_t timestampUs, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+		if(accel != nullptr){
+			accel->timestampUs = timestampUs;
+			accel->rawAccelX = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+			accel->rawAccelY = MPU6050_BYTES_TO_INT16(data[2], data[3]);
+			accel->rawAccelZ = MPU6050_BYTES_TO_INT16(data[4], data[5]);
+			accel->convertedAccelX = convert(accel->rawAccelX, accelScale);
+			accel->convertedAccelY = convert(accel->rawAccelY, accelScale);
+			accel->convertedAccelZ = convert(accel->rawAccelZ, accelScale);
+		}
+
+		if(temp != nullptr){
+			temp->timestampUs = timestampUs;
+			temp->rawTemp = MPU6050_BYTES_TO_INT16(data[6], data[7]);
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+			temp->convertedTemp = MPU6050_RAW_TO_TEMP_FIXED(temp->rawTemp);
+#else
+			temp->convertedTemp = MPU6050_RAW_TO_TEMP(temp->rawTemp);
+#endif
+		}
+
+		if(rota != nullptr){
+			rota->timestampUs = timestampUs;
+			rota->rawRotaX = MPU6050_BYTES_TO_INT16(data[8], data[9]);
+			rota->rawRotaY = MPU6050_BYTES_TO_INT16(data[10], data[11]);
+			rota->rawRotaZ = MPU6050_BYTES_TO_INT16(data[12], data[13]);
+			rota->convertedRotaX = convert(rota->rawRotaX, gyroScale);
+			rota->convertedRotaY = convert(rota->rawRotaY, gyroScale);
+			rota->convertedRotaZ = convert(rota->rawRotaZ, gyroScale);
+		}
+	}
+
+private:
+	MPU6050_ConfigTypeDef config_;
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+	static MPU6050_ConvertedData convert(int16_t rawData, int32_t scale) {
+		return MPU6050_RAW_TO_FIXED(rawData, scale);
+	}
+#else
+	static MPU6050_ConvertedData convert(int16_t rawData, float scale) {
+		return MPU6050_RAW_TO_SCALED(rawData, scale);
+	}
+#endif
+};
+
+} // namespace mpu6050
+
+#endif /* MPU6050_HPP */
@@ -0,0 +1,70 @@
+/*
+ * MPU6050_BATCH.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+#ifndef MPU6050_BATCH
+#define MPU6050_BATCH
+
+#include "MPU6050_LIB.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: Converts blocks of raw 14-byte frames (ACCEL_XOUT_H..GYRO_ZOUT_L, big-endian),
+	as produced by MPU6050_GetAllSensors bursts or a FIFO loaded with
+	ACCEL | TEMP | XG | YG | ZG, into one float array per channel.
+
+	The int16 to float scaling kernel is selected at compile time:
+	(i) CMSIS-DSP when MPU6050_USE_CMSIS_DSP is defined (Cortex-M4/M7)
+	(ii) AVX2, SSE2 or NEON when the compiler targets them (host tools)
+	(iii) Portable scalar loop otherwise */
+
+// MPU6050 batch output (structure of arrays, any pointer can be NULL to skip that channel)
+typedef struct {
+	float *accelX;
+	float *accelY;
+	float *accelZ;
+	float *temp;
+	float *rotaX;
+	float *rotaY;
+	float *rotaZ;
+} MPU6050_BatchData;
+
+// Parameters and constants
+#define MPU6050_BATCH_CHANNELS		7		// AX AY AZ T GX GY GZ
+#define MPU6050_BATCH_BLOCK			64		// Frames de-interleaved per pass (stack: 7 * 64 * 2 bytes)
+
+// FUNCTIONS PROTOTYPES
+void MPU6050_ConvertBatch(MPU6050_ConfigTypeDef *config, const uint8_t *frames, uint32_t numFrames, MPU6050_BatchData *out);
+void MPU6050_ScaleInt16(const int16_t *raw, float *dst, uint32_t len, float scale, float offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_BATCH */
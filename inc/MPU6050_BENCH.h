@@ -0,0 +1,132 @@
+/*
+ * MPU6050_BENCH.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_BENCH
+#define MPU6050_BENCH
+
+#include <stdio.h>
+#include "MPU6050_SIM.h"
+#include "MPU6050_FUSION.h"
+#include "MPU6050_FILTER.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: Benchmarks of the public functions against the simulated bus (MPU6050_SIM).
+	Every case runs once per bus clock in MPU6050_BenchClocks on a freshly initialized
+	device. Results are per call: transactions and bytes on the wire, bus time at each
+	clock and host CPU time (simulator included). Calibration cases run once and report
+	every read needed to converge. MPU6050_BenchWriteJson writes the results as JSON.
+
+	MPU6050_BenchFusionRunAll feeds every fusion filter with a synthetic motion trace read
+	from the simulator (burst reads at 1 kHz) and reports the attitude error against the
+	true orientation and the CPU time per update.
+
+	MPU6050_BenchFilterRunAll runs filter banks on 6 channels (accelerometer and gyroscope)
+	and reports the gain at a motion tone and at a vibration tone, and the CPU time per
+	input sample. */
+
+// Parameters and constants
+#define MPU6050_BENCH_CLOCKS		2
+#define MPU6050_BENCH_MAX_CASES		32
+#define MPU6050_BENCH_CALIB_TOLERANCE	0.005f
+#define MPU6050_BENCH_FUSION_SAMPLES	10000	// 10 s at 1 kHz
+#define MPU6050_BENCH_FUSION_FILTERS	3
+#define MPU6050_BENCH_FILTER_SAMPLES	10000	// 10 s at 1 kHz
+#define MPU6050_BENCH_FILTER_CASES		4
+#define MPU6050_BENCH_FILTER_PASS_HZ	20.0	// Motion
+#define MPU6050_BENCH_FILTER_STOP_HZ	180.0	// Vibration
+
+typedef uint8_t (*MPU6050_BenchFn)(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus);
+
+// Benchmark case
+typedef struct {
+	const char *name;
+	MPU6050_BenchFn setup;				// Optional, not measured
+	MPU6050_BenchFn run;				// Measured, returns the status of the benchmarked function
+	uint32_t calls;
+} MPU6050_BenchCase;
+
+// Benchmark results (per call)
+typedef struct {
+	const char *name;
+	uint8_t status;						// Last value returned by the benchmarked function
+	uint32_t calls;
+	double transactions;
+	double reads;
+	double writes;
+	double bytesRead;
+	double bytesWritten;
+	double busTimeUs[MPU6050_BENCH_CLOCKS];
+	double cpuTimeUs;
+} MPU6050_BenchResult;
+
+// Fusion results
+typedef struct {
+	const char *name;
+	uint32_t updates;
+	double rmsErrorDeg;					// Angle between the estimated and the true attitude
+	double maxErrorDeg;
+	double rmsLinearAccel;				// Linear acceleration left while only gravity acts (accelerometer units)
+	double cpuTimeNs;					// Per update
+} MPU6050_BenchFusionResult;
+
+// Filter bank results
+typedef struct {
+	const char *name;
+	uint8_t channels;
+	uint8_t stages;						// Biquads per channel
+	uint8_t decimation;
+	uint8_t taps;
+	uint32_t samples;
+	double passGainDb;					// At MPU6050_BENCH_FILTER_PASS_HZ
+	double stopGainDb;					// At MPU6050_BENCH_FILTER_STOP_HZ
+	double cpuTimeNs;					// Per input sample, all the channels
+} MPU6050_BenchFilterResult;
+
+extern const uint32_t MPU6050_BenchClocks[MPU6050_BENCH_CLOCKS];
+extern const MPU6050_BenchCase MPU6050_BenchCases[];
+
+// FUNCTIONS PROTOTYPES
+void MPU6050_BenchRun(const MPU6050_BenchCase *bench, MPU6050_BenchResult *result);
+uint16_t MPU6050_BenchRunAll(MPU6050_BenchResult *results, uint16_t maxResults);
+void MPU6050_BenchWriteJson(FILE *out, const MPU6050_BenchResult *results, uint16_t numResults);
+
+uint8_t MPU6050_BenchFusionRunAll(MPU6050_BenchFusionResult *results);
+void MPU6050_BenchWriteFusionJson(FILE *out, const MPU6050_BenchFusionResult *results, uint8_t numResults);
+
+uint8_t MPU6050_BenchFilterRunAll(MPU6050_BenchFilterResult *results);
+void MPU6050_BenchWriteFilterJson(FILE *out, const MPU6050_BenchFilterResult *results, uint8_t numResults);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_BENCH */
@@ -0,0 +1,198 @@
+/*
+ * MPU6050_CAPTURE.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+
+#ifndef MPU6050_CAPTURE
+#define MPU6050_CAPTURE
+
+#include "MPU6050_LIB.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: Compact binary recording of raw samples. All fields are little-endian.
+
+	File header (MPU6050_CAPTURE_HEADER_LEN bytes):
+	"MPU6", version, header length, channels, address, REG_SMPLRT_DIV, REG_CONFIG,
+	REG_GYRO_CONFIG, REG_ACCEL_CONFIG, REG_PWR_MGMT_1, REG_PWR_MGMT_2, REG_FIFO_EN,
+	REG_INT_PIN_CFG, REG_INT_ENABLE, 0, accel LSB/g (u16), gyro LSB/(º/s) x10 (u16),
+	sample period in us (u32), 6 reserved bytes.
+
+	Then blocks, each one decodable on its own (so a file can be split or resynchronized):
+	sync "BK", payload length (u16), frames (u16), first timestamp (u32), Fletcher-16 of
+	the payload (u16), payload. A frame is the timestamp as the change of the time step
+	(zigzag varint, usually 1 byte), then every recorded channel in burst order
+	(AX AY AZ T GX GY GZ) as the zigzag varint of its 16-bit difference with the previous
+	frame. Channels start from 0 and the time step from the sample period in every block.
+
+	The writer encodes into a caller-owned buffer holding two blocks and hands every full
+	block to a sink (UART/SD DMA, fwrite...). A block stays untouched until the next one is
+	full, so the sink can send it in the background. The reader works on any memory range:
+	a flash partition, or a file mapped with MPU6050_CaptureMapFile on Linux. */
+
+// Parameters and constants
+#define MPU6050_CAPTURE_MAGIC			"MPU6"
+#define MPU6050_CAPTURE_VERSION			1
+#define MPU6050_CAPTURE_HEADER_LEN		32
+#define MPU6050_CAPTURE_BLOCK_HEADER_LEN	12
+#define MPU6050_CAPTURE_CHANNELS		7		// AX AY AZ T GX GY GZ
+#define MPU6050_CAPTURE_MAX_FRAME_LEN	(5 + 3 * MPU6050_CAPTURE_CHANNELS)
+#define MPU6050_CAPTURE_MAX_BLOCK_LEN	65535
+
+										// Recorded channels
+#define MPU6050_CAPTURE_ACCEL			0b00000001	// AX AY AZ
+#define MPU6050_CAPTURE_TEMP			0b00000010	// T
+#define MPU6050_CAPTURE_GYRO			0b00000100	// GX GY GZ
+#define MPU6050_CAPTURE_ALL				0b00000111
+
+// Recorded sample (channels not recorded are 0)
+typedef struct {
+	int16_t raw[MPU6050_CAPTURE_CHANNELS];	// Burst order: AX AY AZ T GX GY GZ
+	uint32_t timestampUs;
+} MPU6050_CaptureFrame;
+
+// Decoded file header
+typedef struct {
+	uint8_t version;
+	uint8_t channels;					// MPU6050_CAPTURE_ACCEL | TEMP | GYRO
+	uint8_t address;
+	uint8_t smplRateDivConfig;
+	uint8_t dlpfFsyncConfig;
+	uint8_t gyroConfig;
+	uint8_t accelConfig;
+	uint8_t pwrMgmt1Config;
+	uint8_t pwrMgmt2Config;
+	uint8_t fifoEnConfig;
+	uint8_t intPinConfig;
+	uint8_t intEnableConfig;
+	uint16_t accelLsbPerG;
+	uint16_t gyroLsbPerDps10;			// LSB/(º/s) x10
+	uint32_t samplePeriodUs;
+} MPU6050_CaptureHeader;
+
+// Block handed to the sink: TRUE when it has been written (or queued)
+typedef uint8_t (*MPU6050_CaptureSinkFn)(void *context, const uint8_t *data, uint16_t len);
+
+// Streaming writer (no allocation, the buffer is owned by the caller)
+typedef struct {
+	uint8_t *buffer;
+	uint16_t blockSize;					// Half of the buffer
+	uint8_t *block;						// Block being filled
+	uint16_t blockLen;					// Block header included
+	uint16_t blockFrames;
+	MPU6050_CaptureSinkFn sink;
+	void *context;
+
+	uint8_t channels;
+	uint32_t periodUs;
+	int16_t prev[MPU6050_CAPTURE_CHANNELS];
+	uint32_t prevTimestampUs;
+	int32_t prevStepUs;
+
+	uint32_t frames;					// Frames encoded
+	uint32_t bytes;						// Bytes accepted by the sink, file header included
+	uint32_t droppedBlocks;				// Blocks the sink refused
+} MPU6050_CaptureWriter;
+
+// Reader of a capture in memory
+typedef struct {
+	const uint8_t *data;
+	size_t size;
+	MPU6050_CaptureHeader header;
+
+	size_t pos;							// Next byte to decode
+	size_t blockEnd;
+	uint16_t framesLeft;				// In the current block
+	int16_t prev[MPU6050_CAPTURE_CHANNELS];
+	uint32_t prevTimestampUs;
+	int32_t prevStepUs;
+
+	uint32_t frames;					// Frames decoded
+	uint32_t corruptBlocks;				// Skipped on a checksum or length error
+} MPU6050_CaptureReader;
+
+// Errors enumeration
+typedef enum {
+	CAPTURE_OK = 0,
+	ERR_CAPTURE_SINK,					// The sink refused the data
+	ERR_CAPTURE_BUFFER,					// Buffer too small for two blocks of one frame
+	ERR_CAPTURE_FORMAT,					// Not a capture, or a newer version
+	ERR_CAPTURE_END						// No more frames
+} CaptureError;
+
+// FUNCTIONS PROTOTYPES
+uint8_t MPU6050_CaptureWriterInit(MPU6050_CaptureWriter *writer, uint8_t *buffer, uint32_t bufferSize, MPU6050_CaptureSinkFn sink, void *context);
+uint8_t MPU6050_CaptureBegin(MPU6050_CaptureWriter *writer, MPU6050_ConfigTypeDef *config, uint8_t channels);
+uint8_t MPU6050_CaptureWriteRaw(MPU6050_CaptureWriter *writer, const int16_t raw[MPU6050_CAPTURE_CHANNELS], uint32_t timestampUs);
+uint8_t MPU6050_CaptureWriteSample(MPU6050_CaptureWriter *writer, const MPU6050_Accelerations *accel, const MPU6050_Rotations *rota, const MPU6050_Temperature *temp);
+uint8_t MPU6050_CaptureFlush(MPU6050_CaptureWriter *writer);
+
+uint8_t MPU6050_CaptureReaderInit(MPU6050_CaptureReader *reader, const uint8_t *data, size_t size);
+uint8_t MPU6050_CaptureReadFrame(MPU6050_CaptureReader *reader, MPU6050_CaptureFrame *frame);
+uint8_t MPU6050_CaptureSeek(MPU6050_CaptureReader *reader, size_t offset);
+void MPU6050_CaptureApplyHeader(const MPU6050_CaptureHeader *header, MPU6050_ConfigTypeDef *config);
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+/*  NOTE: Replay of a capture through the library. The transport serves a register file
+	initialized from the header, every read touching REG_ACCEL_XOUT_H..REG_GYRO_ZOUT_L
+	returns the next frame (so read all sensors in one MPU6050_GetAllSensors burst), and
+	the end of the capture is reported as HAL_ERROR. Attached through hi2c->context:
+
+	MPU6050_CaptureReplay replay;
+	I2C_HandleTypeDef hi2c = {.fd = -1, .context = &replay};
+
+	MPU6050_CaptureReplayInit(&replay, data, size);
+	MPU6050_CaptureApplyHeader(&replay.reader.header, &config);
+	config.hi2c = &hi2c;
+	config.transport = &MPU6050_CaptureReplayTransport; */
+
+#define MPU6050_CAPTURE_REPLAY_REGS		128
+
+typedef struct {
+	MPU6050_CaptureReader reader;
+	uint8_t regs[MPU6050_CAPTURE_REPLAY_REGS];
+	MPU6050_CaptureFrame next;			// Frame returned by the next sensor read
+	uint8_t nextValid;
+} MPU6050_CaptureReplay;
+
+extern const MPU6050_Transport MPU6050_CaptureReplayTransport;
+
+uint8_t MPU6050_CaptureReplayInit(MPU6050_CaptureReplay *replay, const uint8_t *data, size_t size);
+uint32_t MPU6050_CaptureReplayNextTimestampUs(MPU6050_CaptureReplay *replay);
+
+const uint8_t *MPU6050_CaptureMapFile(const char *path, size_t *size);
+void MPU6050_CaptureUnmapFile(const uint8_t *data, size_t size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_CAPTURE */
@@ -0,0 +1,142 @@
+/*
+ * MPU6050_FILTER.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_FILTER
+#define MPU6050_FILTER
+
+#include "MPU6050_LIB.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: Streaming filter bank for the sample stream, sharper than the on-chip DLPF and
+	without changing the output rate of the sensor. Every channel (axis) has its own chain
+	of cascaded biquads (low-pass, notch...), then all the channels go through the same
+	polyphase FIR decimator, which only computes the samples it keeps. Blocks of any length
+	(FIFO batches) can be fed: the state carries over and the output is the same as one
+	sample at a time.
+
+	The arithmetic follows MPU6050_CONVERSION:
+	(i) Float: samples in the converted units. Transposed direct form II biquads.
+	(ii) Fixed point: raw samples (Q15 of the full scale). Direct form I biquads with Q30
+	coefficients, Q31 data (1 bit of headroom) and 64-bit accumulators, Q15 FIR taps.
+	Coefficients are given in float and quantized by MPU6050_FilterInit.
+
+	Kernels, selected at compile time:
+	(i) CMSIS-DSP when MPU6050_USE_CMSIS_DSP is defined (arm_biquad_cascade_df2T_f32,
+	arm_biquad_cascade_df1_q31, arm_dot_prod_f32/q15)
+	(ii) SSE2 on the host: float biquads run 4 channels per instruction, FIR dot products
+	with SSE2 or AVX2 (NEON for the FIR dot products on ARM hosts)
+	(iii) Portable scalar loops otherwise */
+
+// Parameters and constants
+#define MPU6050_FILTER_MAX_CHANNELS		7		// AX AY AZ T GX GY GZ when fed with frames
+#ifndef MPU6050_FILTER_MAX_STAGES
+#define MPU6050_FILTER_MAX_STAGES		4		// Biquads per channel
+#endif
+#ifndef MPU6050_FILTER_MAX_TAPS
+#define MPU6050_FILTER_MAX_TAPS			64
+#endif
+#define MPU6050_FILTER_BLOCK			32		// Samples per pass (stack and decimator history)
+#define MPU6050_FILTER_POST_SHIFT		1		// Fixed-point biquad coefficients in Q30 (range +-2)
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+typedef int16_t MPU6050_FilterData;		// Raw LSB
+#else
+typedef float MPU6050_FilterData;		// Converted units
+#endif
+
+// Biquad coefficients, CMSIS-DSP signs: y = b0 x + b1 x[-1] + b2 x[-2] + a1 y[-1] + a2 y[-2]
+typedef struct {
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+} MPU6050_Biquad;
+
+// Chain of one channel
+typedef struct {
+	uint8_t numStages;
+	const MPU6050_Biquad *stages;
+} MPU6050_FilterAxis;
+
+typedef struct {
+	uint8_t numChannels;
+	MPU6050_FilterAxis axis[MPU6050_FILTER_MAX_CHANNELS];
+	uint8_t decimation;						// Output one sample every decimation inputs (0 or 1: all)
+	uint8_t numTaps;						// FIR after the biquads, shared by all the channels (0: none)
+	const float *taps;
+} MPU6050_FilterConfig;
+
+// Filter bank state
+typedef struct {
+	uint8_t numChannels;
+	uint8_t numStages[MPU6050_FILTER_MAX_CHANNELS];
+	uint8_t maxStages;
+	uint8_t decimation;
+	uint8_t numTaps;
+	uint8_t phase;							// Inputs since the last output
+
+	// Unused stages hold a pass-through biquad
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+	int32_t coeffs[MPU6050_FILTER_MAX_CHANNELS][5 * MPU6050_FILTER_MAX_STAGES];	// Q30
+	int32_t state[MPU6050_FILTER_MAX_CHANNELS][4 * MPU6050_FILTER_MAX_STAGES];	// x[-1] x[-2] y[-1] y[-2]
+	int16_t taps[MPU6050_FILTER_MAX_TAPS];	// Q15, reversed
+#else
+	float coeffs[MPU6050_FILTER_MAX_CHANNELS][5 * MPU6050_FILTER_MAX_STAGES];
+	float state[MPU6050_FILTER_MAX_CHANNELS][2 * MPU6050_FILTER_MAX_STAGES];
+	float taps[MPU6050_FILTER_MAX_TAPS];	// Reversed
+#endif
+	MPU6050_FilterData history[MPU6050_FILTER_MAX_CHANNELS][MPU6050_FILTER_MAX_TAPS - 1 + MPU6050_FILTER_BLOCK];
+} MPU6050_FilterBank;
+
+// Errors enumeration
+typedef enum {
+	FILTER_OK = 0,
+	ERR_FILTER_CONFIG					// Too many channels, stages or taps
+} FilterError;
+
+// FUNCTIONS PROTOTYPES
+void MPU6050_FilterDesignLowpass(MPU6050_Biquad *stage, float cutoffHz, float sampleRateHz, float q);
+void MPU6050_FilterDesignNotch(MPU6050_Biquad *stage, float centerHz, float sampleRateHz, float q);
+uint8_t MPU6050_FilterDesignButterworth(MPU6050_Biquad *stages, uint8_t order, float cutoffHz, float sampleRateHz);
+void MPU6050_FilterDesignDecimator(float *taps, uint8_t numTaps, uint8_t decimation);
+
+uint8_t MPU6050_FilterInit(MPU6050_FilterBank *bank, const MPU6050_FilterConfig *filterConfig);
+void MPU6050_FilterReset(MPU6050_FilterBank *bank);
+uint32_t MPU6050_FilterProcess(MPU6050_FilterBank *bank, MPU6050_FilterData *const data[], uint32_t numSamples);
+uint32_t MPU6050_FilterFrames(MPU6050_FilterBank *bank, MPU6050_ConfigTypeDef *config, const uint8_t *frames, uint32_t numFrames, MPU6050_FilterData *const out[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_FILTER */
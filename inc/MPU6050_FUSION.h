@@ -0,0 +1,133 @@
+/*
+ * MPU6050_FUSION.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_FUSION
+#define MPU6050_FUSION
+
+#include "MPU6050_LIB.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: Attitude estimation from accelerometer and gyroscope samples (no magnetometer,
+	the yaw is only integrated). Samples come from any read path (burst, asynchronous
+	reader, FIFO) through MPU6050_FusionUpdate (timestamp in us) or MPU6050_FusionUpdateDt.
+	Selectable filter:
+	(i) FUSION_MAHONY: PI feedback of the tilt error (gains Kp, Ki)
+	(ii) FUSION_MADGWICK: gradient descent step of the tilt error (gain beta)
+	(iii) FUSION_COMPLEMENTARY: gyro integration corrected by a fixed fraction (alpha)
+	of the tilt error every update
+
+	The arithmetic follows MPU6050_CONVERSION: float, or Q30 integers with no float
+	operation per update (quaternion in Q30, Euler angles and linear acceleration in the
+	converted units). Every update has a fixed cost: no data dependent loop besides a
+	32-step integer square root in fixed point. */
+
+// Filters
+typedef enum {
+	FUSION_MAHONY = 0,
+	FUSION_MADGWICK,
+	FUSION_COMPLEMENTARY
+} MPU6050_FusionAlgorithm;
+
+typedef enum {
+	FUSION_OK = 0,
+	ERR_FUSION_NO_GRAVITY			// Null acceleration, gyroscope integration only
+} MPU6050_FusionError;
+
+// Parameters and constants
+#define MPU6050_FUSION_MAHONY_KP		1.0f	// rad/s per unit of tilt error
+#define MPU6050_FUSION_MAHONY_KI		0.0f	// rad/s^2 per unit of tilt error
+#define MPU6050_FUSION_MADGWICK_BETA	0.1f	// rad/s
+#define MPU6050_FUSION_COMPLEMENTARY_ALPHA	0.002f	// Fraction of the tilt error corrected per update
+#define MPU6050_FUSION_MAX_DT_US		100000	// Longer gaps are integrated as this
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+#define MPU6050_FUSION_Q				30
+typedef int32_t MPU6050_FusionReal;		// Q30
+typedef int32_t MPU6050_FusionGain;		// Q16
+#else
+typedef float MPU6050_FusionReal;
+typedef float MPU6050_FusionGain;
+#endif
+
+// Unit quaternion, body to earth frame (Z up)
+typedef struct {
+	MPU6050_FusionReal w;
+	MPU6050_FusionReal x;
+	MPU6050_FusionReal y;
+	MPU6050_FusionReal z;
+} MPU6050_Quaternion;
+
+// Euler angles (ZYX), in the gyroscope units (º or rad, milli-units in fixed point)
+typedef struct {
+	MPU6050_ConvertedData roll;
+	MPU6050_ConvertedData pitch;
+	MPU6050_ConvertedData yaw;
+} MPU6050_Euler;
+
+// Gravity-free acceleration in the body frame, in the accelerometer units (m/s^2 or mg)
+typedef struct {
+	MPU6050_ConvertedData x;
+	MPU6050_ConvertedData y;
+	MPU6050_ConvertedData z;
+} MPU6050_LinearAccel;
+
+// Filter state
+typedef struct {
+	uint8_t algorithm;				// MPU6050_FusionAlgorithm
+	uint8_t initialized;			// Attitude taken from the first accelerometer sample
+	uint32_t lastTimestampUs;
+	uint32_t updates;
+
+	MPU6050_Quaternion q;
+	MPU6050_FusionReal integral[3];	// Mahony integral term (rad/s)
+
+	MPU6050_FusionGain gain;		// Kp, beta or alpha
+	MPU6050_FusionGain integralGain;	// Ki
+} MPU6050_Fusion;
+
+// FUNCTIONS PROTOTYPES
+void MPU6050_FusionInit(MPU6050_Fusion *fusion, uint8_t algorithm);
+void MPU6050_FusionSetGains(MPU6050_Fusion *fusion, float gain, float integralGain);
+void MPU6050_FusionReset(MPU6050_Fusion *fusion);
+
+uint8_t MPU6050_FusionUpdate(MPU6050_Fusion *fusion, const MPU6050_Accelerations *accel, const MPU6050_Rotations *rota, uint32_t timestampUs);
+uint8_t MPU6050_FusionUpdateDt(MPU6050_Fusion *fusion, const MPU6050_Accelerations *accel, const MPU6050_Rotations *rota, uint32_t dtUs);
+
+void MPU6050_FusionGetQuaternion(MPU6050_Fusion *fusion, MPU6050_Quaternion *q);
+void MPU6050_FusionGetEuler(MPU6050_Fusion *fusion, MPU6050_Euler *euler);
+void MPU6050_FusionGetLinearAccel(MPU6050_Fusion *fusion, const MPU6050_Accelerations *accel, MPU6050_LinearAccel *linAccel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_FUSION */
@@ -30,6 +30,15 @@
 #define MPU6050_LIB
 
 #include <stdint.h>
+#include <stddef.h>
+
+#define MPU6050_TRANSPORT_STM32_HAL	0	// STM32 HAL I2C (HAL_I2C_Mem_Read/Write)
+#define MPU6050_TRANSPORT_LINUX		1	// Linux /dev/i2c-N through the I2C_RDWR ioctl
+#ifndef MPU6050_TRANSPORT
+#define MPU6050_TRANSPORT			MPU6050_TRANSPORT_STM32_HAL
+#endif
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_STM32_HAL
 
 #define STM32_FAMILY 4  // Change this value to toggle between the different families
 
@@ -50,10 +59,126 @@
   #error "Invalid STM32 family selection"
 #endif
 
+#elif MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+  #include "MPU6050_LINUX.h"	// I2C_HandleTypeDef, HAL_StatusTypeDef and HAL_GetTick for Linux
+#else
+  #error "Invalid MPU6050 transport selection"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Register block of a batched read
+typedef struct {
+	uint8_t reg;
+	uint8_t *data;
+	uint16_t len;
+} MPU6050_RegBlock;
+
+// Bus transport (addresses are 7-bit, every function returns the HAL status of the transfer)
+typedef struct {
+	HAL_StatusTypeDef (*read)(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len);
+	HAL_StatusTypeDef (*write)(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len);
+	// Optional: several register reads in one bus operation (NULL = one read per block)
+	HAL_StatusTypeDef (*readBlocks)(I2C_HandleTypeDef *hi2c, uint8_t address, MPU6050_RegBlock *blocks, uint8_t numBlocks);
+	// Optional: non-blocking read, completion reported through MPU6050_AsyncComplete (NULL = blocking fallback)
+	HAL_StatusTypeDef (*startRead)(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len);
+} MPU6050_Transport;
+
+// Monotonic microsecond clock supplied by the application (e.g. a free running timer)
+typedef uint32_t (*MPU6050_ClockFn)(void);
+
+#define MPU6050_CONVERSION_FLOAT	0	// Converted data in float (m/s^2, º/s or rad/s, ºC)
+#define MPU6050_CONVERSION_FIXED	1	// Converted data in int32_t (mg, mdps or mrad/s, centi-ºC), for FPU-less targets
+#ifndef MPU6050_CONVERSION
+#define MPU6050_CONVERSION			MPU6050_CONVERSION_FLOAT
+#endif
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+typedef int32_t MPU6050_ConvertedData;
+#else
+typedef float MPU6050_ConvertedData;
+#endif
+
+#ifndef MPU6050_STATS
+#define MPU6050_STATS				0	// 1 adds bus counters and latency histograms per device (MPU6050_StatsInit)
+#endif
+
+// Timed functions (MPU6050_Stats.api), also the api argument of MPU6050_CallEnd
+typedef enum {
+	STATS_BUS = 0,					// Every blocking transfer, inside the calls below
+	STATS_ASYNC,					// MPU6050_AsyncStart to MPU6050_AsyncComplete
+	STATS_INIT,
+	STATS_CHECK_CONN,
+	STATS_GET_ACCEL,
+	STATS_GET_ROTA,
+	STATS_GET_TEMP,
+	STATS_GET_ALL,
+	STATS_GET_ALL_EXT,
+	STATS_INT_STATUS,
+	STATS_FIFO_COUNT,
+	STATS_FIFO_DRAIN,
+	STATS_AUX_READ,
+	STATS_AUX_WRITE,
+	STATS_CALIB_ACCEL,
+	STATS_CALIB_GYRO,
+	STATS_NUM_APIS
+} MPU6050_StatsApi;
+
+#if MPU6050_STATS
+
+// Tick source of the latency histograms. Define both macros to use another counter
+#ifndef MPU6050_STATS_TICKS
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+#define MPU6050_STATS_TICKS()		MPU6050_LinuxGetNs()	// CLOCK_MONOTONIC
+#define MPU6050_STATS_TICKS_HZ		1000000000u
+#elif defined(DWT_CTRL_CYCCNTENA_Msk)
+#define MPU6050_STATS_TICKS()		(DWT->CYCCNT)			// Core cycles, enabled by MPU6050_StatsInit
+#define MPU6050_STATS_TICKS_HZ		SystemCoreClock
+#define MPU6050_STATS_DWT			1
+#else
+#define MPU6050_STATS_TICKS()		HAL_GetTick()
+#define MPU6050_STATS_TICKS_HZ		1000u
+#endif
+#endif
+
+#ifndef MPU6050_STATS_BUCKETS
+#define MPU6050_STATS_BUCKETS		32		// Bucket n counts durations of 2^(n-1)..2^n - 1 ticks, the last one everything longer
+#endif
+#define MPU6050_STATS_STATUSES		4		// HAL_OK, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT
+
+// Latency of one timed function, in MPU6050_STATS_TICKS
+typedef struct {
+	uint32_t calls;
+	uint32_t errors;				// Calls that returned an error code (failed transfers for STATS_BUS and STATS_ASYNC)
+	uint32_t minTicks;
+	uint32_t maxTicks;
+	uint64_t totalTicks;
+	uint32_t histogram[MPU6050_STATS_BUCKETS];
+} MPU6050_ApiStats;
+
+// Instrumentation of one device
+typedef struct {
+	uint32_t transfers;				// Bus transactions, a transport readBlocks call is one
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t bytesRead;				// Successful transfers only
+	uint32_t bytesWritten;
+	uint32_t status[MPU6050_STATS_STATUSES];	// Transfers per HAL_StatusTypeDef, status[HAL_TIMEOUT] are the timeouts
+	uint32_t connLost;				// Transitions to CONN_STATE_LOST
+	uint32_t reconnects;			// Recoveries from CONN_STATE_LOST
+	uint32_t ticksHz;				// MPU6050_STATS_TICKS_HZ, filled by MPU6050_StatsSnapshot
+	MPU6050_ApiStats api[STATS_NUM_APIS];
+} MPU6050_Stats;
+
+#endif
+
 // MPU6050 Configuration structure
 typedef struct {
     I2C_HandleTypeDef *hi2c;		// I2C interface used
     uint8_t address;				// I2C address chosen
+    const MPU6050_Transport *transport;	// NULL uses the transport selected by MPU6050_TRANSPORT
 
     								// Registers written with these values
     uint8_t dlpfFsyncConfig;		// REG_CONFIG
@@ -62,17 +187,80 @@ typedef struct {
     uint8_t pwrMgmt2Config;			// REG_PWR_MGMT_2
     uint8_t accelConfig;			// REG_ACCEL_CONFIG
     uint8_t gyroConfig;				// REG_GYRI_CONFIG
+    								// The copies below are cleared by MPU6050_Init, whose reset clears the registers
+    uint8_t fifoEnConfig;			// REG_FIFO_EN (written by MPU6050_FifoEnable)
+    uint8_t intPinConfig;			// REG_INT_PIN_CFG (written by MPU6050_ConfigInterrupts)
+    uint8_t intEnableConfig;		// REG_INT_ENABLE (written by MPU6050_ConfigInterrupts)
+
+    								// Auxiliary I2C master (written by MPU6050_AuxEnable and MPU6050_AuxConfigSlave)
+    uint8_t auxEnabled;
+    uint8_t i2cMstCtrlConfig;		// REG_I2C_MST_CTRL
+    uint8_t i2cSlvConfig[4][3];		// REG_I2C_SLVx_ADDR, REG_I2C_SLVx_REG, REG_I2C_SLVx_CTRL of slaves 0..3
+    uint8_t i2cSlvDoConfig[4];		// REG_I2C_SLVx_DO of slaves 0..3
+    uint8_t i2cSlv4CtrlConfig;		// REG_I2C_SLV4_CTRL (I2C_MST_DLY)
+    uint8_t i2cMstDelayCtrlConfig;	// REG_I2C_MST_DELAY_CTRL
+
+    								// Motion detection and cycle mode (written by MPU6050_ConfigMotion and MPU6050_EnterCycleMode)
+    uint8_t motThrConfig;			// REG_MOT_THR
+    uint8_t motDurConfig;			// REG_MOT_DUR
+    uint8_t motDetectCtrlConfig;	// REG_MOT_DETECT_CTRL
+    uint8_t cycleMode;				// TRUE in accelerometer-only cycle mode, the registers above keep the active values
+    uint8_t lpWakeCtrlConfig;		// LP_WAKE_CTRL of the cycle mode
+    uint8_t cycleIntEnableConfig;	// REG_INT_ENABLE in cycle mode
+    volatile uint8_t intStatusPending;	// MOT_INT cleared by another INT_STATUS read, for MPU6050_PowerUpdate
+
+    								// Offsets (written by MPU6050_SetAccelOffset, MPU6050_SetGyroOffset and the calibration)
+    uint8_t accelOffSet;			// TRUE once accelOffConfig was written
+    uint8_t gyroOffSet;				// TRUE once gyroOffConfig was written
+    int16_t accelOffConfig[3];		// REG_XA_OFFS_USRH..REG_ZA_OFFS_USRL
+    int16_t gyroOffConfig[3];		// REG_XG_OFFS_USRH..REG_ZG_OFFS_USRL
+
+    uint32_t probeIntervalMs;		// Periodic WHO_AM_I probe while connected (0 = only after errors)
+    MPU6050_ClockFn clock;			// Sample timestamps (NULL uses HAL_GetTick() * 1000)
+
+    								// Connection health (managed by the library)
+    uint8_t connState;				// MPU6050_ConnState
+    uint8_t errorCount;				// Consecutive failed transfers
+    uint32_t lastProbeTick;			// HAL_GetTick() of the last WHO_AM_I probe
+#if MPU6050_STATS
+    MPU6050_Stats *stats;			// Set by MPU6050_StatsInit (NULL = not collected)
+#endif
+
+    								// Conversion factors (managed by the library)
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+    int32_t accelScale;				// mg per LSB in Q16
+    int32_t gyroScale;				// mdps or mrad/s per LSB in Q16 (MPU6050_GYRO_UNITS)
+#else
+    float accelScale;				// m/s^2 per LSB
+    float gyroScale;				// º/s or rad/s per LSB (MPU6050_GYRO_UNITS)
+#endif
+    uint8_t scaleAccelConfig;		// accelConfig the factors were computed from
+    uint8_t scaleGyroConfig;		// gyroConfig the factors were computed from
+    uint8_t scaleValid;
 } MPU6050_ConfigTypeDef;
 
+// Named set of configuration registers, switched with MPU6050_ApplyProfile
+typedef struct {
+	const char *name;
+	uint8_t dlpfFsyncConfig;		// REG_CONFIG
+	uint8_t smplRateDivConfig;		// REG_SMPLRT_DIV
+	uint8_t pwrMgmt1Config;			// REG_PWR_MGMT_1
+	uint8_t pwrMgmt2Config;			// REG_PWR_MGMT_2
+	uint8_t accelConfig;			// REG_ACCEL_CONFIG
+	uint8_t gyroConfig;				// REG_GYRO_CONFIG
+} MPU6050_Profile;
+
 // MPU6050 Acceleration Data structure
 typedef struct {
 	int16_t rawAccelX;
 	int16_t rawAccelY;
 	int16_t rawAccelZ;
 
-	float convertedAccelX;
-	float convertedAccelY;
-	float convertedAccelZ;
+	MPU6050_ConvertedData convertedAccelX;
+	MPU6050_ConvertedData convertedAccelY;
+	MPU6050_ConvertedData convertedAccelZ;
+
+	uint32_t timestampUs;			// Clock at the start of the read (FIFO: reconstructed sample time)
 } MPU6050_Accelerations;
 
 // MPU6050 Gyroscope Data structure
@@ -81,18 +269,65 @@ typedef struct {
 	int16_t rawRotaY;
 	int16_t rawRotaZ;
 
-	float convertedRotaX;
-	float convertedRotaY;
-	float convertedRotaZ;
+	MPU6050_ConvertedData convertedRotaX;
+	MPU6050_ConvertedData convertedRotaY;
+	MPU6050_ConvertedData convertedRotaZ;
+
+	uint32_t timestampUs;
 } MPU6050_Rotations;
 
 // MPU6050 Temperature Data structure
 
 typedef struct {
 	int16_t rawTemp;
-	float convertedTemp;
+	MPU6050_ConvertedData convertedTemp;
+	uint32_t timestampUs;
 } MPU6050_Temperature;
 
+#ifndef MPU6050_FIFO_EXT_LEN
+#define MPU6050_FIFO_EXT_LEN		0		// EXT_SENS_DATA bytes kept per FIFO sample (0..24)
+#endif
+
+// MPU6050 FIFO sample structure (only the sensors enabled in fifoEnConfig are filled)
+typedef struct {
+	MPU6050_Accelerations accel;
+	MPU6050_Rotations rota;
+	MPU6050_Temperature temp;
+#if MPU6050_FIFO_EXT_LEN > 0
+	uint8_t extData[MPU6050_FIFO_EXT_LEN];	// Auxiliary slaves loaded into the FIFO, in slave order
+#endif
+} MPU6050_FifoSample;
+
+// Auxiliary I2C slave channel (0..3), accessed by the MPU6050 at every sample
+typedef struct {
+	uint8_t address;				// 7-bit address on the auxiliary bus
+	uint8_t reg;					// First register accessed
+	uint8_t len;					// Bytes read into EXT_SENS_DATA (1..15), 1 for a write
+	uint8_t write;					// TRUE: writes dataOut every sample (e.g. a conversion trigger)
+	uint8_t dataOut;
+	uint8_t flags;					// I2C_SLV_BYTE_SW / REG_DIS / GRP_CONFIG_SET
+	uint8_t delayed;				// TRUE: accessed once every 1 + I2C_MST_DLY samples
+} MPU6050_AuxSlave;
+
+// MPU6050 FIFO ring buffer (storage owned by the caller)
+typedef struct {
+	MPU6050_FifoSample *samples;	// Caller-owned array of 'size' samples
+	uint16_t size;
+	uint16_t head;					// Next slot written by MPU6050_FifoDrain
+	uint16_t tail;					// Next slot read by MPU6050_FifoPop
+	uint16_t count;
+	uint32_t overflows;				// Sensor FIFO overflows detected
+
+									// Sample time reconstruction (managed by the library)
+	uint32_t periodQ8;				// Estimated sample period in 1/256 us (0 = resynchronize on the next drain)
+	uint32_t nominalPeriodUs;		// Period given by REG_SMPLRT_DIV and the DLPF
+	uint32_t streamIndex;			// Frames drained since the last resynchronization
+	uint32_t lastTimestampUs;		// Time of the last frame drained
+	uint8_t lastTimestampFrac;		// 1/256 us
+	uint32_t refTimestampUs;		// Start of the period estimation window
+	uint32_t refIndex;
+} MPU6050_FifoRing;
+
 // MPU6050 Accelerometer Offset structure
 typedef struct {
     int16_t xOffset;
@@ -110,12 +345,14 @@ typedef struct {
 // Errors enumeration
 typedef enum {
     INIT_OK = 0,
-    ERR_INIT_0,
-    ERR_INIT_1,
-    ERR_INIT_2,
-    ERR_INIT_3,
-    ERR_INIT_4,
-    ERR_INIT_5,
+    ERR_INIT_0 = 0x01,			// Mismatch bits, several can be set
+    ERR_INIT_1 = 0x02,
+    ERR_INIT_2 = 0x04,
+    ERR_INIT_3 = 0x08,
+    ERR_INIT_4 = 0x10,
+    ERR_INIT_5 = 0x20,
+    ERR_INIT_RESET = 0x40,		// DEVICE_RESET did not complete
+    ERR_INIT_CONN = 0x80		// Transfer failed
 } InitializationError;
 
 typedef enum {
@@ -123,11 +360,20 @@ typedef enum {
 	ERR_CONN_0
 } ConnectionError;
 
+typedef enum {
+	CONN_STATE_CONNECTED = 0,		// Last transfers succeeded
+	CONN_STATE_DEGRADED,			// Transfers failed, WHO_AM_I is probed before the next access
+	CONN_STATE_LOST					// Too many failures, the device is re-initialized once it answers again
+} MPU6050_ConnState;
+
 typedef enum {
 	CONFIG_OK = 0,
 	ERR_CONFIG_ACCEL = 2,
 	ERR_CONFIG_GYRO,
-	ERR_TEMP_DISABLED
+	ERR_TEMP_DISABLED,
+	ERR_CONFIG_INVALID,				// Value outside the field
+	ERR_CONFIG_CONN,
+	ERR_CONFIG_CYCLE_MODE			// Leave the cycle mode first (MPU6050_ExitCycleMode)
 } ConfigurationError;
 
 typedef enum {
@@ -137,15 +383,77 @@ typedef enum {
 	ERR_WRITE_OFF_Y_L,
 	ERR_WRITE_OFF_Y_H,
 	ERR_WRITE_OFF_Z_L,
-	ERR_WRITE_OFF_Z_H
+	ERR_WRITE_OFF_Z_H,
+	ERR_WRITE_CONN
 } WritingError;
 
 typedef enum {
 	CALIB_OK,
 	CALIB_TIMEOUT,
-	ERR_CALIB_INVALID_TOLERANCE
+	ERR_CALIB_INVALID_TOLERANCE,
+	ERR_CALIB_INVALID_AXIS,
+	ERR_CALIB_CONN
 } CalibrationError;
 
+// Axis aligned with gravity during the accelerometer calibration
+typedef enum {
+	GRAVITY_AXIS_X_POS = 0,
+	GRAVITY_AXIS_X_NEG,
+	GRAVITY_AXIS_Y_POS,
+	GRAVITY_AXIS_Y_NEG,
+	GRAVITY_AXIS_Z_POS,			// Lying flat, face up
+	GRAVITY_AXIS_Z_NEG
+} MPU6050_GravityAxis;
+
+typedef enum {
+	FIFO_OK = 0,
+	ERR_FIFO_CONN,
+	ERR_FIFO_OVERFLOW,
+	ERR_FIFO_NOT_CONFIGURED,
+	ERR_FIFO_EMPTY
+} FifoError;
+
+typedef enum {
+	ASYNC_OK = 0,
+	ERR_ASYNC_CONN,
+	ERR_ASYNC_BUSY,
+	ERR_ASYNC_NO_DATA
+} AsyncError;
+
+typedef enum {
+	INT_OK = 0,
+	ERR_INT_CONN,
+	ERR_INT_VERIFY,
+	ERR_INT_NO_NEW_SAMPLE,
+	ERR_INT_BLOCKING_READER					// The reader cannot start a non-blocking read
+} InterruptError;
+
+typedef enum {
+	AUX_OK = 0,
+	ERR_AUX_CONN,
+	ERR_AUX_INVALID,				// Slave number, length or delay out of range
+	ERR_AUX_NACK,					// The auxiliary device did not acknowledge
+	ERR_AUX_TIMEOUT					// The single transfer did not complete
+} AuxError;
+
+typedef enum {
+	POWER_OK = 0,
+	ERR_POWER_CONN,
+	ERR_POWER_INVALID				// Wake-up rate out of range or motion detection not configured
+} PowerError;
+
+#if MPU6050_STATS
+typedef enum {
+	STATS_OK = 0,
+	ERR_STATS_DISABLED						// MPU6050_StatsInit not called for this device
+} StatsError;
+#endif
+
+typedef enum {
+	POWER_MODE_ACTIVE = 0,			// Sampling at the configured rate
+	POWER_MODE_CYCLE				// Accelerometer only, woken at LP_WAKE_CTRL
+} MPU6050_PowerMode;
+
 // Parameters and constants
 #define TRUE						1
 #define FALSE						0
@@ -166,22 +474,93 @@ typedef enum {
 
 #define GET_GYRO_FS_CONFIG			0b00011000	// BitMask to get GFS bits
 
+#define ACCEL_OFFSET_LSB_SEN		2048	// LSB/g of XA/YA/ZA_OFFS_USR (+-16g format)
+#define GYRO_OFFSET_LSB_SEN			32.8f	// LSB/º/S of XG/YG/ZG_OFFS_USR (+-1000º/s format)
+
+#define GET_DLPF_CONFIG				0b00000111	// BitMask to get DLPF_CFG bits
+#define GET_CLKSEL_CONFIG			0b00000111	// BitMask to get CLKSEL bits
+#define GET_STBY_CONFIG				0b00111111	// BitMask to get STBY_XA..STBY_ZG bits
+#define GET_LP_WAKE_CTRL_CONFIG		0b11000000	// BitMask to get LP_WAKE_CTRL bits
+#define GET_ACCEL_HPF_CONFIG		0b00000111	// BitMask to get ACCEL_HPF bits
+#define GYRO_OUTPUT_RATE_HZ_DLPF_OFF	8000	// DLPF_CFG = 0 or 7
+#define GYRO_OUTPUT_RATE_HZ_DLPF_ON		1000	// DLPF_CFG = 1..6
+
+#define FS_CONFIG_SHIFT				3			// AFS/GFS bits position
+
+#define DEG_TO_RAD					0.017453292519943295f
+
+#define MPU6050_GYRO_DPS			0	// Converted rotations in º/s
+#define MPU6050_GYRO_RADS			1	// Converted rotations in rad/s
+#ifndef MPU6050_GYRO_UNITS
+#define MPU6050_GYRO_UNITS			MPU6050_GYRO_DPS
+#endif
+
 #define LOW_BYTE_MASK 				0xFF
 #define HIGH_BYTE_MASK 				0xFF00
 
+#define MPU6050_SENSORS_BURST_LEN	14		// REG_ACCEL_XOUT_H..REG_GYRO_ZOUT_L
+#define MPU6050_INT_BURST_LEN		15		// REG_INT_STATUS..REG_GYRO_ZOUT_L
+
+#define MPU6050_FIFO_SIZE			1024	// Bytes
+#define MPU6050_FIFO_CHUNK_LEN		252		// Max bytes per FIFO burst read (multiple of 6, 12 and 14)
+
+#define MPU6050_FIFO_TS_MIN_WINDOW	64		// Frames before the measured period replaces the nominal one
+#define MPU6050_FIFO_TS_MAX_WINDOW	4096	// Frames after which the oldest half of the window is dropped
+#define MPU6050_FIFO_TS_MAX_DRIFT	16		// Measured period limited to nominal +-nominal/16
+#define MPU6050_FIFO_TS_PHASE_GAIN	8		// Drains to correct the phase of the newest frame
+
+// EXT_SENS_DATA packs the read slaves in slave order, disabled and write slaves take no room.
+// MPU6050_AuxConfigSlave rejects more than MPU6050_EXT_SENS_DATA_LEN bytes in total, so the burst
+// buffer of MPU6050_GetAllSensorsExt has a fixed worst-case size but only the enabled bytes are read
+#define MPU6050_AUX_SLAVES			4		// Slaves 0..3 read into EXT_SENS_DATA
+#define MPU6050_EXT_SENS_DATA_LEN	24		// REG_EXT_SENS_DATA_00..23
+#define MPU6050_AUX_TIMEOUT_MS		300		// Single transfers run at the next sample (>= 3.9Hz)
+
+#define MPU6050_MOT_THR_MG			2		// mg per LSB of MOT_THR
+#define MPU6050_MOT_DUR_MS			1		// ms per LSB of MOT_DUR (1 kHz accelerometer rate)
+
+#define TEMP_LSB_SEN				340.0f	// LSB/ºC
+#define TEMP_OFFSET					36.53f	// ºC
+#define TEMP_OFFSET_CENTI			3653	// centi-ºC
+
+#define MPU6050_FIXED_SHIFT			16		// Fractional bits of the fixed-point factors
+
 /********END OF PARAMETERS AND CONSTANTS*********/
 
 // Definitions of configuration values
 
 // Calibration Configuration
-#define ACCEL_MAX_CALIB_ITERATIONS 	1000
-#define ACCEL_NUM_CALIB_READINGS	100
+#define ACCEL_MAX_CALIB_ITERATIONS 	8		// Bias measurement and correction steps
+#define ACCEL_NUM_CALIB_READINGS	100		// Burst reads averaged per step
 
-#define GYRO_MAX_CALIB_ITERATIONS 	1000
+#define GYRO_MAX_CALIB_ITERATIONS 	8
 #define GYRO_NUM_CALIB_READINGS		100
 
 // I2C Configuration
 #define MPU6050_TIMEOUT_MS		100
+#define MPU6050_RESET_TIMEOUT_MS	100		// Max DEVICE_RESET duration
+
+#define MPU6050_WHO_AM_I_VALUE	0x68	// Independent of AD0
+#define MPU6050_LOST_ERRORS		3		// Consecutive failed transfers before CONN_STATE_LOST
+
+#ifndef MPU6050_OFFSET_VERIFY
+#define MPU6050_OFFSET_VERIFY	TRUE	// Offset setters read the written block back
+#endif
+
+#define MPU6050_ASYNC_DMA		0
+#define MPU6050_ASYNC_IT		1
+#ifndef MPU6050_ASYNC_MODE
+#define MPU6050_ASYNC_MODE		MPU6050_ASYNC_DMA	// HAL backend used by the asynchronous reader
+#endif
+
+// Orders the sample buffers of the asynchronous reader against its sequence counter
+#ifndef MPU6050_MEMORY_BARRIER
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+#define MPU6050_MEMORY_BARRIER()	__atomic_thread_fence(__ATOMIC_SEQ_CST)	// Completions may run on another core
+#else
+#define MPU6050_MEMORY_BARRIER()	__DMB()
+#endif
+#endif
 
 // MPU6050 Configuration
 
@@ -216,6 +595,8 @@ typedef enum {
 
 // Configuration values for register REG_PWR_MGMT_1
 
+#define DEVICE_RESET_CONFIG_SET	0b10000000	// RESET ALL REGISTERS (SELF CLEARING)
+#define SLEEP_CONFIG_SET		0b01000000	// SLEEP MODE ENABLED (RESET VALUE)
 #define CYCLE_CONFIG_SET		0b00100000	// CYCLE MODE ENABLED
 #define TEMP_DIS_CONFIG_SET		0b00001000  // TEMP SENSOR DISABLED
 
@@ -241,7 +622,8 @@ typedef enum {
 	(i) Set CYCLE bit to 1
 	(ii) Set SLEEP bit to 0
 	(iii) Set TEMP_DIS bit to 1
-	(iv) Set STBY_XG, STBY_YG, STBY_ZG bits to 1 */
+	(iv) Set STBY_XG, STBY_YG, STBY_ZG bits to 1
+	MPU6050_EnterCycleMode and MPU6050_ExitCycleMode apply these steps */
 
 											// STANDBY MODE ENABLE
 #define STBY_XA_CONFIG_SET		0b00100000
@@ -266,6 +648,14 @@ typedef enum {
 #define ACCEL_CONFIG_STEST_Y	0b01000000
 #define ACCEL_CONFIG_STEST_Z	0b00100000
 
+											// ACCEL_HPF: HIGH-PASS FILTER OF THE MOTION DETECTION
+#define ACCEL_HPF_CONFIG_RESET	0b00000000	// OUTPUT SETTLES TO 0
+#define ACCEL_HPF_CONFIG_5HZ	0b00000001
+#define ACCEL_HPF_CONFIG_2_5HZ	0b00000010
+#define ACCEL_HPF_CONFIG_1_25HZ	0b00000011
+#define ACCEL_HPF_CONFIG_0_63HZ	0b00000100
+#define ACCEL_HPF_CONFIG_HOLD	0b00000111	// REFERENCE HELD AT THE CURRENT SAMPLE
+
 /*************END OF REG_ACCEL_CONFIG CONFIGURATION VALUES********************/
 
 // Configuration values for register REG_GYRO_CONFIG
@@ -282,6 +672,141 @@ typedef enum {
 
 /*************END OF REG_GYRO_CONFIG CONFIGURATION VALUES**********************/
 
+// Configuration values for register REG_FIFO_EN
+
+											// SENSOR DATA LOADED INTO THE FIFO
+#define TEMP_FIFO_EN_CONFIG_SET		0b10000000	// TEMP_OUT_H/L
+#define XG_FIFO_EN_CONFIG_SET		0b01000000	// GYRO_XOUT_H/L
+#define YG_FIFO_EN_CONFIG_SET		0b00100000	// GYRO_YOUT_H/L
+#define ZG_FIFO_EN_CONFIG_SET		0b00010000	// GYRO_ZOUT_H/L
+#define ACCEL_FIFO_EN_CONFIG_SET	0b00001000	// ACCEL_XOUT_H/L..ACCEL_ZOUT_H/L
+#define SLV2_FIFO_EN_CONFIG_SET		0b00000100	// EXT_SENS_DATA of slave 2
+#define SLV1_FIFO_EN_CONFIG_SET		0b00000010	// EXT_SENS_DATA of slave 1
+#define SLV0_FIFO_EN_CONFIG_SET		0b00000001	// EXT_SENS_DATA of slave 0
+
+/*************END OF REG_FIFO_EN CONFIGURATION VALUES**************************/
+
+// Configuration values for register REG_USER_CTRL
+
+#define FIFO_EN_CONFIG_SET			0b01000000	// FIFO ENABLED
+#define I2C_MST_EN_CONFIG_SET		0b00100000	// AUX I2C MASTER ENABLED
+#define I2C_IF_DIS_CONFIG_SET		0b00010000	// PRIMARY I2C DISABLED (MPU6000 ONLY)
+#define FIFO_RESET_CONFIG_SET		0b00000100	// RESET FIFO (SELF CLEARING)
+#define I2C_MST_RESET_CONFIG_SET	0b00000010	// RESET AUX I2C MASTER (SELF CLEARING)
+#define SIG_COND_RESET_CONFIG_SET	0b00000001	// RESET SIGNAL PATHS (SELF CLEARING)
+
+/*************END OF REG_USER_CTRL CONFIGURATION VALUES************************/
+
+// Configuration values for register REG_INT_PIN_CFG
+
+#define INT_LEVEL_CONFIG_SET		0b10000000	// INT PIN ACTIVE LOW
+#define INT_OPEN_CONFIG_SET			0b01000000	// INT PIN OPEN DRAIN
+#define LATCH_INT_EN_CONFIG_SET		0b00100000	// INT PIN HELD UNTIL CLEARED (50us PULSE OTHERWISE)
+#define INT_RD_CLEAR_CONFIG_SET		0b00010000	// ANY READ CLEARS THE STATUS (INT_STATUS READ OTHERWISE)
+#define FSYNC_INT_LEVEL_CONFIG_SET	0b00001000	// FSYNC ACTIVE LOW
+#define FSYNC_INT_EN_CONFIG_SET		0b00000100	// FSYNC USED AS INTERRUPT
+#define I2C_BYPASS_EN_CONFIG_SET	0b00000010	// AUX I2C BUS BYPASS
+
+/*************END OF REG_INT_PIN_CFG CONFIGURATION VALUES**********************/
+
+// Configuration values for register REG_INT_ENABLE
+
+#define MOT_EN_CONFIG_SET			0b01000000
+#define FIFO_OFLOW_EN_CONFIG_SET	0b00010000
+#define I2C_MST_INT_EN_CONFIG_SET	0b00001000
+#define DATA_RDY_EN_CONFIG_SET		0b00000001
+
+/*************END OF REG_INT_ENABLE CONFIGURATION VALUES***********************/
+
+// Flags of register REG_INT_STATUS (cleared on read)
+
+#define MOT_INT_FLAG				0b01000000
+#define FIFO_OFLOW_INT_FLAG			0b00010000
+#define I2C_MST_INT_FLAG			0b00001000
+#define DATA_RDY_INT_FLAG			0b00000001
+
+/*************END OF REG_INT_STATUS FLAGS**************************************/
+
+// Configuration values for register REG_MOT_DETECT_CTRL
+
+											// ACCELEROMETER POWER ON DELAY (ms, ADDED TO 4ms)
+#define ACCEL_ON_DELAY_CONFIG_0		0b00000000
+#define ACCEL_ON_DELAY_CONFIG_1		0b00010000
+#define ACCEL_ON_DELAY_CONFIG_2		0b00100000
+#define ACCEL_ON_DELAY_CONFIG_3		0b00110000
+
+											// MOTION COUNTER DECREMENT BELOW THE THRESHOLD
+#define MOT_COUNT_CONFIG_RESET		0b00000000	// COUNTER RESET
+#define MOT_COUNT_CONFIG_1			0b00000001
+#define MOT_COUNT_CONFIG_2			0b00000010
+#define MOT_COUNT_CONFIG_4			0b00000011
+
+/*************END OF REG_MOT_DETECT_CTRL CONFIGURATION VALUES******************/
+
+// Configuration values for register REG_I2C_MST_CTRL
+
+#define MULT_MST_EN_CONFIG_SET		0b10000000	// MULTI-MASTER AUXILIARY BUS
+#define WAIT_FOR_ES_CONFIG_SET		0b01000000	// DATA READY WAITS FOR EXT_SENS_DATA
+#define SLV3_FIFO_EN_CONFIG_SET		0b00100000	// EXT_SENS_DATA OF SLAVE 3 LOADED INTO THE FIFO
+#define I2C_MST_P_NSR_CONFIG_SET	0b00010000	// STOP BETWEEN SLAVE READS (RESTART OTHERWISE)
+
+											// AUXILIARY BUS CLOCK (kHz)
+#define I2C_MST_CLK_CONFIG_0		0b0000		// 348
+#define I2C_MST_CLK_CONFIG_1		0b0001		// 333
+#define I2C_MST_CLK_CONFIG_2		0b0010		// 320
+#define I2C_MST_CLK_CONFIG_3		0b0011		// 308
+#define I2C_MST_CLK_CONFIG_4		0b0100		// 296
+#define I2C_MST_CLK_CONFIG_5		0b0101		// 286
+#define I2C_MST_CLK_CONFIG_6		0b0110		// 276
+#define I2C_MST_CLK_CONFIG_7		0b0111		// 267
+#define I2C_MST_CLK_CONFIG_8		0b1000		// 258
+#define I2C_MST_CLK_CONFIG_9		0b1001		// 500
+#define I2C_MST_CLK_CONFIG_10		0b1010		// 471
+#define I2C_MST_CLK_CONFIG_11		0b1011		// 444
+#define I2C_MST_CLK_CONFIG_12		0b1100		// 421
+#define I2C_MST_CLK_CONFIG_13		0b1101		// 400
+#define I2C_MST_CLK_CONFIG_14		0b1110		// 381
+#define I2C_MST_CLK_CONFIG_15		0b1111		// 364
+
+/*************END OF REG_I2C_MST_CTRL CONFIGURATION VALUES*********************/
+
+// Configuration values for registers REG_I2C_SLVx_ADDR and REG_I2C_SLVx_CTRL
+
+#define I2C_SLV_RNW_CONFIG_SET		0b10000000	// ADDR: READ TRANSFER (WRITE OTHERWISE)
+#define I2C_SLV_EN_CONFIG_SET		0b10000000	// CTRL: SLAVE ENABLED
+#define I2C_SLV_BYTE_SW_CONFIG_SET	0b01000000	// CTRL: SWAP THE BYTES OF EVERY WORD
+#define I2C_SLV_REG_DIS_CONFIG_SET	0b00100000	// CTRL: NO REGISTER ADDRESS, DATA ONLY
+#define I2C_SLV_GRP_CONFIG_SET		0b00010000	// CTRL: WORDS START AT ODD REGISTERS
+#define GET_I2C_SLV_LEN_CONFIG		0b00001111	// BitMask to get I2C_SLVx_LEN bits
+#define I2C_SLV4_INT_EN_CONFIG_SET	0b01000000	// SLV4_CTRL: I2C_MST_INT WHEN THE TRANSFER ENDS
+#define GET_I2C_MST_DLY_CONFIG		0b00011111	// SLV4_CTRL: BitMask to get I2C_MST_DLY bits
+
+/*************END OF REG_I2C_SLVx CONFIGURATION VALUES*************************/
+
+// Configuration values for register REG_I2C_MST_DELAY_CTRL
+
+#define DELAY_ES_SHADOW_CONFIG_SET	0b10000000	// EXT_SENS_DATA UPDATED ONCE ALL SLAVES ARE READ
+#define I2C_SLV4_DLY_EN_CONFIG_SET	0b00010000	// SLAVE ACCESSED EVERY 1 + I2C_MST_DLY SAMPLES
+#define I2C_SLV3_DLY_EN_CONFIG_SET	0b00001000
+#define I2C_SLV2_DLY_EN_CONFIG_SET	0b00000100
+#define I2C_SLV1_DLY_EN_CONFIG_SET	0b00000010
+#define I2C_SLV0_DLY_EN_CONFIG_SET	0b00000001
+
+/*************END OF REG_I2C_MST_DELAY_CTRL CONFIGURATION VALUES***************/
+
+// Flags of register REG_I2C_MST_STATUS (cleared on read)
+
+#define PASS_THROUGH_FLAG			0b10000000	// FSYNC LEVEL
+#define I2C_SLV4_DONE_FLAG			0b01000000
+#define I2C_LOST_ARB_FLAG			0b00100000
+#define I2C_SLV4_NACK_FLAG			0b00010000
+#define I2C_SLV3_NACK_FLAG			0b00001000
+#define I2C_SLV2_NACK_FLAG			0b00000100
+#define I2C_SLV1_NACK_FLAG			0b00000010
+#define I2C_SLV0_NACK_FLAG			0b00000001
+
+/*************END OF REG_I2C_MST_STATUS FLAGS**********************************/
+
 // MPU6050 Register Map
 #define REG_XA_OFFS_USRH		0x06
 #define REG_XA_OFFS_USRL		0x07
@@ -307,6 +832,9 @@ typedef enum {
 #define REG_GYRO_CONFIG      	0x1B	// GFS_SEL(1:0) B4:B3
 #define REG_ACCEL_CONFIG     	0x1C	// AFS_SEL(1:0) B4:B3
 
+#define REG_MOT_THR          	0x1F	// 2mg/LSB
+#define REG_MOT_DUR          	0x20	// 1ms/LSB
+
 #define REG_FIFO_EN          	0x23
 
 #define REG_I2C_MST_CTRL     	0x24
@@ -388,6 +916,7 @@ typedef enum {
 #define REG_I2C_MST_DELAY_CTRL 	0x67
 
 #define REG_SIGNAL_PATH_RESET  	0x68
+#define REG_MOT_DETECT_CTRL    	0x69
 #define REG_USER_CTRL       	0x6A
 
 #define REG_PWR_MGMT_1      	0x6B
@@ -399,16 +928,147 @@ typedef enum {
 
 #define REG_WHO_AM_I        	0x75
 
+// MPU6050 asynchronous (DMA/IT) double-buffered reader
+typedef struct MPU6050_AsyncReader MPU6050_AsyncReader;
+
+// Starts a non-blocking burst read, completion is reported through MPU6050_AsyncComplete
+typedef uint8_t (*MPU6050_AsyncStartFn)(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len);
+// Called from MPU6050_AsyncComplete once the sample has been decoded (or the transfer failed)
+typedef void (*MPU6050_AsyncCallback)(MPU6050_AsyncReader *reader, uint8_t status, void *context);
+
+struct MPU6050_AsyncReader {
+	MPU6050_ConfigTypeDef *config;
+	MPU6050_AsyncStartFn startRead;			// NULL selects the HAL DMA/IT backend
+	MPU6050_AsyncCallback callback;			// Optional
+	void *context;
+
+	uint8_t burstReg;						// REG_ACCEL_XOUT_H, REG_INT_STATUS once attached to an MPU6050_DataReady
+	uint8_t rawData[2][MPU6050_INT_BURST_LEN];
+	MPU6050_Accelerations accel[2];
+	MPU6050_Rotations rota[2];
+	MPU6050_Temperature temp[2];
+	uint32_t startTimestampUs;				// Clock when the transfer in flight was started
+#if MPU6050_STATS
+	uint32_t startTicks;					// MPU6050_STATS_TICKS when the transfer in flight was started
+#endif
+
+	volatile uint8_t readyIndex;			// Buffer holding the last finished sample
+	volatile uint8_t busy;					// A transfer is in flight
+	volatile uint32_t sequence;				// Finished samples, odd while a buffer is being published
+	volatile uint32_t errors;
+	volatile uint8_t intStatus;				// INT_STATUS of the last burst from REG_INT_STATUS
+};
+
+// MPU6050 data-ready driven acquisition (one burst read per DATA_RDY interrupt)
+typedef struct {
+	MPU6050_AsyncReader *reader;
+
+	volatile uint8_t pending;				// DATA_RDY received while a read was in flight
+	volatile uint32_t dataReadyCount;		// DATA_RDY interrupts received
+	volatile uint32_t missedSamples;		// Samples never delivered to the consumer
+	uint32_t duplicateSamples;				// Reads by the consumer without a new sample
+	uint32_t lastSequence;					// Reader sequence of the last sample consumed
+} MPU6050_DataReady;
+
+// MPU6050 power-mode manager: cycle mode once idle, back to full rate on the motion interrupt
+typedef struct {
+	MPU6050_ConfigTypeDef *config;
+	uint8_t lpWakeCtrl;						// LP_WAKE_CTRL_CONFIG_x while idle
+	uint32_t idleTimeoutMs;					// Without motion before entering the cycle mode (< 71 min)
+	uint32_t pollIntervalMs;				// INT_STATUS polled while idle, 0 = woken by MPU6050_PowerIRQHandler only
+
+	volatile uint8_t motionPending;			// INT pin asserted since the last update
+	uint32_t lastMotionUs;					// MPU6050_GetTimeUs of the last motion
+	uint32_t lastPollUs;
+	int16_t refAccel[3];					// Reference of the motion check of the active mode
+	uint8_t refValid;
+
+	uint32_t wakeUps;						// Cycle to active transitions
+	uint32_t idleEntries;					// Active to cycle transitions
+} MPU6050_PowerManager;
+
+// Default transport of the build
+extern const MPU6050_Transport MPU6050_DefaultTransport;
+
 // FUNCTIONS PROTOTYPES
 uint8_t MPU6050_Init(MPU6050_ConfigTypeDef *config);
 uint8_t MPU6050_Test_Conn(MPU6050_ConfigTypeDef *config);
+uint8_t MPU6050_CheckConn(MPU6050_ConfigTypeDef *config);
+
+// Front ends that call the bus themselves (MPU6050.hpp) keep the bookkeeping of the library functions:
+// MPU6050_CallBegin checks the connection, every transfer goes between MPU6050_TransferBegin and
+// MPU6050_TransferEnd (stats, connection health), and MPU6050_CallEnd times the call as api
+uint8_t MPU6050_CallBegin(MPU6050_ConfigTypeDef *config, uint32_t *callTicks);
+uint32_t MPU6050_TransferBegin(MPU6050_ConfigTypeDef *config);
+void MPU6050_TransferEnd(MPU6050_ConfigTypeDef *config, uint32_t startTicks, HAL_StatusTypeDef status, uint32_t bytesRead, uint32_t bytesWritten);
+uint8_t MPU6050_CallEnd(MPU6050_ConfigTypeDef *config, uint8_t api, uint32_t callTicks, uint8_t result);
+uint8_t MPU6050_GetConnState(MPU6050_ConfigTypeDef *config);
+
+uint32_t MPU6050_GetTimeUs(MPU6050_ConfigTypeDef *config);
+uint32_t MPU6050_GetSampleRateHz(MPU6050_ConfigTypeDef *config);
+uint32_t MPU6050_GetSamplePeriodUs(MPU6050_ConfigTypeDef *config);
 
 uint16_t MPU6050_GetAccelSensitivity(MPU6050_ConfigTypeDef *config);
 float MPU6050_GetGyroSensitivty(MPU6050_ConfigTypeDef *config);
+void MPU6050_UpdateScales(MPU6050_ConfigTypeDef *config);
+
+uint8_t MPU6050_SetAccelScale(MPU6050_ConfigTypeDef *config, uint8_t accelScale);
+uint8_t MPU6050_SetGyroScale(MPU6050_ConfigTypeDef *config, uint8_t gyroScale);
+uint8_t MPU6050_SetDlpf(MPU6050_ConfigTypeDef *config, uint8_t dlpf);
+uint8_t MPU6050_SetSampleRateDiv(MPU6050_ConfigTypeDef *config, uint8_t smplRateDiv);
+uint8_t MPU6050_SetClockSource(MPU6050_ConfigTypeDef *config, uint8_t clkSel);
+uint8_t MPU6050_SetStandby(MPU6050_ConfigTypeDef *config, uint8_t stby);
+uint8_t MPU6050_ApplyProfile(MPU6050_ConfigTypeDef *config, const MPU6050_Profile *profile);
+void MPU6050_SaveProfile(MPU6050_ConfigTypeDef *config, MPU6050_Profile *profile, const char *name);
 
 uint8_t MPU6050_GetAcceleration(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel);
 uint8_t MPU6050_GetRotation(MPU6050_ConfigTypeDef *config, MPU6050_Rotations *rota);
 uint8_t MPU6050_GetTemperature(MPU6050_ConfigTypeDef *config, MPU6050_Temperature *temp);
+uint8_t MPU6050_GetAllSensors(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp);
+void MPU6050_ConvertSample(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp);
+
+void MPU6050_AsyncInit(MPU6050_AsyncReader *reader, MPU6050_ConfigTypeDef *config, MPU6050_AsyncStartFn startRead, MPU6050_AsyncCallback callback, void *context);
+uint8_t MPU6050_AsyncStart(MPU6050_AsyncReader *reader);
+void MPU6050_AsyncComplete(MPU6050_AsyncReader *reader, uint8_t transferOk);
+uint8_t MPU6050_AsyncGetSample(MPU6050_AsyncReader *reader, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp);
+
+uint8_t MPU6050_ConfigInterrupts(MPU6050_ConfigTypeDef *config, uint8_t intPinConf, uint8_t intEnableConf);
+uint8_t MPU6050_GetIntStatus(MPU6050_ConfigTypeDef *config, uint8_t *intStatus);
+
+uint8_t MPU6050_DataReadyInit(MPU6050_DataReady *drdy, MPU6050_AsyncReader *reader);
+void MPU6050_DataReadyIRQHandler(MPU6050_DataReady *drdy);
+void MPU6050_DataReadyComplete(MPU6050_DataReady *drdy, uint8_t transferOk);
+uint8_t MPU6050_DataReadyGetSample(MPU6050_DataReady *drdy, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp);
+
+uint8_t MPU6050_FifoEnable(MPU6050_ConfigTypeDef *config, uint8_t fifoEnConf);
+uint8_t MPU6050_FifoDisable(MPU6050_ConfigTypeDef *config);
+uint8_t MPU6050_FifoReset(MPU6050_ConfigTypeDef *config);
+uint8_t MPU6050_GetFifoCount(MPU6050_ConfigTypeDef *config, uint16_t *fifoCount);
+uint8_t MPU6050_GetFifoFrameSize(MPU6050_ConfigTypeDef *config);
+uint8_t MPU6050_FifoDrain(MPU6050_ConfigTypeDef *config, MPU6050_FifoRing *ring);
+
+void MPU6050_FifoRingInit(MPU6050_FifoRing *ring, MPU6050_FifoSample *samples, uint16_t size);
+uint8_t MPU6050_FifoPop(MPU6050_FifoRing *ring, MPU6050_FifoSample *sample);
+
+uint8_t MPU6050_AuxEnable(MPU6050_ConfigTypeDef *config, uint8_t i2cMstCtrlConf, uint8_t mstDelay);
+uint8_t MPU6050_AuxDisable(MPU6050_ConfigTypeDef *config);
+uint8_t MPU6050_AuxConfigSlave(MPU6050_ConfigTypeDef *config, uint8_t slave, const MPU6050_AuxSlave *slaveConf);
+uint8_t MPU6050_AuxDisableSlave(MPU6050_ConfigTypeDef *config, uint8_t slave);
+uint8_t MPU6050_AuxGetExtLen(MPU6050_ConfigTypeDef *config);
+uint8_t MPU6050_AuxGetExtOffset(MPU6050_ConfigTypeDef *config, uint8_t slave);
+uint8_t MPU6050_AuxRead(MPU6050_ConfigTypeDef *config, uint8_t address, uint8_t reg, uint8_t *value);
+uint8_t MPU6050_AuxWrite(MPU6050_ConfigTypeDef *config, uint8_t address, uint8_t reg, uint8_t value);
+uint8_t MPU6050_GetAllSensorsExt(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp, uint8_t *extData);
+
+uint8_t MPU6050_ConfigMotion(MPU6050_ConfigTypeDef *config, uint8_t motThr, uint8_t motDur, uint8_t motDetectCtrl);
+uint8_t MPU6050_EnterCycleMode(MPU6050_ConfigTypeDef *config, uint8_t lpWakeCtrl, uint8_t intEnableConf);
+uint8_t MPU6050_ExitCycleMode(MPU6050_ConfigTypeDef *config);
+
+uint8_t MPU6050_PowerInit(MPU6050_PowerManager *pm, MPU6050_ConfigTypeDef *config, uint8_t lpWakeCtrl, uint32_t idleTimeoutMs);
+void MPU6050_PowerIRQHandler(MPU6050_PowerManager *pm);
+void MPU6050_PowerFeedSample(MPU6050_PowerManager *pm, const MPU6050_Accelerations *accel);
+uint8_t MPU6050_PowerUpdate(MPU6050_PowerManager *pm);
+uint8_t MPU6050_PowerGetMode(MPU6050_PowerManager *pm);
 
 uint8_t MPU6050_GetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_AccelOffsets *accelOff);
 uint8_t MPU6050_GetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_GyroOffsets *gyroOff);
@@ -416,11 +1076,28 @@ uint8_t MPU6050_GetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_GyroOffsets
 uint8_t MPU6050_SetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_AccelOffsets *accelOff);
 uint8_t MPU6050_SetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_GyroOffsets *gyroOff);
 
-uint8_t MPU6050_CalibAccel(MPU6050_ConfigTypeDef *config, float calibTolerance);
+uint8_t MPU6050_CalibAccel(MPU6050_ConfigTypeDef *config, float calibTolerance, uint8_t gravityAxis);
 uint8_t MPU6050_CalibGyro(MPU6050_ConfigTypeDef *config, float calibTolerance);
 
+#if MPU6050_STATS
+void MPU6050_StatsInit(MPU6050_ConfigTypeDef *config, MPU6050_Stats *stats);
+void MPU6050_StatsReset(MPU6050_ConfigTypeDef *config);
+uint8_t MPU6050_StatsSnapshot(MPU6050_ConfigTypeDef *config, MPU6050_Stats *snapshot, uint8_t reset);
+uint32_t MPU6050_StatsPercentile(const MPU6050_ApiStats *apiStats, uint8_t percent);
+#endif
+
 // FUNCTIONS LIKE-MACROS
 #define ABS(x) ((x) < 0 ? -(x) : (x))
 #define MPU6050_RAW_TO_F_DATA(rawData, lsbSen) ( ((float)(rawData)/(float)(lsbSen)) * GRAVITY_ACCEL)
+#define MPU6050_RAW_TO_TEMP(rawData) ( ((float)(rawData) * (1.0f/TEMP_LSB_SEN)) + TEMP_OFFSET)
+#define MPU6050_RAW_TO_SCALED(rawData, scale) ((float)(rawData) * (scale))
+#define MPU6050_Q16(value) ((int32_t)((value) * 65536.0 + 0.5))
+#define MPU6050_RAW_TO_FIXED(rawData, scale) ((int32_t)(((int64_t)(rawData) * (scale) + (1 << (MPU6050_FIXED_SHIFT - 1))) >> MPU6050_FIXED_SHIFT))
+#define MPU6050_RAW_TO_TEMP_FIXED(rawData) (MPU6050_RAW_TO_FIXED(rawData, MPU6050_Q16(100.0 / TEMP_LSB_SEN)) + TEMP_OFFSET_CENTI)
+#define MPU6050_BYTES_TO_INT16(data_H, data_L) ((int16_t)(((uint16_t)(data_H) << 8) | (uint8_t)(data_L)))
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* MPU6050_LIB */
@@ -0,0 +1,78 @@
+/*
+ * MPU6050_LINUX.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_LINUX
+#define MPU6050_LINUX
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: Included by MPU6050_LIB.h when MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX.
+	It provides the few STM32 HAL names the library relies on, so the same sources
+	build on embedded Linux against /dev/i2c-N. Compile src/MPU6050_LINUX.c with the library. */
+
+// HAL compatible status
+typedef enum {
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+// Replaces ioctl(2) for the I2C_RDWR transfers (host tests of the batching without a kernel driver)
+typedef int (*MPU6050_LinuxIoctlFn)(int fd, unsigned long request, void *arg);
+
+// Linux I2C adapter (opened with MPU6050_LinuxOpen)
+typedef struct {
+	int fd;						// /dev/i2c-N file descriptor
+	void *context;				// Free for the application (e.g. in-process fake buses)
+	MPU6050_LinuxIoctlFn ioctlFn;	// NULL uses ioctl(2)
+} I2C_HandleTypeDef;
+
+// Parameters and constants
+#define MPU6050_LINUX_MAX_MSGS		42		// I2C_RDWR_IOCTL_MAX_MSGS of the kernel
+#define MPU6050_LINUX_MAX_WRITE		32		// Max register bytes per write
+
+// FUNCTIONS PROTOTYPES
+int MPU6050_LinuxOpen(I2C_HandleTypeDef *hi2c, const char *device);
+void MPU6050_LinuxClose(I2C_HandleTypeDef *hi2c);
+
+uint32_t MPU6050_LinuxGetNs(void);
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_LINUX */
@@ -0,0 +1,117 @@
+/*
+ * MPU6050_PIPE.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_PIPE
+#define MPU6050_PIPE
+
+#include "MPU6050_CAPTURE.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+/*  NOTE: Offline processing of captures (MPU6050_CAPTURE) on all the host cores. The file
+	is split in chunks of about chunkBytes at block boundaries (blocks decode on their own)
+	and every worker thread takes the next free chunk, so the file is never copied.
+
+	Per chunk, in parallel: decoding, bias removal (raw LSB, saturated like the sensor
+	output), optional moving average and the library conversion (MPU6050_ConvertSample with
+	the header configuration), so the results are bit for bit the ones of the firmware.
+	The moving average only depends on the last averageLen frames: a worker decodes them
+	again from the blocks before its chunk, so chunk boundaries do not change the output.
+
+	Then two callbacks receive the chunk (library structures, in file order inside it):
+	process runs in parallel and may see the chunks in any order; ordered runs on one chunk
+	at a time in file order, with the global index of its first frame. Filters with an
+	unbounded memory (IIR, fusion) belong in ordered: their state goes from one chunk to
+	the next exactly like in a sequential run, while the next chunks are decoded. The
+	throughput is then bounded by the ordered callback alone. */
+
+// Parameters and constants
+#define MPU6050_PIPE_MAX_THREADS		64
+#define MPU6050_PIPE_MAX_AVERAGE		64
+#ifndef MPU6050_PIPE_CHUNK_BYTES
+#define MPU6050_PIPE_CHUNK_BYTES		(256 * 1024)
+#endif
+
+// Converted frames of a chunk
+typedef struct {
+	uint32_t index;						// Chunk number in the file
+	uint64_t firstFrame;				// Global index of frames[0], only valid in the ordered callback
+	uint32_t count;
+	MPU6050_Accelerations *accel;
+	MPU6050_Rotations *rota;
+	MPU6050_Temperature *temp;
+} MPU6050_PipeChunk;
+
+typedef void (*MPU6050_PipeChunkFn)(void *context, const MPU6050_PipeChunk *chunk);
+
+// Zero initialized: one thread per online core, MPU6050_PIPE_CHUNK_BYTES, no bias, no average
+typedef struct {
+	uint8_t threads;
+	uint32_t chunkBytes;
+	int16_t accelBias[3];				// Raw LSB subtracted from AX AY AZ
+	int16_t gyroBias[3];				// Raw LSB subtracted from GX GY GZ
+	uint8_t averageLen;					// Moving average over the last averageLen frames (0 or 1: none)
+	MPU6050_PipeChunkFn process;		// Parallel, any chunk order (NULL: none)
+	MPU6050_PipeChunkFn ordered;		// One chunk at a time in file order (NULL: none)
+	void *context;
+} MPU6050_PipeConfig;
+
+typedef struct {
+	uint64_t frames;
+	uint32_t chunks;
+	uint32_t corruptBlocks;
+	uint8_t threads;
+	double seconds;						// Wall time
+	double cpuSeconds;					// All threads
+	double samplesPerSec;				// Frames per wall second
+} MPU6050_PipeStats;
+
+// Errors enumeration
+typedef enum {
+	PIPE_OK = 0,
+	ERR_PIPE_FORMAT,					// Not a capture
+	ERR_PIPE_FILE,						// The file cannot be mapped
+	ERR_PIPE_CONFIG,					// averageLen above MPU6050_PIPE_MAX_AVERAGE
+	ERR_PIPE_MEMORY,
+	ERR_PIPE_THREAD
+} PipeError;
+
+// FUNCTIONS PROTOTYPES
+uint8_t MPU6050_PipeRun(const uint8_t *data, size_t size, const MPU6050_PipeConfig *pipeConfig, MPU6050_PipeStats *stats);
+uint8_t MPU6050_PipeRunFile(const char *path, const MPU6050_PipeConfig *pipeConfig, MPU6050_PipeStats *stats);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_PIPE */
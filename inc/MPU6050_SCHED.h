@@ -0,0 +1,90 @@
+/*
+ * MPU6050_SCHED.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_SCHED
+#define MPU6050_SCHED
+
+#include "MPU6050_LIB.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: The scheduler reads several MPU6050 through their asynchronous readers.
+	Devices sharing an I2C handle are read back-to-back (the next transfer is started
+	from the completion of the previous one), devices on different handles are read
+	in parallel. Call MPU6050_SchedTrigger once per sample period and
+	MPU6050_SchedComplete from the HAL I2C completion and error callbacks. With a transport
+	without non-blocking reads (Linux, simulator), MPU6050_SchedTrigger reads every device
+	itself, one bus after the other. */
+
+// Parameters and constants
+#define MPU6050_SCHED_MAX_DEVICES	8
+
+// Scheduled device
+typedef struct {
+	MPU6050_AsyncReader reader;				// Must stay the first member
+
+	volatile uint8_t queued;				// Waiting for its bus in the current cycle
+	volatile uint32_t samples;				// Completed samples
+	volatile uint32_t lastSampleTime;		// Clock value at the last completion (us)
+	volatile uint32_t period;				// Time between the last two completions (us)
+	volatile uint32_t jitter;				// |period - expected period| of the last sample (us)
+	volatile uint32_t maxJitter;
+	volatile uint32_t overruns;				// Triggers that found the device still queued or busy
+} MPU6050_SchedDevice;
+
+// Scheduler
+typedef struct {
+	MPU6050_SchedDevice devices[MPU6050_SCHED_MAX_DEVICES];
+	uint8_t numDevices;
+	MPU6050_ClockFn clock;					// NULL uses HAL_GetTick() * 1000
+	uint32_t periodUs;						// Expected sample period, 0 = compare with the previous period
+} MPU6050_Scheduler;
+
+// Errors enumeration
+typedef enum {
+	SCHED_OK = 0,
+	ERR_SCHED_FULL,
+	ERR_SCHED_INVALID_DEVICE,
+	ERR_SCHED_NO_DATA
+} SchedulerError;
+
+// FUNCTIONS PROTOTYPES
+void MPU6050_SchedInit(MPU6050_Scheduler *sched, MPU6050_ClockFn clock, uint32_t periodUs);
+uint8_t MPU6050_SchedAddDevice(MPU6050_Scheduler *sched, MPU6050_ConfigTypeDef *config, MPU6050_AsyncStartFn startRead, uint8_t *index);
+void MPU6050_SchedTrigger(MPU6050_Scheduler *sched);
+void MPU6050_SchedComplete(MPU6050_Scheduler *sched, I2C_HandleTypeDef *hi2c, uint8_t transferOk);
+uint8_t MPU6050_SchedGetSample(MPU6050_Scheduler *sched, uint8_t index, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp, uint32_t *ageUs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_SCHED */
@@ -0,0 +1,171 @@
+/*
+ * MPU6050_SIM.h
+ * Author: Andres Aguinaga Lopez
+ * License: GNU General Public License v3.0
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Disclaimer:
+ * This software is provided "as is," without warranty of any kind, express
+ * or implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. In no event shall
+ * the authors or copyright holders be liable for any claim, damages or other
+ * liability, whether in an action of contract, tort or otherwise, arising
+ * from, out of or in connection with the software or the use or other
+ * dealings in the software.
+ */
+
+
+#ifndef MPU6050_SIM
+#define MPU6050_SIM
+
+#include "MPU6050_LIB.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*  NOTE: Host-side simulated MPU6050 exposed as an MPU6050_Transport, so the library
+	can be exercised and benchmarked without a board. Requires the Linux transport build
+	(MPU6050_TRANSPORT_LINUX), the simulated bus is attached through hi2c->context:
+
+	MPU6050_SimBus bus;
+	MPU6050_Sim imu;
+	I2C_HandleTypeDef hi2c = {.fd = -1, .context = &bus};
+
+	MPU6050_SimBusInit(&bus, MPU6050_SIM_I2C_400KHZ);
+	MPU6050_SimInit(&imu, MPU6050_ADDRESS_AD0_L);
+	MPU6050_SimAttach(&bus, &imu);
+	config.hi2c = &hi2c;
+	config.transport = &MPU6050_SimTransport;
+
+	Time is virtual: every transaction advances the bus clock by its duration on the wire
+	and MPU6050_SimAdvance models idle time. Samples are produced at the rate given by
+	REG_SMPLRT_DIV and the DLPF (8 kHz or 1 kHz gyro output rate), or at LP_WAKE_CTRL in cycle mode.
+	The supply current of each power mode (datasheet typical values) is integrated over
+	the virtual time into chargeFc. */
+
+// Parameters and constants
+#define MPU6050_SIM_I2C_100KHZ		100000
+#define MPU6050_SIM_I2C_400KHZ		400000
+#define MPU6050_SIM_MAX_DEVICES		2		// AD0 low and high
+#define MPU6050_SIM_REGS			128
+#define MPU6050_SIM_MAX_AUX			2		// Devices on the auxiliary bus
+#define MPU6050_SIM_AUX_REGS		256
+#define MPU6050_SIM_STUCK_TIMEOUT_NS	((uint64_t)MPU6050_TIMEOUT_MS * 1000000)
+
+#define MPU6050_SIM_IDD_GYRO_ACCEL_UA	3800	// Supply current of the power modes
+#define MPU6050_SIM_IDD_GYRO_UA			3600
+#define MPU6050_SIM_IDD_ACCEL_UA		500
+#define MPU6050_SIM_IDD_SLEEP_UA		5
+
+// Injected faults
+typedef enum {
+	SIM_FAULT_NONE = 0,
+	SIM_FAULT_NACK,						// Transactions are not acknowledged (HAL_ERROR)
+	SIM_FAULT_STUCK_BUS,				// SDA held low, transactions time out (HAL_TIMEOUT)
+	SIM_FAULT_BAD_WHO_AM_I				// WHO_AM_I reads back a wrong value
+} MPU6050_SimFault;
+
+typedef struct MPU6050_Sim MPU6050_Sim;
+
+// Device on the auxiliary I2C bus (e.g. a magnetometer), a plain register file updated by the application
+typedef struct {
+	uint8_t address;
+	uint8_t regs[MPU6050_SIM_AUX_REGS];
+	uint32_t reads;						// Transfers served to the MPU6050 master
+	uint32_t writes;
+} MPU6050_SimAux;
+
+// Physical input of the simulated sensor at a given time (optional, constant values otherwise)
+typedef void (*MPU6050_SimSignalFn)(MPU6050_Sim *sim, uint64_t timeNs, float accelG[3], float gyroDps[3], float *tempC);
+
+// Simulated device
+struct MPU6050_Sim {
+	uint8_t address;
+	uint8_t regs[MPU6050_SIM_REGS];
+	uint8_t regPointer;
+
+	uint8_t fifo[MPU6050_FIFO_SIZE];
+	uint16_t fifoHead;
+	uint16_t fifoCount;
+
+	uint64_t nextSampleNs;
+	uint32_t samples;					// Samples produced since reset
+	int32_t clockErrorPpm;				// Internal oscillator error, stretches the sample period
+
+								// Physical input
+	float accelG[3];
+	float gyroDps[3];
+	float tempC;
+	uint16_t noiseLsb;					// Uniform noise amplitude added to every axis
+	uint32_t noiseSeed;
+	MPU6050_SimSignalFn signal;
+	void *context;
+
+	MPU6050_SimAux *aux[MPU6050_SIM_MAX_AUX];	// Accessed through the I2C master at every sample
+	uint8_t numAux;
+
+	float motionRefG[3];				// High-pass filter reference of the motion detection
+	uint8_t motionCount;				// Samples above MOT_THR, compared with MOT_DUR
+
+	uint64_t chargeFc;					// Supply charge since MPU6050_SimInit (uA * ns)
+	uint64_t chargeTimeNs;				// Virtual time chargeFc was integrated up to
+};
+
+// Simulated bus
+typedef struct {
+	MPU6050_Sim *devices[MPU6050_SIM_MAX_DEVICES];
+	uint8_t numDevices;
+	uint32_t clockHz;					// SCL frequency
+	uint32_t latencyNs;					// Fixed host overhead added to every transaction
+
+	uint64_t timeNs;					// Virtual time
+
+	uint8_t fault;						// MPU6050_SimFault
+	uint32_t faultCount;				// Transactions affected, 0 = until cleared
+
+								// Statistics
+	uint32_t transactions;
+	uint32_t reads;						// Transactions with a read phase
+	uint32_t writes;
+	uint32_t bytesRead;
+	uint32_t bytesWritten;
+	uint32_t errors;
+	uint64_t busTimeNs;					// Time spent on the wire
+} MPU6050_SimBus;
+
+// Transport serving the simulated devices of hi2c->context
+extern const MPU6050_Transport MPU6050_SimTransport;
+
+// FUNCTIONS PROTOTYPES
+void MPU6050_SimBusInit(MPU6050_SimBus *bus, uint32_t clockHz);
+void MPU6050_SimInit(MPU6050_Sim *sim, uint8_t address);
+uint8_t MPU6050_SimAttach(MPU6050_SimBus *bus, MPU6050_Sim *sim);
+void MPU6050_SimAuxInit(MPU6050_SimAux *aux, uint8_t address);
+uint8_t MPU6050_SimAttachAux(MPU6050_Sim *sim, MPU6050_SimAux *aux);
+void MPU6050_SimReset(MPU6050_Sim *sim, uint64_t timeNs);
+void MPU6050_SimAdvance(MPU6050_SimBus *bus, uint64_t durationNs);
+void MPU6050_SimInjectFault(MPU6050_SimBus *bus, uint8_t fault, uint32_t count);
+void MPU6050_SimResetStats(MPU6050_SimBus *bus);
+
+uint32_t MPU6050_SimSampleRateHz(MPU6050_Sim *sim);
+uint32_t MPU6050_SimSupplyCurrentUa(MPU6050_Sim *sim);
+uint64_t MPU6050_SimTransactionNs(MPU6050_SimBus *bus, uint16_t writeBytes, uint16_t readBytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPU6050_SIM */
@@ -0,0 +1,101 @@
+#include "MPU6050_BATCH.h"
+
+#if defined(MPU6050_USE_CMSIS_DSP)
+  #include "arm_math.h"
+#elif defined(__AVX2__) || defined(__SSE2__)
+  #include <immintrin.h>
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
+
+#if MPU6050_GYRO_UNITS == MPU6050_GYRO_RADS
+#define GYRO_UNIT_FACTOR	DEG_TO_RAD
+#else
+#define GYRO_UNIT_FACTOR	1.0f
+#endif
+
+// dst[i] = raw[i] * scale + offset
+void MPU6050_ScaleInt16(const int16_t *raw, float *dst, uint32_t len, float scale, float offset) {
+	uint32_t i = 0;
+
+#if defined(MPU6050_USE_CMSIS_DSP)
+	// arm_q15_to_float divides by 32768, fold it into the scale
+	arm_q15_to_float((q15_t *)raw, dst, len);
+	arm_scale_f32(dst, scale * 32768.0f, dst, len);
+	if(offset != 0.0f){
+		arm_offset_f32(dst, offset, dst, len);
+	}
+	i = len;
+#elif defined(__AVX2__)
+	__m256 vScale = _mm256_set1_ps(scale);
+	__m256 vOffset = _mm256_set1_ps(offset);
+	for(; i + 8 <= len; i += 8){
+		__m256i v32 = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)&raw[i]));
+		__m256 vf = _mm256_cvtepi32_ps(v32);
+		_mm256_storeu_ps(&dst[i], _mm256_add_ps(_mm256_mul_ps(vf, vScale), vOffset));
+	}
+#elif defined(__SSE2__)
+	__m128 vScale = _mm_set1_ps(scale);
+	__m128 vOffset = _mm_set1_ps(offset);
+	for(; i + 8 <= len; i += 8){
+		__m128i v16 = _mm_loadu_si128((const __m128i *)&raw[i]);
+		// Sign extend by unpacking into the high half and shifting back
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v16, v16), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v16, v16), 16);
+		_mm_storeu_ps(&dst[i], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), vScale), vOffset));
+		_mm_storeu_ps(&dst[i + 4], _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), vScale), vOffset));
+	}
+#elif defined(__ARM_NEON)
+	float32x4_t vOffset = vdupq_n_f32(offset);
+	for(; i + 8 <= len; i += 8){
+		int16x8_t v16 = vld1q_s16(&raw[i]);
+		float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v16)));
+		float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v16)));
+		vst1q_f32(&dst[i], vmlaq_n_f32(vOffset, lo, scale));
+		vst1q_f32(&dst[i + 4], vmlaq_n_f32(vOffset, hi, scale));
+	}
+#endif
+
+	for(; i < len; i++){
+		dst[i] = (float)raw[i] * scale + offset;
+	}
+}
+
+void MPU6050_ConvertBatch(MPU6050_ConfigTypeDef *config, const uint8_t *frames, uint32_t numFrames, MPU6050_BatchData *out) {
+	int16_t raw[MPU6050_BATCH_CHANNELS][MPU6050_BATCH_BLOCK];
+	float *dst[MPU6050_BATCH_CHANNELS] = {out->accelX, out->accelY, out->accelZ, out->temp, out->rotaX, out->rotaY, out->rotaZ};
+	float scale[MPU6050_BATCH_CHANNELS];
+	float offset[MPU6050_BATCH_CHANNELS] = {0.0f, 0.0f, 0.0f, TEMP_OFFSET, 0.0f, 0.0f, 0.0f};
+
+	// Float factors are resolved once per call, independently of MPU6050_CONVERSION
+	float accelScale = GRAVITY_ACCEL / (float)MPU6050_GetAccelSensitivity(config);
+	float gyroScale = GYRO_UNIT_FACTOR / MPU6050_GetGyroSensitivty(config);
+	scale[0] = scale[1] = scale[2] = accelScale;
+	scale[3] = 1.0f / TEMP_LSB_SEN;
+	scale[4] = scale[5] = scale[6] = gyroScale;
+
+	uint32_t done = 0;
+	while(done < numFrames){
+		uint32_t n = numFrames - done;
+		if(n > MPU6050_BATCH_BLOCK){
+			n = MPU6050_BATCH_BLOCK;
+		}
+
+		// De-interleave and byte swap the block into one int16 array per channel
+		const uint8_t *frame = &frames[done * MPU6050_SENSORS_BURST_LEN];
+		for(uint32_t i = 0; i < n; i++){
+			for(uint8_t ch = 0; ch < MPU6050_BATCH_CHANNELS; ch++){
+				raw[ch][i] = MPU6050_BYTES_TO_INT16(frame[2 * ch], frame[2 * ch + 1]);
+			}
+			frame += MPU6050_SENSORS_BURST_LEN;
+		}
+
+		for(uint8_t ch = 0; ch < MPU6050_BATCH_CHANNELS; ch++){
+			if(dst[ch] != NULL){
+				MPU6050_ScaleInt16(raw[ch], &dst[ch][done], n, scale[ch], offset[ch]);
+			}
+		}
+
+		done += n;
+	}
+}
@@ -0,0 +1,617 @@
+#define _GNU_SOURCE
+#include "MPU6050_BENCH.h"
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+const uint32_t MPU6050_BenchClocks[MPU6050_BENCH_CLOCKS] = {MPU6050_SIM_I2C_100KHZ, MPU6050_SIM_I2C_400KHZ};
+
+static MPU6050_AsyncReader benchReader;
+static MPU6050_DataReady benchDataReady;
+static MPU6050_FifoSample benchFifoSamples[64];
+static MPU6050_FifoRing benchFifoRing;
+
+static uint64_t MPU6050_BenchCpuNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Setups
+
+static uint8_t MPU6050_BenchSetupAsync(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	MPU6050_AsyncInit(&benchReader, config, NULL, NULL, NULL);
+	return ASYNC_OK;
+}
+
+// Plays a DMA read: the transfer runs at the start and completes when MPU6050_BenchDataReady says so
+static uint8_t MPU6050_BenchStartRead(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len) {
+	if(HAL_OK != MPU6050_SimTransport.read(config->hi2c, config->address, reg, data, len)){
+		return ERR_ASYNC_CONN;
+	}
+	return ASYNC_OK;
+}
+
+static uint8_t MPU6050_BenchSetupDataReady(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	MPU6050_AsyncInit(&benchReader, config, MPU6050_BenchStartRead, NULL, NULL);
+	if(INT_OK != MPU6050_DataReadyInit(&benchDataReady, &benchReader)){
+		return ERR_INT_BLOCKING_READER;
+	}
+	return MPU6050_ConfigInterrupts(config, LATCH_INT_EN_CONFIG_SET, DATA_RDY_EN_CONFIG_SET);
+}
+
+static uint8_t MPU6050_BenchSetupFifo(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	MPU6050_FifoRingInit(&benchFifoRing, benchFifoSamples, sizeof(benchFifoSamples) / sizeof(benchFifoSamples[0]));
+	return MPU6050_FifoEnable(config, ACCEL_FIFO_EN_CONFIG_SET | XG_FIFO_EN_CONFIG_SET | YG_FIFO_EN_CONFIG_SET | ZG_FIFO_EN_CONFIG_SET);
+}
+
+static uint8_t MPU6050_BenchSetupLost(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_Accelerations accel;
+
+	MPU6050_SimInjectFault(bus, SIM_FAULT_NACK, MPU6050_LOST_ERRORS);
+	while(MPU6050_GetConnState(config) != CONN_STATE_LOST){
+		MPU6050_GetAcceleration(config, &accel);
+	}
+	return CONN_OK;
+}
+
+// Measured calls
+
+static uint8_t MPU6050_BenchInit(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_Init(config);
+}
+
+static uint8_t MPU6050_BenchTestConn(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_Test_Conn(config);
+}
+
+static uint8_t MPU6050_BenchCheckConn(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_CheckConn(config);
+}
+
+static uint8_t MPU6050_BenchGetAcceleration(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_Accelerations accel;
+	(void)bus;
+	return MPU6050_GetAcceleration(config, &accel);
+}
+
+static uint8_t MPU6050_BenchGetRotation(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_Rotations rota;
+	(void)bus;
+	return MPU6050_GetRotation(config, &rota);
+}
+
+static uint8_t MPU6050_BenchGetTemperature(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_Temperature temp;
+	(void)bus;
+	return MPU6050_GetTemperature(config, &temp);
+}
+
+static uint8_t MPU6050_BenchGetAllSensors(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_Accelerations accel;
+	MPU6050_Rotations rota;
+	MPU6050_Temperature temp;
+	(void)bus;
+	return MPU6050_GetAllSensors(config, &accel, &rota, &temp);
+}
+
+static uint8_t MPU6050_BenchAsyncStart(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)config;
+	(void)bus;
+	return MPU6050_AsyncStart(&benchReader);
+}
+
+static uint8_t MPU6050_BenchDataReady(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)config;
+	(void)bus;
+	MPU6050_DataReadyIRQHandler(&benchDataReady);
+	if(benchReader.busy){
+		MPU6050_DataReadyComplete(&benchDataReady, TRUE);
+	}
+	return (0 == benchReader.errors) ? ASYNC_OK : ERR_ASYNC_CONN;
+}
+
+static uint8_t MPU6050_BenchConfigInterrupts(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_ConfigInterrupts(config, LATCH_INT_EN_CONFIG_SET, DATA_RDY_EN_CONFIG_SET);
+}
+
+static uint8_t MPU6050_BenchGetIntStatus(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	uint8_t intStatus;
+	(void)bus;
+	return MPU6050_GetIntStatus(config, &intStatus);
+}
+
+static uint8_t MPU6050_BenchFifoEnable(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_FifoEnable(config, ACCEL_FIFO_EN_CONFIG_SET | XG_FIFO_EN_CONFIG_SET | YG_FIFO_EN_CONFIG_SET | ZG_FIFO_EN_CONFIG_SET);
+}
+
+static uint8_t MPU6050_BenchFifoReset(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_FifoReset(config);
+}
+
+static uint8_t MPU6050_BenchFifoDisable(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_FifoDisable(config);
+}
+
+static uint8_t MPU6050_BenchGetFifoCount(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	uint16_t fifoCount;
+	(void)bus;
+	return MPU6050_GetFifoCount(config, &fifoCount);
+}
+
+// 10 samples (120 bytes) per drain
+static uint8_t MPU6050_BenchFifoDrain(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_FifoSample sample;
+
+	MPU6050_SimAdvance(bus, 10000000);
+	uint8_t status = MPU6050_FifoDrain(config, &benchFifoRing);
+	while(FIFO_OK == MPU6050_FifoPop(&benchFifoRing, &sample));
+
+	return status;
+}
+
+static uint8_t MPU6050_BenchSetAccelScale(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_SetAccelScale(config, (config->accelConfig & GET_ACCEL_FS_CONFIG) ? ACCEL_CONFIG_SCALE_0 : ACCEL_CONFIG_SCALE_2);
+}
+
+// Alternates between two profiles differing in the sample rate, DLPF and full-scales
+static uint8_t MPU6050_BenchApplyProfile(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	static const MPU6050_Profile profiles[2] = {
+		{"hover", DLPF_CONFIG_1, 0, CLKSEL_CONFIG_1, 0, ACCEL_CONFIG_SCALE_0, GYRO_CONFIG_SCALE_0},
+		{"acro", DLPF_CONFIG_3, 1, CLKSEL_CONFIG_1, 0, ACCEL_CONFIG_SCALE_2, GYRO_CONFIG_SCALE_3}
+	};
+	(void)bus;
+	return MPU6050_ApplyProfile(config, &profiles[(config->gyroConfig & GET_GYRO_FS_CONFIG) ? 0 : 1]);
+}
+
+static uint8_t MPU6050_BenchGetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_AccelOffsets accelOff;
+	(void)bus;
+	return MPU6050_GetAccelOffset(config, &accelOff);
+}
+
+static uint8_t MPU6050_BenchGetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_GyroOffsets gyroOff;
+	(void)bus;
+	return MPU6050_GetGyroOffset(config, &gyroOff);
+}
+
+static uint8_t MPU6050_BenchSetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_AccelOffsets accelOff = {.xOffset = -120, .yOffset = 96, .zOffset = -240};
+	(void)bus;
+	return MPU6050_SetAccelOffset(config, &accelOff);
+}
+
+static uint8_t MPU6050_BenchSetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	MPU6050_GyroOffsets gyroOff = {.xOffset = -49, .yOffset = 66, .zOffset = -26};
+	(void)bus;
+	return MPU6050_SetGyroOffset(config, &gyroOff);
+}
+
+static uint8_t MPU6050_BenchCalibAccel(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_CalibAccel(config, MPU6050_BENCH_CALIB_TOLERANCE, GRAVITY_AXIS_Z_POS);
+}
+
+static uint8_t MPU6050_BenchCalibGyro(MPU6050_ConfigTypeDef *config, MPU6050_SimBus *bus) {
+	(void)bus;
+	return MPU6050_CalibGyro(config, MPU6050_BENCH_CALIB_TOLERANCE);
+}
+
+const MPU6050_BenchCase MPU6050_BenchCases[] = {
+	{"MPU6050_Init", NULL, MPU6050_BenchInit, 100},
+	{"MPU6050_Test_Conn", NULL, MPU6050_BenchTestConn, 1000},
+	{"MPU6050_CheckConn", NULL, MPU6050_BenchCheckConn, 1000},
+	{"MPU6050_CheckConn (reconnect)", MPU6050_BenchSetupLost, MPU6050_BenchCheckConn, 1},
+	{"MPU6050_GetAcceleration", NULL, MPU6050_BenchGetAcceleration, 1000},
+	{"MPU6050_GetRotation", NULL, MPU6050_BenchGetRotation, 1000},
+	{"MPU6050_GetTemperature", NULL, MPU6050_BenchGetTemperature, 1000},
+	{"MPU6050_GetAllSensors", NULL, MPU6050_BenchGetAllSensors, 1000},
+	{"MPU6050_AsyncStart", MPU6050_BenchSetupAsync, MPU6050_BenchAsyncStart, 1000},
+	{"MPU6050_DataReadyIRQHandler", MPU6050_BenchSetupDataReady, MPU6050_BenchDataReady, 1000},
+	{"MPU6050_ConfigInterrupts", NULL, MPU6050_BenchConfigInterrupts, 100},
+	{"MPU6050_GetIntStatus", NULL, MPU6050_BenchGetIntStatus, 1000},
+	{"MPU6050_FifoEnable", NULL, MPU6050_BenchFifoEnable, 100},
+	{"MPU6050_FifoReset", MPU6050_BenchSetupFifo, MPU6050_BenchFifoReset, 100},
+	{"MPU6050_FifoDisable", MPU6050_BenchSetupFifo, MPU6050_BenchFifoDisable, 100},
+	{"MPU6050_GetFifoCount", MPU6050_BenchSetupFifo, MPU6050_BenchGetFifoCount, 1000},
+	{"MPU6050_FifoDrain", MPU6050_BenchSetupFifo, MPU6050_BenchFifoDrain, 100},
+	{"MPU6050_SetAccelScale", NULL, MPU6050_BenchSetAccelScale, 1000},
+	{"MPU6050_ApplyProfile", NULL, MPU6050_BenchApplyProfile, 1000},
+	{"MPU6050_GetAccelOffset", NULL, MPU6050_BenchGetAccelOffset, 1000},
+	{"MPU6050_GetGyroOffset", NULL, MPU6050_BenchGetGyroOffset, 1000},
+	{"MPU6050_SetAccelOffset", NULL, MPU6050_BenchSetAccelOffset, 100},
+	{"MPU6050_SetGyroOffset", NULL, MPU6050_BenchSetGyroOffset, 100},
+	{"MPU6050_CalibAccel", NULL, MPU6050_BenchCalibAccel, 1},
+	{"MPU6050_CalibGyro", NULL, MPU6050_BenchCalibGyro, 1},
+	{NULL, NULL, NULL, 0}
+};
+
+void MPU6050_BenchRun(const MPU6050_BenchCase *bench, MPU6050_BenchResult *result) {
+	MPU6050_SimBus bus;
+	MPU6050_Sim imu;
+	I2C_HandleTypeDef hi2c = {.fd = -1, .context = &bus};
+
+	memset(result, 0, sizeof(*result));
+	result->name = bench->name;
+	result->calls = bench->calls;
+
+	for(uint8_t clock = 0; clock < MPU6050_BENCH_CLOCKS; clock++){
+		MPU6050_ConfigTypeDef config = {
+			.hi2c = &hi2c,
+			.address = MPU6050_ADDRESS_AD0_L,
+			.transport = &MPU6050_SimTransport,
+			.dlpfFsyncConfig = DLPF_CONFIG_1,
+			.smplRateDivConfig = 0,					// 1 kHz
+			.pwrMgmt1Config = CLKSEL_CONFIG_1,
+			.accelConfig = ACCEL_CONFIG_SCALE_0,
+			.gyroConfig = GYRO_CONFIG_SCALE_0
+		};
+
+		// Uncalibrated device lying flat
+		MPU6050_SimBusInit(&bus, MPU6050_BenchClocks[clock]);
+		MPU6050_SimInit(&imu, MPU6050_ADDRESS_AD0_L);
+		imu.accelG[0] = 0.05f;
+		imu.accelG[1] = -0.04f;
+		imu.accelG[2] = 1.03f;
+		imu.gyroDps[0] = 1.5f;
+		imu.gyroDps[1] = -2.0f;
+		imu.gyroDps[2] = 0.8f;
+		imu.noiseLsb = 4;
+		MPU6050_SimAttach(&bus, &imu);
+
+		MPU6050_Init(&config);
+		MPU6050_SimAdvance(&bus, 10000000);
+		if(bench->setup != NULL){
+			bench->setup(&config, &bus);
+		}
+		MPU6050_SimResetStats(&bus);
+
+		uint64_t cpuStart = MPU6050_BenchCpuNs();
+		for(uint32_t call = 0; call < bench->calls; call++){
+			result->status = bench->run(&config, &bus);
+		}
+		uint64_t cpuEnd = MPU6050_BenchCpuNs();
+
+		double calls = (double)bench->calls;
+		result->busTimeUs[clock] = (double)bus.busTimeNs / 1000.0 / calls;
+		result->cpuTimeUs += (double)(cpuEnd - cpuStart) / 1000.0 / calls / MPU6050_BENCH_CLOCKS;
+		// Transfers do not depend on the bus clock
+		result->transactions = (double)bus.transactions / calls;
+		result->reads = (double)bus.reads / calls;
+		result->writes = (double)bus.writes / calls;
+		result->bytesRead = (double)bus.bytesRead / calls;
+		result->bytesWritten = (double)bus.bytesWritten / calls;
+	}
+}
+
+uint16_t MPU6050_BenchRunAll(MPU6050_BenchResult *results, uint16_t maxResults) {
+	uint16_t numResults = 0;
+
+	for(const MPU6050_BenchCase *bench = MPU6050_BenchCases; bench->name != NULL && numResults < maxResults; bench++){
+		MPU6050_BenchRun(bench, &results[numResults++]);
+	}
+	return numResults;
+}
+
+void MPU6050_BenchWriteJson(FILE *out, const MPU6050_BenchResult *results, uint16_t numResults) {
+	fprintf(out, "{\n");
+	fprintf(out, "  \"conversion\": \"%s\",\n", (MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED) ? "fixed" : "float");
+	fprintf(out, "  \"bus_clocks_hz\": [%u, %u],\n", (unsigned)MPU6050_BenchClocks[0], (unsigned)MPU6050_BenchClocks[1]);
+	fprintf(out, "  \"results\": [\n");
+
+	for(uint16_t i = 0; i < numResults; i++){
+		const MPU6050_BenchResult *r = &results[i];
+
+		fprintf(out, "    {\"function\": \"%s\", \"status\": %u, \"calls\": %u, ", r->name, (unsigned)r->status, (unsigned)r->calls);
+		fprintf(out, "\"transactions\": %.2f, \"reads\": %.2f, \"writes\": %.2f, ", r->transactions, r->reads, r->writes);
+		fprintf(out, "\"bytes_read\": %.2f, \"bytes_written\": %.2f, ", r->bytesRead, r->bytesWritten);
+		fprintf(out, "\"bus_time_us\": [%.1f, %.1f], \"cpu_time_us\": %.3f}%s\n", r->busTimeUs[0], r->busTimeUs[1], r->cpuTimeUs, (i + 1 < numResults) ? "," : "");
+	}
+
+	fprintf(out, "  ]\n}\n");
+}
+
+// Synthetic motion trace: the true attitude integrated (exact rotation per sample) from a known angular rate
+typedef struct {
+	double q[4];
+	uint64_t lastTimeNs;
+	uint8_t started;
+} MPU6050_BenchTrace;
+
+static MPU6050_Accelerations benchFusionAccel[MPU6050_BENCH_FUSION_SAMPLES];
+static MPU6050_Rotations benchFusionRota[MPU6050_BENCH_FUSION_SAMPLES];
+static uint32_t benchFusionTime[MPU6050_BENCH_FUSION_SAMPLES];
+static double benchFusionTruth[MPU6050_BENCH_FUSION_SAMPLES][4];
+
+static void MPU6050_BenchTraceRate(double t, double *w) {
+	w[0] = 120.0 * sin(2.0 * M_PI * 0.5 * t);
+	w[1] = 90.0 * sin(2.0 * M_PI * 0.3 * t + 1.0);
+	w[2] = 60.0 * cos(2.0 * M_PI * 0.2 * t);
+}
+
+static void MPU6050_BenchTraceSignal(MPU6050_Sim *sim, uint64_t timeNs, float accelG[3], float gyroDps[3], float *tempC) {
+	MPU6050_BenchTrace *trace = (MPU6050_BenchTrace *)sim->context;
+	double w[3];
+	double *q = trace->q;
+	(void)tempC;
+
+	MPU6050_BenchTraceRate(timeNs * 1e-9, w);
+
+	if(trace->started){
+		double dt = (timeNs - trace->lastTimeNs) * 1e-9;
+		double rate = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]) * (M_PI / 180.0);
+		double c = cos(rate * dt / 2.0);
+		double k = (rate > 0.0) ? sin(rate * dt / 2.0) / rate * (M_PI / 180.0) : 0.0;
+		double r[3] = {w[0] * k, w[1] * k, w[2] * k};
+		double n[4] = {
+			q[0] * c - q[1] * r[0] - q[2] * r[1] - q[3] * r[2],
+			q[0] * r[0] + q[1] * c + q[2] * r[2] - q[3] * r[1],
+			q[0] * r[1] - q[1] * r[2] + q[2] * c + q[3] * r[0],
+			q[0] * r[2] + q[1] * r[1] - q[2] * r[0] + q[3] * c
+		};
+		memcpy(q, n, sizeof(n));
+	}
+	trace->started = TRUE;
+	trace->lastTimeNs = timeNs;
+
+	// Gravity only
+	accelG[0] = (float)(2.0 * (q[1] * q[3] - q[0] * q[2]));
+	accelG[1] = (float)(2.0 * (q[0] * q[1] + q[2] * q[3]));
+	accelG[2] = (float)(q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]);
+	gyroDps[0] = (float)w[0];
+	gyroDps[1] = (float)w[1];
+	gyroDps[2] = (float)w[2];
+}
+
+// Reads the trace through the library, one burst right after every sample
+static void MPU6050_BenchFusionRecord(void) {
+	MPU6050_SimBus bus;
+	MPU6050_Sim imu;
+	MPU6050_BenchTrace trace = {.q = {1.0, 0.0, 0.0, 0.0}};
+	I2C_HandleTypeDef hi2c = {.fd = -1, .context = &bus};
+	MPU6050_ConfigTypeDef config = {
+		.hi2c = &hi2c,
+		.address = MPU6050_ADDRESS_AD0_L,
+		.transport = &MPU6050_SimTransport,
+		.dlpfFsyncConfig = DLPF_CONFIG_1,
+		.smplRateDivConfig = 0,
+		.pwrMgmt1Config = CLKSEL_CONFIG_1,
+		.accelConfig = ACCEL_CONFIG_SCALE_1,
+		.gyroConfig = GYRO_CONFIG_SCALE_1
+	};
+
+	MPU6050_SimBusInit(&bus, MPU6050_SIM_I2C_400KHZ);
+	MPU6050_SimInit(&imu, MPU6050_ADDRESS_AD0_L);
+	imu.noiseLsb = 4;
+	MPU6050_SimAttach(&bus, &imu);
+	MPU6050_Init(&config);
+	imu.signal = MPU6050_BenchTraceSignal;
+	imu.context = &trace;
+
+	for(uint32_t i = 0; i < MPU6050_BENCH_FUSION_SAMPLES; i++){
+		uint64_t sampleNs = imu.nextSampleNs;
+
+		MPU6050_SimAdvance(&bus, sampleNs - bus.timeNs);
+		MPU6050_GetAllSensors(&config, &benchFusionAccel[i], &benchFusionRota[i], NULL);
+		benchFusionTime[i] = (uint32_t)(sampleNs / 1000);
+		memcpy(benchFusionTruth[i], trace.q, sizeof(trace.q));
+	}
+}
+
+static double MPU6050_BenchFusionReal(MPU6050_FusionReal value) {
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+	return (double)value / (double)((int32_t)1 << MPU6050_FUSION_Q);
+#else
+	return value;
+#endif
+}
+
+uint8_t MPU6050_BenchFusionRunAll(MPU6050_BenchFusionResult *results) {
+	static const char *names[MPU6050_BENCH_FUSION_FILTERS] = {"mahony", "madgwick", "complementary"};
+	MPU6050_Fusion fusion;
+
+	MPU6050_BenchFusionRecord();
+
+	for(uint8_t filter = 0; filter < MPU6050_BENCH_FUSION_FILTERS; filter++){
+		MPU6050_BenchFusionResult *r = &results[filter];
+		double sumError2 = 0.0;
+		double sumLinear2 = 0.0;
+
+		memset(r, 0, sizeof(*r));
+		r->name = names[filter];
+		r->updates = MPU6050_BENCH_FUSION_SAMPLES;
+
+		// Timed pass
+		MPU6050_FusionInit(&fusion, filter);
+		uint64_t cpuStart = MPU6050_BenchCpuNs();
+		for(uint32_t i = 0; i < MPU6050_BENCH_FUSION_SAMPLES; i++){
+			MPU6050_FusionUpdate(&fusion, &benchFusionAccel[i], &benchFusionRota[i], benchFusionTime[i]);
+		}
+		r->cpuTimeNs = (double)(MPU6050_BenchCpuNs() - cpuStart) / MPU6050_BENCH_FUSION_SAMPLES;
+
+		// Accuracy pass
+		MPU6050_FusionInit(&fusion, filter);
+		for(uint32_t i = 0; i < MPU6050_BENCH_FUSION_SAMPLES; i++){
+			MPU6050_Quaternion q;
+			MPU6050_LinearAccel linAccel;
+
+			MPU6050_FusionUpdate(&fusion, &benchFusionAccel[i], &benchFusionRota[i], benchFusionTime[i]);
+			MPU6050_FusionGetQuaternion(&fusion, &q);
+			MPU6050_FusionGetLinearAccel(&fusion, &benchFusionAccel[i], &linAccel);
+
+			double *truth = benchFusionTruth[i];
+			double dot = fabs(MPU6050_BenchFusionReal(q.w) * truth[0] + MPU6050_BenchFusionReal(q.x) * truth[1] +
+							  MPU6050_BenchFusionReal(q.y) * truth[2] + MPU6050_BenchFusionReal(q.z) * truth[3]);
+			double error = 2.0 * acos(dot > 1.0 ? 1.0 : dot) * (180.0 / M_PI);
+
+			sumError2 += error * error;
+			if(error > r->maxErrorDeg){
+				r->maxErrorDeg = error;
+			}
+			sumLinear2 += (double)linAccel.x * linAccel.x + (double)linAccel.y * linAccel.y + (double)linAccel.z * linAccel.z;
+		}
+		r->rmsErrorDeg = sqrt(sumError2 / MPU6050_BENCH_FUSION_SAMPLES);
+		r->rmsLinearAccel = sqrt(sumLinear2 / MPU6050_BENCH_FUSION_SAMPLES);
+	}
+
+	return MPU6050_BENCH_FUSION_FILTERS;
+}
+
+void MPU6050_BenchWriteFusionJson(FILE *out, const MPU6050_BenchFusionResult *results, uint8_t numResults) {
+	fprintf(out, "{\n");
+	fprintf(out, "  \"conversion\": \"%s\",\n", (MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED) ? "fixed" : "float");
+	fprintf(out, "  \"fusion\": [\n");
+
+	for(uint8_t i = 0; i < numResults; i++){
+		const MPU6050_BenchFusionResult *r = &results[i];
+
+		fprintf(out, "    {\"filter\": \"%s\", \"updates\": %u, ", r->name, (unsigned)r->updates);
+		fprintf(out, "\"rms_error_deg\": %.4f, \"max_error_deg\": %.4f, \"rms_linear_accel\": %.4f, ", r->rmsErrorDeg, r->maxErrorDeg, r->rmsLinearAccel);
+		fprintf(out, "\"cpu_time_ns\": %.1f}%s\n", r->cpuTimeNs, (i + 1 < numResults) ? "," : "");
+	}
+
+	fprintf(out, "  ]\n}\n");
+}
+
+// Filter banks at 1 kHz: Butterworth low-pass at 100 Hz, notch at the vibration, decimation to 250 Hz
+#define BENCH_FILTER_CHANNELS		6
+#define BENCH_FILTER_RATE_HZ		1000.0
+#define BENCH_FILTER_TAPS			48
+#define BENCH_FILTER_AMPLITUDE		8000.0	// LSB
+
+static MPU6050_FilterData benchFilterData[BENCH_FILTER_CHANNELS][MPU6050_BENCH_FILTER_SAMPLES];
+
+static void MPU6050_BenchFilterTone(double freqHz) {
+	for(uint32_t i = 0; i < MPU6050_BENCH_FILTER_SAMPLES; i++){
+		double value = BENCH_FILTER_AMPLITUDE * sin(2.0 * M_PI * freqHz * i / BENCH_FILTER_RATE_HZ);
+
+		for(uint8_t ch = 0; ch < BENCH_FILTER_CHANNELS; ch++){
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+			benchFilterData[ch][i] = (int16_t)lrint(value);
+#else
+			benchFilterData[ch][i] = (float)(value / BENCH_FILTER_AMPLITUDE);
+#endif
+		}
+	}
+}
+
+// Amplitude of the second half of the output (after the transient), in dB of the input
+static double MPU6050_BenchFilterGainDb(MPU6050_FilterBank *bank, double freqHz) {
+	MPU6050_FilterData *data[BENCH_FILTER_CHANNELS];
+	double sum2 = 0.0;
+
+	for(uint8_t ch = 0; ch < BENCH_FILTER_CHANNELS; ch++){
+		data[ch] = benchFilterData[ch];
+	}
+
+	MPU6050_BenchFilterTone(freqHz);
+	MPU6050_FilterReset(bank);
+	uint32_t outCount = MPU6050_FilterProcess(bank, data, MPU6050_BENCH_FILTER_SAMPLES);
+
+	for(uint32_t i = outCount / 2; i < outCount; i++){
+		sum2 += (double)data[0][i] * data[0][i];
+	}
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+	double amplitude = sqrt(2.0 * sum2 / (outCount - outCount / 2)) / BENCH_FILTER_AMPLITUDE;
+#else
+	double amplitude = sqrt(2.0 * sum2 / (outCount - outCount / 2));
+#endif
+	return 20.0 * log10(amplitude + 1e-12);
+}
+
+uint8_t MPU6050_BenchFilterRunAll(MPU6050_BenchFilterResult *results) {
+	static const char *names[MPU6050_BENCH_FILTER_CASES] = {"lowpass2", "lowpass4", "lowpass4_notch", "lowpass4_notch_decim4"};
+	static const uint8_t orders[MPU6050_BENCH_FILTER_CASES] = {2, 4, 4, 4};
+	MPU6050_Biquad stages[MPU6050_FILTER_MAX_STAGES];
+	float taps[BENCH_FILTER_TAPS];
+	MPU6050_FilterBank bank;
+	MPU6050_FilterData *data[BENCH_FILTER_CHANNELS];
+
+	MPU6050_FilterDesignDecimator(taps, BENCH_FILTER_TAPS, 4);
+	for(uint8_t ch = 0; ch < BENCH_FILTER_CHANNELS; ch++){
+		data[ch] = benchFilterData[ch];
+	}
+
+	for(uint8_t c = 0; c < MPU6050_BENCH_FILTER_CASES; c++){
+		MPU6050_BenchFilterResult *r = &results[c];
+		MPU6050_FilterConfig filterConfig = {.numChannels = BENCH_FILTER_CHANNELS};
+		uint8_t numStages = MPU6050_FilterDesignButterworth(stages, orders[c], 100.0f, (float)BENCH_FILTER_RATE_HZ);
+
+		if(c >= 2){
+			MPU6050_FilterDesignNotch(&stages[numStages++], (float)MPU6050_BENCH_FILTER_STOP_HZ, (float)BENCH_FILTER_RATE_HZ, 5.0f);
+		}
+		if(c >= 3){
+			filterConfig.decimation = 4;
+			filterConfig.numTaps = BENCH_FILTER_TAPS;
+			filterConfig.taps = taps;
+		}
+		for(uint8_t ch = 0; ch < BENCH_FILTER_CHANNELS; ch++){
+			filterConfig.axis[ch].numStages = numStages;
+			filterConfig.axis[ch].stages = stages;
+		}
+		MPU6050_FilterInit(&bank, &filterConfig);
+
+		memset(r, 0, sizeof(*r));
+		r->name = names[c];
+		r->channels = BENCH_FILTER_CHANNELS;
+		r->stages = numStages;
+		r->decimation = (filterConfig.decimation > 1) ? filterConfig.decimation : 1;
+		r->taps = filterConfig.numTaps;
+		r->samples = MPU6050_BENCH_FILTER_SAMPLES;
+
+		// Timed pass in blocks of a 1 KiB FIFO (73 frames)
+		MPU6050_BenchFilterTone(MPU6050_BENCH_FILTER_PASS_HZ);
+		MPU6050_FilterReset(&bank);
+		uint64_t cpuStart = MPU6050_BenchCpuNs();
+		for(uint32_t offset = 0; offset < MPU6050_BENCH_FILTER_SAMPLES; offset += 73){
+			MPU6050_FilterData *block[BENCH_FILTER_CHANNELS];
+			uint32_t len = MPU6050_BENCH_FILTER_SAMPLES - offset;
+
+			for(uint8_t ch = 0; ch < BENCH_FILTER_CHANNELS; ch++){
+				block[ch] = &data[ch][offset];
+			}
+			MPU6050_FilterProcess(&bank, block, (len < 73) ? len : 73);
+		}
+		r->cpuTimeNs = (double)(MPU6050_BenchCpuNs() - cpuStart) / MPU6050_BENCH_FILTER_SAMPLES;
+
+		r->passGainDb = MPU6050_BenchFilterGainDb(&bank, MPU6050_BENCH_FILTER_PASS_HZ);
+		r->stopGainDb = MPU6050_BenchFilterGainDb(&bank, MPU6050_BENCH_FILTER_STOP_HZ);
+	}
+
+	return MPU6050_BENCH_FILTER_CASES;
+}
+
+void MPU6050_BenchWriteFilterJson(FILE *out, const MPU6050_BenchFilterResult *results, uint8_t numResults) {
+	fprintf(out, "{\n");
+	fprintf(out, "  \"conversion\": \"%s\",\n", (MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED) ? "fixed" : "float");
+	fprintf(out, "  \"filters\": [\n");
+
+	for(uint8_t i = 0; i < numResults; i++){
+		const MPU6050_BenchFilterResult *r = &results[i];
+
+		fprintf(out, "    {\"filter\": \"%s\", \"channels\": %u, \"stages\": %u, \"decimation\": %u, \"taps\": %u, \"samples\": %u, ",
+				r->name, (unsigned)r->channels, (unsigned)r->stages, (unsigned)r->decimation, (unsigned)r->taps, (unsigned)r->samples);
+		fprintf(out, "\"pass_gain_db\": %.2f, \"stop_gain_db\": %.1f, ", r->passGainDb, r->stopGainDb);
+		fprintf(out, "\"cpu_time_ns\": %.1f}%s\n", r->cpuTimeNs, (i + 1 < numResults) ? "," : "");
+	}
+
+	fprintf(out, "  ]\n}\n");
+}
+
+#endif
@@ -0,0 +1,510 @@
+#define _GNU_SOURCE
+#include "MPU6050_CAPTURE.h"
+
+#include <string.h>
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define MPU6050_CAPTURE_SYNC_0		'B'
+#define MPU6050_CAPTURE_SYNC_1		'K'
+
+static void MPU6050_CapturePut16(uint8_t *dst, uint16_t value) {
+	dst[0] = (uint8_t)(value & LOW_BYTE_MASK);
+	dst[1] = (uint8_t)(value >> 8);
+}
+
+static void MPU6050_CapturePut32(uint8_t *dst, uint32_t value) {
+	MPU6050_CapturePut16(dst, (uint16_t)(value & 0xFFFF));
+	MPU6050_CapturePut16(dst + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t MPU6050_CaptureGet16(const uint8_t *src) {
+	return (uint16_t)(src[0] | ((uint16_t)src[1] << 8));
+}
+
+static uint32_t MPU6050_CaptureGet32(const uint8_t *src) {
+	return MPU6050_CaptureGet16(src) | ((uint32_t)MPU6050_CaptureGet16(src + 2) << 16);
+}
+
+static uint8_t MPU6050_CapturePutVarint(uint8_t *dst, uint32_t value) {
+	uint8_t len = 0;
+
+	while(value >= 0x80){
+		dst[len++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	dst[len++] = (uint8_t)value;
+
+	return len;
+}
+
+// Small magnitudes of either sign give small codes: 0, -1, 1, -2... -> 0, 1, 2, 3...
+static uint32_t MPU6050_CaptureZigzag(int32_t value) {
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t MPU6050_CaptureUnzigzag(uint32_t value) {
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Sums reduced every 256 bytes, far from the 32-bit overflow
+static uint16_t MPU6050_CaptureFletcher16(const uint8_t *data, uint16_t len) {
+	uint32_t sum1 = 0;
+	uint32_t sum2 = 0;
+
+	while(len > 0){
+		uint16_t chunk = (len > 256) ? 256 : len;
+		len -= chunk;
+		while(chunk-- > 0){
+			sum1 += *data++;
+			sum2 += sum1;
+		}
+		sum1 %= 255;
+		sum2 %= 255;
+	}
+
+	return (uint16_t)((sum2 << 8) | sum1);
+}
+
+// One bit per channel in burst order (AX AY AZ T GX GY GZ)
+static uint8_t MPU6050_CaptureChannelMask(uint8_t channels) {
+	uint8_t mask = 0;
+
+	if(channels & MPU6050_CAPTURE_ACCEL){
+		mask |= 0b0000111;
+	}
+	if(channels & MPU6050_CAPTURE_TEMP){
+		mask |= 0b0001000;
+	}
+	if(channels & MPU6050_CAPTURE_GYRO){
+		mask |= 0b1110000;
+	}
+	return mask;
+}
+
+uint8_t MPU6050_CaptureWriterInit(MPU6050_CaptureWriter *writer, uint8_t *buffer, uint32_t bufferSize, MPU6050_CaptureSinkFn sink, void *context) {
+	uint32_t blockSize = bufferSize / 2;
+
+	if(blockSize > MPU6050_CAPTURE_MAX_BLOCK_LEN){
+		blockSize = MPU6050_CAPTURE_MAX_BLOCK_LEN;
+	}
+	if(blockSize < MPU6050_CAPTURE_BLOCK_HEADER_LEN + MPU6050_CAPTURE_MAX_FRAME_LEN){
+		return ERR_CAPTURE_BUFFER;
+	}
+
+	memset(writer, 0, sizeof(*writer));
+	writer->buffer = buffer;
+	writer->blockSize = (uint16_t)blockSize;
+	writer->block = buffer;
+	writer->sink = sink;
+	writer->context = context;
+
+	return CAPTURE_OK;
+}
+
+// Writes the file header from the registers of the configuration structure
+uint8_t MPU6050_CaptureBegin(MPU6050_CaptureWriter *writer, MPU6050_ConfigTypeDef *config, uint8_t channels) {
+	uint8_t header[MPU6050_CAPTURE_HEADER_LEN] = {0};
+
+	if(0 == channels || (channels & (uint8_t)~MPU6050_CAPTURE_ALL)){
+		return ERR_CAPTURE_FORMAT;
+	}
+
+	writer->channels = MPU6050_CaptureChannelMask(channels);
+	writer->periodUs = MPU6050_GetSamplePeriodUs(config);
+	writer->blockLen = 0;
+
+	memcpy(header, MPU6050_CAPTURE_MAGIC, 4);
+	header[4] = MPU6050_CAPTURE_VERSION;
+	header[5] = MPU6050_CAPTURE_HEADER_LEN;
+	header[6] = channels;
+	header[7] = config->address;
+	header[8] = config->smplRateDivConfig;
+	header[9] = config->dlpfFsyncConfig;
+	header[10] = config->gyroConfig;
+	header[11] = config->accelConfig;
+	header[12] = config->pwrMgmt1Config;
+	header[13] = config->pwrMgmt2Config;
+	header[14] = config->fifoEnConfig;
+	header[15] = config->intPinConfig;
+	header[16] = config->intEnableConfig;
+	MPU6050_CapturePut16(&header[18], MPU6050_GetAccelSensitivity(config));
+	MPU6050_CapturePut16(&header[20], (uint16_t)(MPU6050_GetGyroSensitivty(config) * 10.0f + 0.5f));
+	MPU6050_CapturePut32(&header[22], writer->periodUs);
+
+	if(!writer->sink(writer->context, header, sizeof(header))){
+		return ERR_CAPTURE_SINK;
+	}
+	writer->bytes += sizeof(header);
+
+	return CAPTURE_OK;
+}
+
+// Hands the block being filled to the sink and continues in the other half of the buffer
+uint8_t MPU6050_CaptureFlush(MPU6050_CaptureWriter *writer) {
+	uint8_t *block = writer->block;
+	uint16_t payloadLen = writer->blockLen - MPU6050_CAPTURE_BLOCK_HEADER_LEN;
+
+	if(writer->blockLen <= MPU6050_CAPTURE_BLOCK_HEADER_LEN){
+		return CAPTURE_OK;
+	}
+
+	block[0] = MPU6050_CAPTURE_SYNC_0;
+	block[1] = MPU6050_CAPTURE_SYNC_1;
+	MPU6050_CapturePut16(&block[2], payloadLen);
+	MPU6050_CapturePut16(&block[4], writer->blockFrames);
+	MPU6050_CapturePut16(&block[10], MPU6050_CaptureFletcher16(&block[MPU6050_CAPTURE_BLOCK_HEADER_LEN], payloadLen));
+
+	uint8_t accepted = writer->sink(writer->context, block, writer->blockLen);
+
+	writer->block = (block == writer->buffer) ? writer->buffer + writer->blockSize : writer->buffer;
+	writer->blockLen = 0;
+
+	if(!accepted){
+		writer->droppedBlocks++;
+		return ERR_CAPTURE_SINK;
+	}
+	writer->bytes += MPU6050_CAPTURE_BLOCK_HEADER_LEN + payloadLen;
+
+	return CAPTURE_OK;
+}
+
+uint8_t MPU6050_CaptureWriteRaw(MPU6050_CaptureWriter *writer, const int16_t raw[MPU6050_CAPTURE_CHANNELS], uint32_t timestampUs) {
+	uint8_t status = CAPTURE_OK;
+
+	if(writer->blockLen + MPU6050_CAPTURE_MAX_FRAME_LEN > writer->blockSize){
+		status = MPU6050_CaptureFlush(writer);
+	}
+
+	// Every block starts from zero, so it can be decoded on its own
+	if(0 == writer->blockLen){
+		writer->blockLen = MPU6050_CAPTURE_BLOCK_HEADER_LEN;
+		writer->blockFrames = 0;
+		memset(writer->prev, 0, sizeof(writer->prev));
+		writer->prevStepUs = (int32_t)writer->periodUs;
+		writer->prevTimestampUs = timestampUs - writer->periodUs;
+		MPU6050_CapturePut32(&writer->block[6], timestampUs);
+	}
+
+	uint8_t *dst = &writer->block[writer->blockLen];
+	uint8_t len = 0;
+
+	int32_t stepUs = (int32_t)(timestampUs - writer->prevTimestampUs);
+	len += MPU6050_CapturePutVarint(&dst[len], MPU6050_CaptureZigzag(stepUs - writer->prevStepUs));
+	writer->prevStepUs = stepUs;
+	writer->prevTimestampUs = timestampUs;
+
+	for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+		if(writer->channels & (1 << i)){
+			// The 16-bit difference wraps around, at most 3 bytes
+			int16_t delta = (int16_t)(uint16_t)((uint16_t)raw[i] - (uint16_t)writer->prev[i]);
+			len += MPU6050_CapturePutVarint(&dst[len], MPU6050_CaptureZigzag(delta));
+			writer->prev[i] = raw[i];
+		}
+	}
+
+	writer->blockLen += len;
+	writer->blockFrames++;
+	writer->frames++;
+
+	return status;
+}
+
+uint8_t MPU6050_CaptureWriteSample(MPU6050_CaptureWriter *writer, const MPU6050_Accelerations *accel, const MPU6050_Rotations *rota, const MPU6050_Temperature *temp) {
+	int16_t raw[MPU6050_CAPTURE_CHANNELS] = {0};
+	uint32_t timestampUs = 0;
+
+	if(temp != NULL){
+		raw[3] = temp->rawTemp;
+		timestampUs = temp->timestampUs;
+	}
+	if(rota != NULL){
+		raw[4] = rota->rawRotaX;
+		raw[5] = rota->rawRotaY;
+		raw[6] = rota->rawRotaZ;
+		timestampUs = rota->timestampUs;
+	}
+	if(accel != NULL){
+		raw[0] = accel->rawAccelX;
+		raw[1] = accel->rawAccelY;
+		raw[2] = accel->rawAccelZ;
+		timestampUs = accel->timestampUs;
+	}
+
+	return MPU6050_CaptureWriteRaw(writer, raw, timestampUs);
+}
+
+uint8_t MPU6050_CaptureReaderInit(MPU6050_CaptureReader *reader, const uint8_t *data, size_t size) {
+	MPU6050_CaptureHeader *header = &reader->header;
+
+	memset(reader, 0, sizeof(*reader));
+
+	if(size < MPU6050_CAPTURE_HEADER_LEN || memcmp(data, MPU6050_CAPTURE_MAGIC, 4) != 0 ||
+	   data[4] > MPU6050_CAPTURE_VERSION || data[5] < MPU6050_CAPTURE_HEADER_LEN || data[5] > size){
+		return ERR_CAPTURE_FORMAT;
+	}
+
+	reader->data = data;
+	reader->size = size;
+
+	header->version = data[4];
+	header->channels = data[6];
+	header->address = data[7];
+	header->smplRateDivConfig = data[8];
+	header->dlpfFsyncConfig = data[9];
+	header->gyroConfig = data[10];
+	header->accelConfig = data[11];
+	header->pwrMgmt1Config = data[12];
+	header->pwrMgmt2Config = data[13];
+	header->fifoEnConfig = data[14];
+	header->intPinConfig = data[15];
+	header->intEnableConfig = data[16];
+	header->accelLsbPerG = MPU6050_CaptureGet16(&data[18]);
+	header->gyroLsbPerDps10 = MPU6050_CaptureGet16(&data[20]);
+	header->samplePeriodUs = MPU6050_CaptureGet32(&data[22]);
+
+	// Later versions may extend the header
+	reader->pos = data[5];
+	reader->blockEnd = reader->pos;
+
+	return CAPTURE_OK;
+}
+
+static uint8_t MPU6050_CaptureBlockValid(MPU6050_CaptureReader *reader, size_t offset) {
+	const uint8_t *block = &reader->data[offset];
+
+	if(offset + MPU6050_CAPTURE_BLOCK_HEADER_LEN > reader->size ||
+	   block[0] != MPU6050_CAPTURE_SYNC_0 || block[1] != MPU6050_CAPTURE_SYNC_1){
+		return FALSE;
+	}
+
+	uint16_t payloadLen = MPU6050_CaptureGet16(&block[2]);
+	if(offset + MPU6050_CAPTURE_BLOCK_HEADER_LEN + payloadLen > reader->size){
+		return FALSE;
+	}
+
+	return MPU6050_CaptureGet16(&block[10]) == MPU6050_CaptureFletcher16(&block[MPU6050_CAPTURE_BLOCK_HEADER_LEN], payloadLen);
+}
+
+static void MPU6050_CaptureOpenBlock(MPU6050_CaptureReader *reader, size_t offset) {
+	const uint8_t *block = &reader->data[offset];
+	uint32_t periodUs = reader->header.samplePeriodUs;
+
+	reader->framesLeft = MPU6050_CaptureGet16(&block[4]);
+	reader->pos = offset + MPU6050_CAPTURE_BLOCK_HEADER_LEN;
+	reader->blockEnd = reader->pos + MPU6050_CaptureGet16(&block[2]);
+	memset(reader->prev, 0, sizeof(reader->prev));
+	reader->prevStepUs = (int32_t)periodUs;
+	reader->prevTimestampUs = MPU6050_CaptureGet32(&block[6]) - periodUs;
+}
+
+// Positions the reader on the first valid block at or after offset (e.g. to split a file in chunks)
+uint8_t MPU6050_CaptureSeek(MPU6050_CaptureReader *reader, size_t offset) {
+	size_t start = reader->data[5];
+
+	reader->framesLeft = 0;
+	for(offset = (offset > start) ? offset : start; offset + MPU6050_CAPTURE_BLOCK_HEADER_LEN <= reader->size; offset++){
+		if(MPU6050_CaptureBlockValid(reader, offset)){
+			MPU6050_CaptureOpenBlock(reader, offset);
+			return CAPTURE_OK;
+		}
+	}
+
+	reader->pos = reader->size;
+	reader->blockEnd = reader->size;
+
+	return ERR_CAPTURE_END;
+}
+
+static uint8_t MPU6050_CaptureGetVarint(MPU6050_CaptureReader *reader, uint32_t *value) {
+	*value = 0;
+
+	for(uint8_t shift = 0; shift < 35 && reader->pos < reader->blockEnd; shift += 7){
+		uint8_t byte = reader->data[reader->pos++];
+		*value |= (uint32_t)(byte & 0x7F) << shift;
+		if(!(byte & 0x80)){
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+uint8_t MPU6050_CaptureReadFrame(MPU6050_CaptureReader *reader, MPU6050_CaptureFrame *frame) {
+	uint8_t channels = MPU6050_CaptureChannelMask(reader->header.channels);
+	uint32_t code;
+
+	while(1){
+		while(0 == reader->framesLeft){
+			if(reader->blockEnd >= reader->size){
+				return ERR_CAPTURE_END;
+			}
+			if(MPU6050_CaptureBlockValid(reader, reader->blockEnd)){
+				MPU6050_CaptureOpenBlock(reader, reader->blockEnd);
+			}
+			else{
+				reader->corruptBlocks++;
+				if(CAPTURE_OK != MPU6050_CaptureSeek(reader, reader->blockEnd + 1)){
+					return ERR_CAPTURE_END;
+				}
+			}
+		}
+
+		uint8_t valid = MPU6050_CaptureGetVarint(reader, &code);
+		int32_t stepUs = reader->prevStepUs + MPU6050_CaptureUnzigzag(code);
+
+		for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+			frame->raw[i] = 0;
+			if(valid && (channels & (1 << i))){
+				valid = MPU6050_CaptureGetVarint(reader, &code);
+				reader->prev[i] = (int16_t)(uint16_t)((uint16_t)reader->prev[i] + (uint16_t)MPU6050_CaptureUnzigzag(code));
+				frame->raw[i] = reader->prev[i];
+			}
+		}
+
+		// A block whose checksum matched cannot be malformed unless written by another encoder
+		if(!valid){
+			reader->corruptBlocks++;
+			reader->framesLeft = 0;
+			continue;
+		}
+
+		reader->prevStepUs = stepUs;
+		reader->prevTimestampUs += (uint32_t)stepUs;
+		frame->timestampUs = reader->prevTimestampUs;
+		reader->framesLeft--;
+		reader->frames++;
+
+		return CAPTURE_OK;
+	}
+}
+
+// Registers of the capture, so the conversion of a replay matches the recording bit for bit
+void MPU6050_CaptureApplyHeader(const MPU6050_CaptureHeader *header, MPU6050_ConfigTypeDef *config) {
+	config->address = header->address;
+	config->smplRateDivConfig = header->smplRateDivConfig;
+	config->dlpfFsyncConfig = header->dlpfFsyncConfig;
+	config->gyroConfig = header->gyroConfig;
+	config->accelConfig = header->accelConfig;
+	config->pwrMgmt1Config = header->pwrMgmt1Config;
+	config->pwrMgmt2Config = header->pwrMgmt2Config;
+	MPU6050_UpdateScales(config);
+}
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+
+static void MPU6050_CaptureReplayLoad(MPU6050_CaptureReplay *replay) {
+	for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+		replay->regs[REG_ACCEL_XOUT_H + 2 * i] = (uint8_t)((uint16_t)replay->next.raw[i] >> 8);
+		replay->regs[REG_ACCEL_XOUT_H + 2 * i + 1] = (uint8_t)(replay->next.raw[i] & LOW_BYTE_MASK);
+	}
+	replay->nextValid = (CAPTURE_OK == MPU6050_CaptureReadFrame(&replay->reader, &replay->next));
+}
+
+static HAL_StatusTypeDef MPU6050_CaptureReplayRead(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	MPU6050_CaptureReplay *replay = (MPU6050_CaptureReplay *)hi2c->context;
+	(void)address;
+
+	// A read of the output registers is a new sample
+	if(reg <= REG_GYRO_ZOUT_L && reg + len > REG_ACCEL_XOUT_H){
+		if(!replay->nextValid){
+			return HAL_ERROR;
+		}
+		MPU6050_CaptureReplayLoad(replay);
+	}
+
+	for(uint16_t i = 0; i < len; i++){
+		data[i] = (reg + i < MPU6050_CAPTURE_REPLAY_REGS) ? replay->regs[reg + i] : 0;
+	}
+
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef MPU6050_CaptureReplayWrite(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	MPU6050_CaptureReplay *replay = (MPU6050_CaptureReplay *)hi2c->context;
+	(void)address;
+
+	for(uint16_t i = 0; i < len && reg + i < MPU6050_CAPTURE_REPLAY_REGS; i++){
+		uint8_t r = (uint8_t)(reg + i);
+		if((r >= REG_ACCEL_XOUT_H && r <= REG_GYRO_ZOUT_L) || REG_WHO_AM_I == r){
+			continue;
+		}
+		// The reset completes at once, the register file keeps the recorded configuration
+		replay->regs[r] = (REG_PWR_MGMT_1 == r) ? (uint8_t)(data[i] & (uint8_t)~DEVICE_RESET_CONFIG_SET) : data[i];
+	}
+
+	return HAL_OK;
+}
+
+const MPU6050_Transport MPU6050_CaptureReplayTransport = {
+	.read = MPU6050_CaptureReplayRead,
+	.write = MPU6050_CaptureReplayWrite,
+	.readBlocks = NULL,
+	.startRead = NULL
+};
+
+uint8_t MPU6050_CaptureReplayInit(MPU6050_CaptureReplay *replay, const uint8_t *data, size_t size) {
+	uint8_t status = MPU6050_CaptureReaderInit(&replay->reader, data, size);
+	MPU6050_CaptureHeader *header = &replay->reader.header;
+
+	if(status != CAPTURE_OK){
+		return status;
+	}
+
+	memset(replay->regs, 0, sizeof(replay->regs));
+	replay->regs[REG_SMPLRT_DIV] = header->smplRateDivConfig;
+	replay->regs[REG_CONFIG] = header->dlpfFsyncConfig;
+	replay->regs[REG_GYRO_CONFIG] = header->gyroConfig;
+	replay->regs[REG_ACCEL_CONFIG] = header->accelConfig;
+	replay->regs[REG_FIFO_EN] = header->fifoEnConfig;
+	replay->regs[REG_INT_PIN_CFG] = header->intPinConfig;
+	replay->regs[REG_INT_ENABLE] = header->intEnableConfig;
+	replay->regs[REG_PWR_MGMT_1] = header->pwrMgmt1Config;
+	replay->regs[REG_PWR_MGMT_2] = header->pwrMgmt2Config;
+	replay->regs[REG_WHO_AM_I] = MPU6050_WHO_AM_I_VALUE;
+
+	replay->nextValid = (CAPTURE_OK == MPU6050_CaptureReadFrame(&replay->reader, &replay->next));
+
+	return CAPTURE_OK;
+}
+
+// Timestamp of the frame the next sensor read returns, for a config->clock replaying the recorded times
+uint32_t MPU6050_CaptureReplayNextTimestampUs(MPU6050_CaptureReplay *replay) {
+	return replay->nextValid ? replay->next.timestampUs : replay->reader.prevTimestampUs;
+}
+
+// Read-only private mapping, NULL on error
+const uint8_t *MPU6050_CaptureMapFile(const char *path, size_t *size) {
+	struct stat st;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if(fd < 0){
+		return NULL;
+	}
+	if(fstat(fd, &st) < 0 || 0 == st.st_size){
+		close(fd);
+		return NULL;
+	}
+
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(MAP_FAILED == data){
+		return NULL;
+	}
+
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+	*size = (size_t)st.st_size;
+
+	return (const uint8_t *)data;
+}
+
+void MPU6050_CaptureUnmapFile(const uint8_t *data, size_t size) {
+	munmap((void *)data, size);
+}
+
+#endif
@@ -0,0 +1,517 @@
+#include "MPU6050_FILTER.h"
+#include "MPU6050_BATCH.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(MPU6050_USE_CMSIS_DSP)
+  #include "arm_math.h"
+#elif defined(__AVX2__) || defined(__SSE2__)
+  #include <immintrin.h>
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
+
+#define FILTER_PI				3.14159265358979f
+#define FILTER_LANES			4		// Channels per SSE2 biquad pass
+
+// Coefficient design
+
+void MPU6050_FilterDesignLowpass(MPU6050_Biquad *stage, float cutoffHz, float sampleRateHz, float q) {
+	float w0 = 2.0f * FILTER_PI * cutoffHz / sampleRateHz;
+	float cosW0 = cosf(w0);
+	float alpha = sinf(w0) / (2.0f * q);
+	float a0 = 1.0f + alpha;
+
+	stage->b0 = (1.0f - cosW0) / (2.0f * a0);
+	stage->b1 = (1.0f - cosW0) / a0;
+	stage->b2 = stage->b0;
+	stage->a1 = 2.0f * cosW0 / a0;
+	stage->a2 = -(1.0f - alpha) / a0;
+}
+
+// Width between the -3 dB points: centerHz / q
+void MPU6050_FilterDesignNotch(MPU6050_Biquad *stage, float centerHz, float sampleRateHz, float q) {
+	float w0 = 2.0f * FILTER_PI * centerHz / sampleRateHz;
+	float cosW0 = cosf(w0);
+	float alpha = sinf(w0) / (2.0f * q);
+	float a0 = 1.0f + alpha;
+
+	stage->b0 = 1.0f / a0;
+	stage->b1 = -2.0f * cosW0 / a0;
+	stage->b2 = stage->b0;
+	stage->a1 = 2.0f * cosW0 / a0;
+	stage->a2 = -(1.0f - alpha) / a0;
+}
+
+// Even orders only, returns the number of stages written (0 if the order is not supported)
+uint8_t MPU6050_FilterDesignButterworth(MPU6050_Biquad *stages, uint8_t order, float cutoffHz, float sampleRateHz) {
+	if(0 == order || (order % 2) != 0 || order / 2 > MPU6050_FILTER_MAX_STAGES){
+		return 0;
+	}
+
+	for(uint8_t k = 0; k < order / 2; k++){
+		float q = 1.0f / (2.0f * cosf(FILTER_PI * (2 * k + 1) / (2.0f * order)));
+		MPU6050_FilterDesignLowpass(&stages[k], cutoffHz, sampleRateHz, q);
+	}
+	return order / 2;
+}
+
+// Blackman windowed sinc, cut-off at 80% of the output Nyquist frequency, unity DC gain
+void MPU6050_FilterDesignDecimator(float *taps, uint8_t numTaps, uint8_t decimation) {
+	float cutoff = 0.4f / ((decimation > 1) ? decimation : 1);
+	float sum = 0.0f;
+
+	if(numTaps < 2){
+		taps[0] = 1.0f;
+		return;
+	}
+
+	for(uint8_t n = 0; n < numTaps; n++){
+		float m = n - (numTaps - 1) / 2.0f;
+		float phase = 2.0f * FILTER_PI * n / (numTaps - 1);
+		float sinc = (0.0f == m) ? 2.0f * cutoff : sinf(2.0f * FILTER_PI * cutoff * m) / (FILTER_PI * m);
+
+		taps[n] = sinc * (0.42f - 0.5f * cosf(phase) + 0.08f * cosf(2.0f * phase));
+		sum += taps[n];
+	}
+	for(uint8_t n = 0; n < numTaps; n++){
+		taps[n] /= sum;
+	}
+}
+
+// Coefficient quantization
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+static int32_t MPU6050_FilterToFixed(float value, uint8_t fracBits, int32_t max) {
+	double scaled = (double)value * (double)((int64_t)1 << fracBits);
+	scaled += (scaled < 0.0) ? -0.5 : 0.5;
+
+	if(scaled >= (double)max){
+		return max;
+	}
+	if(scaled <= -(double)max - 1.0){
+		return -max - 1;
+	}
+	return (int32_t)scaled;
+}
+
+#define FILTER_COEFF(value)		MPU6050_FilterToFixed(value, 31 - MPU6050_FILTER_POST_SHIFT, INT32_MAX)
+#define FILTER_TAP(value)		((int16_t)MPU6050_FilterToFixed(value, 15, INT16_MAX))
+#else
+#define FILTER_COEFF(value)		(value)
+#define FILTER_TAP(value)		(value)
+#endif
+
+uint8_t MPU6050_FilterInit(MPU6050_FilterBank *bank, const MPU6050_FilterConfig *filterConfig) {
+	static const MPU6050_Biquad passThrough = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+	if(filterConfig->numChannels > MPU6050_FILTER_MAX_CHANNELS || filterConfig->numTaps > MPU6050_FILTER_MAX_TAPS){
+		return ERR_FILTER_CONFIG;
+	}
+	for(uint8_t ch = 0; ch < filterConfig->numChannels; ch++){
+		if(filterConfig->axis[ch].numStages > MPU6050_FILTER_MAX_STAGES){
+			return ERR_FILTER_CONFIG;
+		}
+	}
+
+	memset(bank, 0, sizeof(*bank));
+	bank->numChannels = filterConfig->numChannels;
+	bank->decimation = (filterConfig->decimation > 1) ? filterConfig->decimation : 1;
+
+	for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+		const MPU6050_FilterAxis *axis = &filterConfig->axis[ch];
+
+		bank->numStages[ch] = axis->numStages;
+		if(axis->numStages > bank->maxStages){
+			bank->maxStages = axis->numStages;
+		}
+
+		for(uint8_t s = 0; s < MPU6050_FILTER_MAX_STAGES; s++){
+			const MPU6050_Biquad *stage = (s < axis->numStages) ? &axis->stages[s] : &passThrough;
+
+			bank->coeffs[ch][5 * s] = FILTER_COEFF(stage->b0);
+			bank->coeffs[ch][5 * s + 1] = FILTER_COEFF(stage->b1);
+			bank->coeffs[ch][5 * s + 2] = FILTER_COEFF(stage->b2);
+			bank->coeffs[ch][5 * s + 3] = FILTER_COEFF(stage->a1);
+			bank->coeffs[ch][5 * s + 4] = FILTER_COEFF(stage->a2);
+		}
+	}
+
+	// Decimation without taps keeps every decimation-th sample
+	if(filterConfig->numTaps > 0){
+		bank->numTaps = filterConfig->numTaps;
+		for(uint8_t k = 0; k < bank->numTaps; k++){
+			bank->taps[k] = FILTER_TAP(filterConfig->taps[bank->numTaps - 1 - k]);
+		}
+	}
+	else if(bank->decimation > 1){
+		bank->numTaps = 1;
+		bank->taps[0] = FILTER_TAP(1.0f);
+	}
+
+	return FILTER_OK;
+}
+
+void MPU6050_FilterReset(MPU6050_FilterBank *bank) {
+	memset(bank->state, 0, sizeof(bank->state));
+	memset(bank->history, 0, sizeof(bank->history));
+	bank->phase = 0;
+}
+
+// Biquads
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+static void MPU6050_FilterBiquadsQ31(MPU6050_FilterBank *bank, uint8_t ch, int32_t *work, uint32_t len) {
+#if defined(MPU6050_USE_CMSIS_DSP)
+	arm_biquad_casd_df1_inst_q31 inst;
+	arm_biquad_cascade_df1_init_q31(&inst, bank->numStages[ch], (q31_t *)bank->coeffs[ch], (q31_t *)bank->state[ch], MPU6050_FILTER_POST_SHIFT);
+	arm_biquad_cascade_df1_q31(&inst, (q31_t *)work, (q31_t *)work, len);
+#else
+	// Same arithmetic as arm_biquad_cascade_df1_q31
+	for(uint8_t s = 0; s < bank->numStages[ch]; s++){
+		const int32_t *c = &bank->coeffs[ch][5 * s];
+		int32_t *state = &bank->state[ch][4 * s];
+		int32_t x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+
+		for(uint32_t i = 0; i < len; i++){
+			int32_t x = work[i];
+			int64_t acc = (int64_t)c[0] * x + (int64_t)c[1] * x1 + (int64_t)c[2] * x2 + (int64_t)c[3] * y1 + (int64_t)c[4] * y2;
+			int32_t y = (int32_t)(acc >> (31 - MPU6050_FILTER_POST_SHIFT));
+
+			x2 = x1;
+			x1 = x;
+			y2 = y1;
+			y1 = y;
+			work[i] = y;
+		}
+
+		state[0] = x1;
+		state[1] = x2;
+		state[2] = y1;
+		state[3] = y2;
+	}
+#endif
+}
+
+static void MPU6050_FilterBiquads(MPU6050_FilterBank *bank, MPU6050_FilterData *const block[], uint32_t len) {
+	int32_t work[MPU6050_FILTER_BLOCK];
+
+	for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+		if(0 == bank->numStages[ch]){
+			continue;
+		}
+
+		// Q15 to Q31 with 1 bit of headroom for the overshoot of the filters
+		for(uint32_t i = 0; i < len; i++){
+			work[i] = (int32_t)block[ch][i] * 32768;
+		}
+
+		MPU6050_FilterBiquadsQ31(bank, ch, work, len);
+
+		for(uint32_t i = 0; i < len; i++){
+			int32_t y = (int32_t)(((int64_t)work[i] + (1 << 14)) >> 15);
+			block[ch][i] = (int16_t)((y > INT16_MAX) ? INT16_MAX : (y < INT16_MIN) ? INT16_MIN : y);
+		}
+	}
+}
+#else
+#if defined(MPU6050_USE_CMSIS_DSP) || !defined(__SSE2__)
+static void MPU6050_FilterBiquadsF32(MPU6050_FilterBank *bank, uint8_t ch, float *data, uint32_t len) {
+#if defined(MPU6050_USE_CMSIS_DSP)
+	arm_biquad_cascade_df2T_instance_f32 inst;
+	arm_biquad_cascade_df2T_init_f32(&inst, bank->numStages[ch], bank->coeffs[ch], bank->state[ch]);
+	arm_biquad_cascade_df2T_f32(&inst, data, data, len);
+#else
+	for(uint8_t s = 0; s < bank->numStages[ch]; s++){
+		const float *c = &bank->coeffs[ch][5 * s];
+		float *state = &bank->state[ch][2 * s];
+		float d1 = state[0], d2 = state[1];
+
+		for(uint32_t i = 0; i < len; i++){
+			float x = data[i];
+			float y = c[0] * x + d1;
+
+			d1 = c[1] * x + c[3] * y + d2;
+			d2 = c[2] * x + c[4] * y;
+			data[i] = y;
+		}
+
+		state[0] = d1;
+		state[1] = d2;
+	}
+#endif
+}
+#else
+// One lane per channel: the recursion of each channel is serial, but 4 channels run together
+#define FILTER_STEP(x, s) \
+	do{ \
+		__m128 y = _mm_add_ps(_mm_mul_ps(c[5 * (s)], x), d1[s]); \
+		d1[s] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[5 * (s) + 1], x), _mm_mul_ps(c[5 * (s) + 3], y)), d2[s]); \
+		d2[s] = _mm_add_ps(_mm_mul_ps(c[5 * (s) + 2], x), _mm_mul_ps(c[5 * (s) + 4], y)); \
+		x = y; \
+	}while(0)
+
+static void MPU6050_FilterBiquadsX4(MPU6050_FilterBank *bank, uint8_t first, float *const block[], uint32_t len) {
+	float scratch[MPU6050_FILTER_BLOCK] = {0};
+	float lanes[FILTER_LANES][5 * MPU6050_FILTER_MAX_STAGES + 2 * MPU6050_FILTER_MAX_STAGES];
+	float *data[FILTER_LANES];
+	__m128 c[5 * MPU6050_FILTER_MAX_STAGES];
+	__m128 d1[MPU6050_FILTER_MAX_STAGES];
+	__m128 d2[MPU6050_FILTER_MAX_STAGES];
+	uint8_t numStages = 0;
+
+	// Missing lanes filter the scratch buffer with the pass-through stages
+	memset(lanes, 0, sizeof(lanes));
+	for(uint8_t l = 0; l < FILTER_LANES; l++){
+		uint8_t ch = first + l;
+
+		if(ch < bank->numChannels){
+			data[l] = block[ch];
+			memcpy(lanes[l], bank->coeffs[ch], sizeof(bank->coeffs[ch]));
+			memcpy(&lanes[l][5 * MPU6050_FILTER_MAX_STAGES], bank->state[ch], sizeof(bank->state[ch]));
+			if(bank->numStages[ch] > numStages){
+				numStages = bank->numStages[ch];
+			}
+		}
+		else{
+			data[l] = scratch;
+			for(uint8_t s = 0; s < MPU6050_FILTER_MAX_STAGES; s++){
+				lanes[l][5 * s] = 1.0f;
+			}
+		}
+	}
+
+	for(uint8_t s = 0; s < numStages; s++){
+		for(uint8_t k = 0; k < 5; k++){
+			c[5 * s + k] = _mm_setr_ps(lanes[0][5 * s + k], lanes[1][5 * s + k], lanes[2][5 * s + k], lanes[3][5 * s + k]);
+		}
+		uint8_t d = 5 * MPU6050_FILTER_MAX_STAGES + 2 * s;
+		d1[s] = _mm_setr_ps(lanes[0][d], lanes[1][d], lanes[2][d], lanes[3][d]);
+		d2[s] = _mm_setr_ps(lanes[0][d + 1], lanes[1][d + 1], lanes[2][d + 1], lanes[3][d + 1]);
+	}
+
+	uint32_t i = 0;
+	for(; i + 4 <= len; i += 4){
+		__m128 x0 = _mm_loadu_ps(&data[0][i]);
+		__m128 x1 = _mm_loadu_ps(&data[1][i]);
+		__m128 x2 = _mm_loadu_ps(&data[2][i]);
+		__m128 x3 = _mm_loadu_ps(&data[3][i]);
+
+		// Rows of samples to rows of channels
+		_MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+		for(uint8_t s = 0; s < numStages; s++){
+			FILTER_STEP(x0, s);
+		}
+		for(uint8_t s = 0; s < numStages; s++){
+			FILTER_STEP(x1, s);
+		}
+		for(uint8_t s = 0; s < numStages; s++){
+			FILTER_STEP(x2, s);
+		}
+		for(uint8_t s = 0; s < numStages; s++){
+			FILTER_STEP(x3, s);
+		}
+		_MM_TRANSPOSE4_PS(x0, x1, x2, x3);
+
+		_mm_storeu_ps(&data[0][i], x0);
+		_mm_storeu_ps(&data[1][i], x1);
+		_mm_storeu_ps(&data[2][i], x2);
+		_mm_storeu_ps(&data[3][i], x3);
+	}
+	for(; i < len; i++){
+		float out[FILTER_LANES];
+		__m128 x = _mm_setr_ps(data[0][i], data[1][i], data[2][i], data[3][i]);
+
+		for(uint8_t s = 0; s < numStages; s++){
+			FILTER_STEP(x, s);
+		}
+		_mm_storeu_ps(out, x);
+		for(uint8_t l = 0; l < FILTER_LANES; l++){
+			data[l][i] = out[l];
+		}
+	}
+
+	// Only the stages of each channel keep a state
+	for(uint8_t l = 0; l < FILTER_LANES && first + l < bank->numChannels; l++){
+		uint8_t ch = first + l;
+		float out1[FILTER_LANES], out2[FILTER_LANES];
+
+		for(uint8_t s = 0; s < bank->numStages[ch]; s++){
+			_mm_storeu_ps(out1, d1[s]);
+			_mm_storeu_ps(out2, d2[s]);
+			bank->state[ch][2 * s] = out1[l];
+			bank->state[ch][2 * s + 1] = out2[l];
+		}
+	}
+}
+#endif
+
+static void MPU6050_FilterBiquads(MPU6050_FilterBank *bank, MPU6050_FilterData *const block[], uint32_t len) {
+#if !defined(MPU6050_USE_CMSIS_DSP) && defined(__SSE2__)
+	for(uint8_t first = 0; first < bank->numChannels; first += FILTER_LANES){
+		MPU6050_FilterBiquadsX4(bank, first, block, len);
+	}
+#else
+	for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+		MPU6050_FilterBiquadsF32(bank, ch, block[ch], len);
+	}
+#endif
+}
+#endif
+
+// Decimator
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+// Requires a sum of |taps| below 2 (any low-pass) when the int32 SIMD lanes are used
+static int16_t MPU6050_FilterDot(const int16_t *taps, const int16_t *data, uint8_t len) {
+	int64_t acc = 0;
+	uint8_t i = 0;
+
+#if defined(MPU6050_USE_CMSIS_DSP)
+	q63_t result;
+	arm_dot_prod_q15((q15_t *)taps, (q15_t *)data, len, &result);
+	acc = result;
+	i = len;
+#elif defined(__SSE2__)
+	__m128i sum = _mm_setzero_si128();
+	int32_t lanes[4];
+	for(; i + 8 <= len; i += 8){
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&taps[i]), _mm_loadu_si128((const __m128i *)&data[i])));
+	}
+	_mm_storeu_si128((__m128i *)lanes, sum);
+	acc = (int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__ARM_NEON)
+	int32x4_t sum = vdupq_n_s32(0);
+	for(; i + 4 <= len; i += 4){
+		sum = vmlal_s16(sum, vld1_s16(&taps[i]), vld1_s16(&data[i]));
+	}
+	acc = (int64_t)vgetq_lane_s32(sum, 0) + vgetq_lane_s32(sum, 1) + vgetq_lane_s32(sum, 2) + vgetq_lane_s32(sum, 3);
+#endif
+
+	for(; i < len; i++){
+		acc += (int32_t)taps[i] * data[i];
+	}
+
+	acc = (acc + (1 << 14)) >> 15;
+	return (int16_t)((acc > INT16_MAX) ? INT16_MAX : (acc < INT16_MIN) ? INT16_MIN : acc);
+}
+#else
+static float MPU6050_FilterDot(const float *taps, const float *data, uint8_t len) {
+	float acc = 0.0f;
+	uint8_t i = 0;
+
+#if defined(MPU6050_USE_CMSIS_DSP)
+	arm_dot_prod_f32((float32_t *)taps, (float32_t *)data, len, &acc);
+	i = len;
+#elif defined(__AVX2__)
+	__m256 sum = _mm256_setzero_ps();
+	float lanes[8];
+	for(; i + 8 <= len; i += 8){
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(&taps[i]), _mm256_loadu_ps(&data[i])));
+	}
+	_mm256_storeu_ps(lanes, sum);
+	acc = ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+#elif defined(__SSE2__)
+	__m128 sum = _mm_setzero_ps();
+	float lanes[4];
+	for(; i + 4 <= len; i += 4){
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&taps[i]), _mm_loadu_ps(&data[i])));
+	}
+	_mm_storeu_ps(lanes, sum);
+	acc = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON)
+	float32x4_t sum = vdupq_n_f32(0.0f);
+	for(; i + 4 <= len; i += 4){
+		sum = vmlaq_f32(sum, vld1q_f32(&taps[i]), vld1q_f32(&data[i]));
+	}
+	acc = (vgetq_lane_f32(sum, 0) + vgetq_lane_f32(sum, 1)) + (vgetq_lane_f32(sum, 2) + vgetq_lane_f32(sum, 3));
+#endif
+
+	for(; i < len; i++){
+		acc += taps[i] * data[i];
+	}
+	return acc;
+}
+#endif
+
+// Appends a block to the history and computes the outputs that fall in it (in place, behind the input)
+static uint32_t MPU6050_FilterDecimate(MPU6050_FilterBank *bank, MPU6050_FilterData *const block[], uint32_t len, MPU6050_FilterData *const data[], uint32_t outCount) {
+	uint8_t keep = bank->numTaps - 1;
+
+	for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+		memcpy(&bank->history[ch][keep], block[ch], len * sizeof(MPU6050_FilterData));
+	}
+
+	for(uint32_t i = 0; i < len; i++){
+		if(++bank->phase < bank->decimation){
+			continue;
+		}
+		bank->phase = 0;
+
+		for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+			data[ch][outCount] = MPU6050_FilterDot(bank->taps, &bank->history[ch][i], bank->numTaps);
+		}
+		outCount++;
+	}
+
+	for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+		memmove(bank->history[ch], &bank->history[ch][len], keep * sizeof(MPU6050_FilterData));
+	}
+
+	return outCount;
+}
+
+// Filters numSamples of every channel in place, returns the number of output samples
+uint32_t MPU6050_FilterProcess(MPU6050_FilterBank *bank, MPU6050_FilterData *const data[], uint32_t numSamples) {
+	MPU6050_FilterData *block[MPU6050_FILTER_MAX_CHANNELS];
+	uint32_t outCount = 0;
+
+	for(uint32_t offset = 0; offset < numSamples; offset += MPU6050_FILTER_BLOCK){
+		uint32_t len = numSamples - offset;
+		if(len > MPU6050_FILTER_BLOCK){
+			len = MPU6050_FILTER_BLOCK;
+		}
+
+		for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+			block[ch] = &data[ch][offset];
+		}
+
+		if(bank->maxStages > 0){
+			MPU6050_FilterBiquads(bank, block, len);
+		}
+
+		if(bank->numTaps > 0){
+			outCount = MPU6050_FilterDecimate(bank, block, len, data, outCount);
+		}
+		else{
+			outCount += len;
+		}
+	}
+
+	return outCount;
+}
+
+// Decodes 14-byte frames (burst or FIFO with all sensors) into the first numChannels channels and filters them
+uint32_t MPU6050_FilterFrames(MPU6050_FilterBank *bank, MPU6050_ConfigTypeDef *config, const uint8_t *frames, uint32_t numFrames, MPU6050_FilterData *const out[]) {
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+	(void)config;
+	for(uint32_t i = 0; i < numFrames; i++){
+		const uint8_t *frame = &frames[i * MPU6050_SENSORS_BURST_LEN];
+
+		for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+			out[ch][i] = MPU6050_BYTES_TO_INT16(frame[2 * ch], frame[2 * ch + 1]);
+		}
+	}
+#else
+	MPU6050_BatchData batch = {NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+	float **channels[MPU6050_FILTER_MAX_CHANNELS] = {&batch.accelX, &batch.accelY, &batch.accelZ, &batch.temp, &batch.rotaX, &batch.rotaY, &batch.rotaZ};
+
+	for(uint8_t ch = 0; ch < bank->numChannels; ch++){
+		*channels[ch] = out[ch];
+	}
+	MPU6050_ConvertBatch(config, frames, numFrames, &batch);
+#endif
+
+	return MPU6050_FilterProcess(bank, out, numFrames);
+}
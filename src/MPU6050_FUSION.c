@@ -0,0 +1,384 @@
+#include "MPU6050_FUSION.h"
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+
+#define FUSION_ONE					((int32_t)1 << MPU6050_FUSION_Q)
+#define FUSION_MUL(a, b)			((int32_t)(((int64_t)(a) * (b)) >> MPU6050_FUSION_Q))
+#define FUSION_HALF(a)				((a) / 2)
+#define FUSION_CONST(value)			((int32_t)((value) * 1073741824.0 + ((value) < 0 ? -0.5 : 0.5)))
+// gain (Q16, per second) times dtUs, in Q30
+#define FUSION_GAIN_DT(gain, dtUs)	((int32_t)(((int64_t)(gain) * (dtUs) * 16384) / 1000000))
+#define FUSION_HALF_DT(dtUs)		((int32_t)(((int64_t)(dtUs) << (MPU6050_FUSION_Q - 1)) / 1000000))
+
+// Rotation in Q30 half-angles per milli-unit and per us, in Q32
+#if MPU6050_GYRO_UNITS == MPU6050_GYRO_RADS
+#define FUSION_GYRO_HALF_ANGLE_Q32	((int64_t)(0.536870912 * 4294967296.0 + 0.5))
+#else
+#define FUSION_GYRO_HALF_ANGLE_Q32	((int64_t)((double)DEG_TO_RAD * 0.536870912 * 4294967296.0 + 0.5))
+#endif
+
+#define FUSION_PI_Q29				1686629713	// Also pi/2 in Q30
+
+// Fixed 32 steps
+static uint32_t MPU6050_FusionSqrt(uint64_t value) {
+	uint64_t root = 0;
+
+	for(uint64_t bit = (uint64_t)1 << 62; bit != 0; bit >>= 2){
+		if(value >= root + bit){
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else{
+			root >>= 1;
+		}
+	}
+	return (uint32_t)root;
+}
+
+// Scales v to a Q30 unit vector, whatever the input scale
+static uint8_t MPU6050_FusionNormalize(int32_t *v, uint8_t len) {
+	uint64_t norm2 = 0;
+
+	for(uint8_t i = 0; i < len; i++){
+		norm2 += (uint64_t)((int64_t)v[i] * v[i]);
+	}
+
+	uint32_t norm = MPU6050_FusionSqrt(norm2);
+	if(0 == norm){
+		return FALSE;
+	}
+
+	for(uint8_t i = 0; i < len; i++){
+		v[i] = (int32_t)(((int64_t)v[i] << MPU6050_FUSION_Q) / norm);
+	}
+	return TRUE;
+}
+
+static void MPU6050_FusionGyro(const MPU6050_Rotations *rota, uint32_t dtUs, int32_t *h) {
+	int64_t k = (int64_t)dtUs * FUSION_GYRO_HALF_ANGLE_Q32;
+
+	h[0] = (int32_t)(((int64_t)rota->convertedRotaX * k) >> 32);
+	h[1] = (int32_t)(((int64_t)rota->convertedRotaY * k) >> 32);
+	h[2] = (int32_t)(((int64_t)rota->convertedRotaZ * k) >> 32);
+}
+
+// atan(z), 0 <= z <= 1 (Q30), max error 1e-5 rad
+static int32_t MPU6050_FusionAtan(int32_t z) {
+	int32_t z2 = FUSION_MUL(z, z);
+	int32_t p = FUSION_CONST(0.0208351);
+
+	p = FUSION_MUL(p, z2) + FUSION_CONST(-0.0851330);
+	p = FUSION_MUL(p, z2) + FUSION_CONST(0.1801410);
+	p = FUSION_MUL(p, z2) + FUSION_CONST(-0.3302995);
+	p = FUSION_MUL(p, z2) + FUSION_CONST(0.9998660);
+
+	return FUSION_MUL(p, z);
+}
+
+// Radians in Q29
+static int32_t MPU6050_FusionAtan2(int32_t y, int32_t x) {
+	int64_t absX = (x < 0) ? -(int64_t)x : x;
+	int64_t absY = (y < 0) ? -(int64_t)y : y;
+	int32_t angle;
+
+	if(0 == absX && 0 == absY){
+		return 0;
+	}
+
+	if(absY <= absX){
+		angle = MPU6050_FusionAtan((int32_t)((absY << MPU6050_FUSION_Q) / absX)) / 2;
+	}
+	else{
+		angle = (FUSION_PI_Q29 - MPU6050_FusionAtan((int32_t)((absX << MPU6050_FUSION_Q) / absY))) / 2;
+	}
+
+	if(x < 0){
+		angle = FUSION_PI_Q29 - angle;
+	}
+	return (y < 0) ? -angle : angle;
+}
+
+// Q29 radians to milli-degrees or milli-radians
+static int32_t MPU6050_FusionAngle(int32_t angle) {
+#if MPU6050_GYRO_UNITS == MPU6050_GYRO_RADS
+	return (int32_t)(((int64_t)angle * 1000 + (1 << 28)) >> 29);
+#else
+	return (int32_t)(((int64_t)angle * 3754936413LL + ((int64_t)1 << 44)) >> 45);	// 180000/pi in Q16
+#endif
+}
+
+static int32_t MPU6050_FusionAsin(int32_t s) {
+	if(s > FUSION_ONE){
+		s = FUSION_ONE;
+	}
+	if(s < -FUSION_ONE){
+		s = -FUSION_ONE;
+	}
+	uint64_t c2 = ((uint64_t)1 << (2 * MPU6050_FUSION_Q)) - (uint64_t)((int64_t)s * s);
+
+	return MPU6050_FusionAtan2(s, (int32_t)MPU6050_FusionSqrt(c2));
+}
+
+static void MPU6050_FusionAccel(const MPU6050_Accelerations *accel, int32_t *a) {
+	a[0] = accel->rawAccelX;
+	a[1] = accel->rawAccelY;
+	a[2] = accel->rawAccelZ;
+}
+
+void MPU6050_FusionSetGains(MPU6050_Fusion *fusion, float gain, float integralGain) {
+	fusion->gain = (int32_t)(gain * 65536.0f + 0.5f);
+	fusion->integralGain = (int32_t)(integralGain * 65536.0f + 0.5f);
+}
+
+void MPU6050_FusionGetEuler(MPU6050_Fusion *fusion, MPU6050_Euler *euler) {
+	MPU6050_Quaternion *q = &fusion->q;
+
+	euler->roll = MPU6050_FusionAngle(MPU6050_FusionAtan2(2 * (FUSION_MUL(q->w, q->x) + FUSION_MUL(q->y, q->z)),
+			FUSION_ONE - 2 * (FUSION_MUL(q->x, q->x) + FUSION_MUL(q->y, q->y))));
+	euler->pitch = MPU6050_FusionAngle(MPU6050_FusionAsin(2 * (FUSION_MUL(q->w, q->y) - FUSION_MUL(q->z, q->x))));
+	euler->yaw = MPU6050_FusionAngle(MPU6050_FusionAtan2(2 * (FUSION_MUL(q->w, q->z) + FUSION_MUL(q->x, q->y)),
+			FUSION_ONE - 2 * (FUSION_MUL(q->y, q->y) + FUSION_MUL(q->z, q->z))));
+}
+
+// 1g = 1000 mg
+#define FUSION_GRAVITY_UNITS(v)		((int32_t)(((int64_t)(v) * 1000 + (1 << 29)) >> MPU6050_FUSION_Q))
+
+#else
+
+#include <math.h>
+
+#define FUSION_ONE					1.0f
+#define FUSION_MUL(a, b)			((a) * (b))
+#define FUSION_HALF(a)				((a) * 0.5f)
+#define FUSION_CONST(value)			((float)(value))
+#define FUSION_GAIN_DT(gain, dtUs)	((gain) * (float)(dtUs) * 1e-6f)
+#define FUSION_HALF_DT(dtUs)		((float)(dtUs) * 0.5e-6f)
+
+#if MPU6050_GYRO_UNITS == MPU6050_GYRO_RADS
+#define FUSION_GYRO_TO_RAD			1.0f
+#else
+#define FUSION_GYRO_TO_RAD			DEG_TO_RAD
+#endif
+
+static uint8_t MPU6050_FusionNormalize(float *v, uint8_t len) {
+	float norm2 = 0.0f;
+
+	for(uint8_t i = 0; i < len; i++){
+		norm2 += v[i] * v[i];
+	}
+
+	if(norm2 <= 0.0f){
+		return FALSE;
+	}
+
+	float invNorm = 1.0f / sqrtf(norm2);
+	for(uint8_t i = 0; i < len; i++){
+		v[i] *= invNorm;
+	}
+	return TRUE;
+}
+
+static void MPU6050_FusionGyro(const MPU6050_Rotations *rota, uint32_t dtUs, float *h) {
+	float k = FUSION_GYRO_TO_RAD * FUSION_HALF_DT(dtUs);
+
+	h[0] = rota->convertedRotaX * k;
+	h[1] = rota->convertedRotaY * k;
+	h[2] = rota->convertedRotaZ * k;
+}
+
+static void MPU6050_FusionAccel(const MPU6050_Accelerations *accel, float *a) {
+	a[0] = accel->rawAccelX;
+	a[1] = accel->rawAccelY;
+	a[2] = accel->rawAccelZ;
+}
+
+void MPU6050_FusionSetGains(MPU6050_Fusion *fusion, float gain, float integralGain) {
+	fusion->gain = gain;
+	fusion->integralGain = integralGain;
+}
+
+void MPU6050_FusionGetEuler(MPU6050_Fusion *fusion, MPU6050_Euler *euler) {
+	MPU6050_Quaternion *q = &fusion->q;
+	float sinPitch = 2.0f * (q->w * q->y - q->z * q->x);
+
+	if(sinPitch > 1.0f){
+		sinPitch = 1.0f;
+	}
+	if(sinPitch < -1.0f){
+		sinPitch = -1.0f;
+	}
+
+	euler->roll = atan2f(2.0f * (q->w * q->x + q->y * q->z), 1.0f - 2.0f * (q->x * q->x + q->y * q->y)) / FUSION_GYRO_TO_RAD;
+	euler->pitch = asinf(sinPitch) / FUSION_GYRO_TO_RAD;
+	euler->yaw = atan2f(2.0f * (q->w * q->z + q->x * q->y), 1.0f - 2.0f * (q->y * q->y + q->z * q->z)) / FUSION_GYRO_TO_RAD;
+}
+
+#define FUSION_GRAVITY_UNITS(v)		((v) * GRAVITY_ACCEL)
+
+#endif
+
+// Gravity direction in the body frame
+static void MPU6050_FusionGravity(const MPU6050_Quaternion *q, MPU6050_FusionReal *v) {
+	v[0] = 2 * (FUSION_MUL(q->x, q->z) - FUSION_MUL(q->w, q->y));
+	v[1] = 2 * (FUSION_MUL(q->w, q->x) + FUSION_MUL(q->y, q->z));
+	v[2] = FUSION_MUL(q->w, q->w) - FUSION_MUL(q->x, q->x) - FUSION_MUL(q->y, q->y) + FUSION_MUL(q->z, q->z);
+}
+
+// Shortest rotation taking the measured gravity a to +Z
+static void MPU6050_FusionAlign(MPU6050_Fusion *fusion, const MPU6050_FusionReal *a) {
+	MPU6050_FusionReal q[4] = {FUSION_ONE + a[2], a[1], -a[0], 0};
+
+	if(!MPU6050_FusionNormalize(q, 4)){
+		// Upside down
+		q[0] = 0;
+		q[1] = FUSION_ONE;
+		q[2] = 0;
+	}
+
+	fusion->q.w = q[0];
+	fusion->q.x = q[1];
+	fusion->q.y = q[2];
+	fusion->q.z = q[3];
+}
+
+void MPU6050_FusionInit(MPU6050_Fusion *fusion, uint8_t algorithm) {
+	fusion->algorithm = algorithm;
+
+	switch(algorithm){
+		case FUSION_MADGWICK:
+			MPU6050_FusionSetGains(fusion, MPU6050_FUSION_MADGWICK_BETA, 0.0f);
+			break;
+		case FUSION_COMPLEMENTARY:
+			MPU6050_FusionSetGains(fusion, MPU6050_FUSION_COMPLEMENTARY_ALPHA, 0.0f);
+			break;
+		default:
+			MPU6050_FusionSetGains(fusion, MPU6050_FUSION_MAHONY_KP, MPU6050_FUSION_MAHONY_KI);
+			break;
+	}
+
+	MPU6050_FusionReset(fusion);
+}
+
+void MPU6050_FusionReset(MPU6050_Fusion *fusion) {
+	fusion->initialized = FALSE;
+	fusion->lastTimestampUs = 0;
+	fusion->updates = 0;
+	fusion->q.w = FUSION_ONE;
+	fusion->q.x = 0;
+	fusion->q.y = 0;
+	fusion->q.z = 0;
+	fusion->integral[0] = 0;
+	fusion->integral[1] = 0;
+	fusion->integral[2] = 0;
+}
+
+uint8_t MPU6050_FusionUpdate(MPU6050_Fusion *fusion, const MPU6050_Accelerations *accel, const MPU6050_Rotations *rota, uint32_t timestampUs) {
+	uint32_t dtUs = fusion->initialized ? timestampUs - fusion->lastTimestampUs : 0;
+
+	fusion->lastTimestampUs = timestampUs;
+
+	return MPU6050_FusionUpdateDt(fusion, accel, rota, dtUs);
+}
+
+uint8_t MPU6050_FusionUpdateDt(MPU6050_Fusion *fusion, const MPU6050_Accelerations *accel, const MPU6050_Rotations *rota, uint32_t dtUs) {
+	MPU6050_Quaternion *q = &fusion->q;
+	MPU6050_FusionReal a[3];
+	MPU6050_FusionReal h[3];		// Rotation over dt as half-angles (rad)
+	MPU6050_FusionReal v[3];
+	MPU6050_FusionReal e[3];
+
+	MPU6050_FusionAccel(accel, a);
+	uint8_t hasGravity = MPU6050_FusionNormalize(a, 3);
+
+	if(!fusion->initialized){
+		if(!hasGravity){
+			return ERR_FUSION_NO_GRAVITY;
+		}
+		MPU6050_FusionAlign(fusion, a);
+		fusion->initialized = TRUE;
+		fusion->updates++;
+		return FUSION_OK;
+	}
+
+	if(dtUs > MPU6050_FUSION_MAX_DT_US){
+		dtUs = MPU6050_FUSION_MAX_DT_US;
+	}
+
+	MPU6050_FusionGyro(rota, dtUs, h);
+	MPU6050_FusionGravity(q, v);
+
+	// Tilt error: rotation taking the estimated gravity onto the measured one
+	e[0] = FUSION_MUL(a[1], v[2]) - FUSION_MUL(a[2], v[1]);
+	e[1] = FUSION_MUL(a[2], v[0]) - FUSION_MUL(a[0], v[2]);
+	e[2] = FUSION_MUL(a[0], v[1]) - FUSION_MUL(a[1], v[0]);
+
+	if(hasGravity && FUSION_MAHONY == fusion->algorithm){
+		MPU6050_FusionReal kpHalfDt = FUSION_HALF(FUSION_GAIN_DT(fusion->gain, dtUs));
+		MPU6050_FusionReal kiDt = FUSION_GAIN_DT(fusion->integralGain, dtUs);
+		MPU6050_FusionReal halfDt = FUSION_HALF_DT(dtUs);
+
+		for(uint8_t i = 0; i < 3; i++){
+			fusion->integral[i] += FUSION_MUL(kiDt, e[i]);
+			h[i] += FUSION_MUL(kpHalfDt, e[i]) + FUSION_MUL(fusion->integral[i], halfDt);
+		}
+	}
+	else if(hasGravity && FUSION_COMPLEMENTARY == fusion->algorithm){
+		MPU6050_FusionReal alphaHalf = FUSION_HALF(FUSION_GAIN_DT(fusion->gain, 1000000));
+
+		for(uint8_t i = 0; i < 3; i++){
+			h[i] += FUSION_MUL(alphaHalf, e[i]);
+		}
+	}
+
+	// q += q x (0, h)
+	MPU6050_FusionReal dq[4] = {
+		-FUSION_MUL(q->x, h[0]) - FUSION_MUL(q->y, h[1]) - FUSION_MUL(q->z, h[2]),
+		FUSION_MUL(q->w, h[0]) + FUSION_MUL(q->y, h[2]) - FUSION_MUL(q->z, h[1]),
+		FUSION_MUL(q->w, h[1]) - FUSION_MUL(q->x, h[2]) + FUSION_MUL(q->z, h[0]),
+		FUSION_MUL(q->w, h[2]) + FUSION_MUL(q->x, h[1]) - FUSION_MUL(q->y, h[0])
+	};
+
+	if(hasGravity && FUSION_MADGWICK == fusion->algorithm){
+		// Gradient of |gravity(q) - a|^2 (scaled by 1/8 to stay in range), normalized
+		MPU6050_FusionReal g[3] = {FUSION_HALF(v[0] - a[0]), FUSION_HALF(v[1] - a[1]), FUSION_HALF(v[2] - a[2])};
+		MPU6050_FusionReal s[4] = {
+			FUSION_HALF(FUSION_MUL(q->x, g[1]) - FUSION_MUL(q->y, g[0])),
+			FUSION_HALF(FUSION_MUL(q->z, g[0]) + FUSION_MUL(q->w, g[1])) - FUSION_MUL(q->x, g[2]),
+			FUSION_HALF(FUSION_MUL(q->z, g[1]) - FUSION_MUL(q->w, g[0])) - FUSION_MUL(q->y, g[2]),
+			FUSION_HALF(FUSION_MUL(q->x, g[0]) + FUSION_MUL(q->y, g[1]))
+		};
+
+		if(MPU6050_FusionNormalize(s, 4)){
+			MPU6050_FusionReal betaDt = FUSION_GAIN_DT(fusion->gain, dtUs);
+
+			for(uint8_t i = 0; i < 4; i++){
+				dq[i] -= FUSION_MUL(betaDt, s[i]);
+			}
+		}
+	}
+
+	MPU6050_FusionReal qn[4] = {q->w + dq[0], q->x + dq[1], q->y + dq[2], q->z + dq[3]};
+	MPU6050_FusionNormalize(qn, 4);
+	q->w = qn[0];
+	q->x = qn[1];
+	q->y = qn[2];
+	q->z = qn[3];
+
+	fusion->updates++;
+
+	return hasGravity ? FUSION_OK : ERR_FUSION_NO_GRAVITY;
+}
+
+void MPU6050_FusionGetQuaternion(MPU6050_Fusion *fusion, MPU6050_Quaternion *q) {
+	*q = fusion->q;
+}
+
+void MPU6050_FusionGetLinearAccel(MPU6050_Fusion *fusion, const MPU6050_Accelerations *accel, MPU6050_LinearAccel *linAccel) {
+	MPU6050_FusionReal v[3];
+
+	MPU6050_FusionGravity(&fusion->q, v);
+
+	linAccel->x = accel->convertedAccelX - FUSION_GRAVITY_UNITS(v[0]);
+	linAccel->y = accel->convertedAccelY - FUSION_GRAVITY_UNITS(v[1]);
+	linAccel->z = accel->convertedAccelZ - FUSION_GRAVITY_UNITS(v[2]);
+}
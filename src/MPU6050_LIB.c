@@ -1,518 +1,2128 @@
 #include "MPU6050_LIB.h"
 
-#ifndef STM32_FAMILY
-#define STM32_FAMILY 4  // Change this value to toggle between the different families
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_STM32_HAL
+
+static HAL_StatusTypeDef MPU6050_HAL_Read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	return HAL_I2C_Mem_Read(hi2c, address<<1, reg, I2C_MEMADD_SIZE_8BIT, data, len, MPU6050_TIMEOUT_MS);
+}
+
+static HAL_StatusTypeDef MPU6050_HAL_Write(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	return HAL_I2C_Mem_Write(hi2c, address<<1, reg, I2C_MEMADD_SIZE_8BIT, data, len, MPU6050_TIMEOUT_MS);
+}
+
+static HAL_StatusTypeDef MPU6050_HAL_StartRead(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+#if MPU6050_ASYNC_MODE == MPU6050_ASYNC_DMA
+	return HAL_I2C_Mem_Read_DMA(hi2c, address<<1, reg, I2C_MEMADD_SIZE_8BIT, data, len);
+#else
+	return HAL_I2C_Mem_Read_IT(hi2c, address<<1, reg, I2C_MEMADD_SIZE_8BIT, data, len);
+#endif
+}
+
+const MPU6050_Transport MPU6050_DefaultTransport = {
+	.read = MPU6050_HAL_Read,
+	.write = MPU6050_HAL_Write,
+	.readBlocks = NULL,
+	.startRead = MPU6050_HAL_StartRead
+};
+
+#endif	// The Linux MPU6050_DefaultTransport lives in MPU6050_LINUX.c
+
+static const MPU6050_Transport *MPU6050_GetTransport(MPU6050_ConfigTypeDef *config) {
+	return (config->transport != NULL) ? config->transport : &MPU6050_DefaultTransport;
+}
+
+#if MPU6050_STATS
+
+// Number of significant bits, the histogram bucket of a duration
+static uint8_t MPU6050_StatsBucket(uint32_t ticks) {
+#if defined(__GNUC__)
+	uint8_t bits = (0 == ticks) ? 0 : (uint8_t)(32 - __builtin_clz(ticks));
+#else
+	uint8_t bits = 0;
+	for(; ticks != 0; ticks >>= 1){
+		bits++;
+	}
 #endif
 
-// Depending on the value of STM32_FAMILY, include the appropriate header files.
-#if STM32_FAMILY == 1
-  #include "stm32f1xx_hal.h"
-  #include "stm32f1xx_hal_i2c.h"
-#elif STM32_FAMILY == 2
-  #include "stm32f2xx_hal.h"
-  #include "stm32f2xx_hal_i2c.h"
-#elif STM32_FAMILY == 3
-  #include "stm32f3xx_hal.h"
-  #include "stm32f3xx_hal_i2c.h"
-#elif STM32_FAMILY == 4
-  #include "stm32f4xx_hal.h"
-  #include "stm32f4xx_hal_i2c.h"
-#else
-  #error "Invalid STM32 family selection"
-#endif
+	return (bits < MPU6050_STATS_BUCKETS) ? bits : (MPU6050_STATS_BUCKETS - 1);
+}
+
+static void MPU6050_StatsRecord(MPU6050_Stats *stats, uint8_t api, uint8_t failed, uint32_t ticks) {
+	MPU6050_ApiStats *apiStats = &stats->api[api];
+
+	if(0 == apiStats->calls || ticks < apiStats->minTicks){
+		apiStats->minTicks = ticks;
+	}
+	if(ticks > apiStats->maxTicks){
+		apiStats->maxTicks = ticks;
+	}
+	apiStats->calls++;
+	apiStats->errors += failed ? 1 : 0;
+	apiStats->totalTicks += ticks;
+	apiStats->histogram[MPU6050_StatsBucket(ticks)]++;
+}
+
+static inline uint32_t MPU6050_StatsStart(MPU6050_ConfigTypeDef *config) {
+	return (config->stats != NULL) ? MPU6050_STATS_TICKS() : 0;
+}
+
+// Counts one bus transaction and times it from startTicks into STATS_BUS or STATS_ASYNC
+static void MPU6050_StatsTransfer(MPU6050_ConfigTypeDef *config, uint8_t api, uint32_t startTicks, HAL_StatusTypeDef status, uint32_t bytesRead, uint32_t bytesWritten) {
+	MPU6050_Stats *stats = config->stats;
+
+	if(NULL == stats){
+		return;
+	}
+
+	MPU6050_StatsRecord(stats, api, HAL_OK != status, MPU6050_STATS_TICKS() - startTicks);
+
+	stats->transfers++;
+	if(bytesWritten != 0){
+		stats->writes++;
+	}
+	else{
+		stats->reads++;
+	}
+	stats->status[(uint8_t)status < MPU6050_STATS_STATUSES ? (uint8_t)status : HAL_ERROR]++;
+	if(HAL_OK == status){
+		stats->bytesRead += bytesRead;
+		stats->bytesWritten += bytesWritten;
+	}
+}
+
+static inline void MPU6050_StatsBus(MPU6050_ConfigTypeDef *config, uint32_t startTicks, HAL_StatusTypeDef status, uint32_t bytesRead, uint32_t bytesWritten) {
+	MPU6050_StatsTransfer(config, STATS_BUS, startTicks, status, bytesRead, bytesWritten);
+}
+
+// Times a public function, its body lives in the static function called
+#define MPU6050_STATS_RETURN(config, api, call) { \
+		if(NULL == (config)->stats){ \
+			return (call); \
+		} \
+		uint32_t statsStart = MPU6050_STATS_TICKS(); \
+		uint8_t statsResult = (call); \
+		MPU6050_StatsRecord((config)->stats, (api), statsResult != 0, MPU6050_STATS_TICKS() - statsStart); \
+		return statsResult; \
+	}
+
+#else
+
+static inline uint32_t MPU6050_StatsStart(MPU6050_ConfigTypeDef *config) {
+	(void)config;
+	return 0;
+}
+
+static inline void MPU6050_StatsBus(MPU6050_ConfigTypeDef *config, uint32_t startTicks, HAL_StatusTypeDef status, uint32_t bytesRead, uint32_t bytesWritten) {
+	(void)config; (void)startTicks; (void)status; (void)bytesRead; (void)bytesWritten;
+}
+
+#define MPU6050_STATS_RETURN(config, api, call)	return (call)
+
+#endif
+
+// Tracks connection health from the HAL status of every transfer
+static void MPU6050_UpdateHealth(MPU6050_ConfigTypeDef *config, HAL_StatusTypeDef status) {
+	if(HAL_OK == status){
+		config->errorCount = 0;
+		return;
+	}
+
+	if(config->errorCount < UINT8_MAX){
+		config->errorCount++;
+	}
+
+	if(config->errorCount >= MPU6050_LOST_ERRORS){
+#if MPU6050_STATS
+		if(config->stats != NULL && config->connState != CONN_STATE_LOST){
+			config->stats->connLost++;
+		}
+#endif
+		config->connState = CONN_STATE_LOST;
+	}
+	else if(CONN_STATE_CONNECTED == config->connState){
+		config->connState = CONN_STATE_DEGRADED;
+	}
+}
+
+// Stats and connection health of one finished bus transaction
+static inline void MPU6050_TransferDone(MPU6050_ConfigTypeDef *config, uint32_t startTicks, HAL_StatusTypeDef status, uint32_t bytesRead, uint32_t bytesWritten) {
+	MPU6050_StatsBus(config, startTicks, status, bytesRead, bytesWritten);
+	MPU6050_UpdateHealth(config, status);
+}
+
+static HAL_StatusTypeDef MPU6050_ReadRegs(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len) {
+	uint32_t startTicks = MPU6050_StatsStart(config);
+	HAL_StatusTypeDef status = MPU6050_GetTransport(config)->read(config->hi2c, config->address, reg, data, len);
+
+	MPU6050_TransferDone(config, startTicks, status, len, 0);
+
+	return status;
+}
+
+static HAL_StatusTypeDef MPU6050_WriteRegs(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len) {
+	uint32_t startTicks = MPU6050_StatsStart(config);
+	HAL_StatusTypeDef status = MPU6050_GetTransport(config)->write(config->hi2c, config->address, reg, data, len);
+
+	MPU6050_TransferDone(config, startTicks, status, 0, len);
+
+	return status;
+}
+
+// Non-contiguous registers in one bus operation when the transport supports it
+static HAL_StatusTypeDef MPU6050_ReadBlocks(MPU6050_ConfigTypeDef *config, MPU6050_RegBlock *blocks, uint8_t numBlocks) {
+	const MPU6050_Transport *transport = MPU6050_GetTransport(config);
+	HAL_StatusTypeDef status = HAL_OK;
+
+	if(transport->readBlocks != NULL){
+		uint32_t startTicks = MPU6050_StatsStart(config);
+		uint32_t len = 0;
+
+		status = transport->readBlocks(config->hi2c, config->address, blocks, numBlocks);
+		for(uint8_t i = 0; i < numBlocks; i++){
+			len += blocks[i].len;
+		}
+		MPU6050_TransferDone(config, startTicks, status, len, 0);
+		return status;
+	}
+
+	for(uint8_t i = 0; i < numBlocks && HAL_OK == status; i++){
+		status = MPU6050_ReadRegs(config, blocks[i].reg, blocks[i].data, blocks[i].len);
+	}
+
+	return status;
+}
+
+static uint8_t MPU6050_InitUntimed(MPU6050_ConfigTypeDef *config) {
+	uint8_t resetConf = DEVICE_RESET_CONFIG_SET;
+	uint8_t pwrMgmtConf[2] = {config->pwrMgmt1Config, config->pwrMgmt2Config};
+	// REG_SMPLRT_DIV, REG_CONFIG, REG_GYRO_CONFIG, REG_ACCEL_CONFIG
+	uint8_t sensorsConf[4] = {config->smplRateDivConfig, config->dlpfFsyncConfig, config->gyroConfig, config->accelConfig};
+
+	// Every register back to its reset value, the device wakes up in sleep mode
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_PWR_MGMT_1, &resetConf, sizeof(resetConf))){
+		return ERR_INIT_CONN;
+	}
+
+	uint32_t resetTick = HAL_GetTick();
+	uint8_t pwrMgmt1 = DEVICE_RESET_CONFIG_SET;
+	while(pwrMgmt1 & DEVICE_RESET_CONFIG_SET){
+		if((HAL_GetTick() - resetTick) > MPU6050_RESET_TIMEOUT_MS){
+			return ERR_INIT_RESET;
+		}
+		// The device may not answer while resetting
+		if(HAL_OK != MPU6050_ReadRegs(config, REG_PWR_MGMT_1, &pwrMgmt1, sizeof(pwrMgmt1))){
+			pwrMgmt1 = DEVICE_RESET_CONFIG_SET;
+		}
+	}
+
+	// Configured while sleeping, the wake up (PWR_MGMT_1) comes last
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_SMPLRT_DIV, sensorsConf, sizeof(sensorsConf))){
+		return ERR_INIT_CONN;
+	}
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_PWR_MGMT_1, pwrMgmtConf, sizeof(pwrMgmtConf))){
+		return ERR_INIT_CONN;
+	}
+
+	uint8_t sensorsCheck[4];
+	uint8_t pwrMgmtCheck[2];
+	MPU6050_RegBlock blocks[2] = {
+		{REG_SMPLRT_DIV, sensorsCheck, sizeof(sensorsCheck)},
+		{REG_PWR_MGMT_1, pwrMgmtCheck, sizeof(pwrMgmtCheck)}
+	};
+	if(HAL_OK != MPU6050_ReadBlocks(config, blocks, 2)){
+		return ERR_INIT_CONN;
+	}
+
+	uint8_t mismatches = INIT_OK;
+	if(sensorsCheck[0] != sensorsConf[0]){
+		mismatches |= ERR_INIT_1;
+	}
+	if(sensorsCheck[1] != sensorsConf[1]){
+		mismatches |= ERR_INIT_0;
+	}
+	if(sensorsCheck[2] != sensorsConf[2]){
+		mismatches |= ERR_INIT_5;
+	}
+	if(sensorsCheck[3] != sensorsConf[3]){
+		mismatches |= ERR_INIT_4;
+	}
+	if(pwrMgmtCheck[0] != pwrMgmtConf[0]){
+		mismatches |= ERR_INIT_2;
+	}
+	if(pwrMgmtCheck[1] != pwrMgmtConf[1]){
+		mismatches |= ERR_INIT_3;
+	}
+	if(mismatches != INIT_OK){
+		return mismatches;
+	}
+
+	MPU6050_UpdateScales(config);
+
+	config->connState = CONN_STATE_CONNECTED;
+	config->lastProbeTick = HAL_GetTick();
+
+	return INIT_OK;
+}
+
+// The reset of MPU6050_Init returns every register written by the other functions to its reset
+// value. Their copies are cleared too, or MPU6050_Reconnect would apply them again
+static void MPU6050_ClearShadows(MPU6050_ConfigTypeDef *config) {
+	config->fifoEnConfig = 0;
+	config->intPinConfig = 0;
+	config->intEnableConfig = 0;
+
+	config->auxEnabled = FALSE;
+	config->i2cMstCtrlConfig = 0;
+	for(uint8_t i = 0; i < MPU6050_AUX_SLAVES; i++){
+		config->i2cSlvConfig[i][0] = 0;
+		config->i2cSlvConfig[i][1] = 0;
+		config->i2cSlvConfig[i][2] = 0;
+		config->i2cSlvDoConfig[i] = 0;
+	}
+	config->i2cSlv4CtrlConfig = 0;
+	config->i2cMstDelayCtrlConfig = 0;
+
+	config->motThrConfig = 0;
+	config->motDurConfig = 0;
+	config->motDetectCtrlConfig = 0;
+	config->cycleMode = FALSE;
+	config->lpWakeCtrlConfig = 0;
+	config->cycleIntEnableConfig = 0;
+	config->intStatusPending = 0;
+
+	config->accelOffSet = FALSE;
+	config->gyroOffSet = FALSE;
+}
+
+uint8_t MPU6050_Init(MPU6050_ConfigTypeDef *config) {
+	MPU6050_ClearShadows(config);
+	MPU6050_STATS_RETURN(config, STATS_INIT, MPU6050_InitUntimed(config));
+}
+
+uint8_t MPU6050_Test_Conn(MPU6050_ConfigTypeDef *config) {
+	uint8_t checkData;
+
+	config->lastProbeTick = HAL_GetTick();
+
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_WHO_AM_I, &checkData, sizeof(checkData))){
+		return ERR_CONN_0;
+	}
+
+	if(MPU6050_WHO_AM_I_VALUE != checkData){
+		MPU6050_UpdateHealth(config, HAL_ERROR);
+		return ERR_CONN_0;
+	}
+
+	return CONN_OK;
+}
+
+// Re-applies every register the library has written, the device may have been power cycled.
+// The offsets come from the config: the registers of a lost device cannot be trusted
+static uint8_t MPU6050_AuxApply(MPU6050_ConfigTypeDef *config);
+static uint8_t MPU6050_CycleApply(MPU6050_ConfigTypeDef *config);
+static uint8_t MPU6050_WriteOffsets(MPU6050_ConfigTypeDef *config, uint8_t reg, int16_t x, int16_t y, int16_t z, uint8_t verify);
+
+static uint8_t MPU6050_Reconnect(MPU6050_ConfigTypeDef *config) {
+	if(INIT_OK != MPU6050_InitUntimed(config)){
+		return ERR_CONN_0;
+	}
+	if(config->accelOffSet){
+		if(WRITE_OK != MPU6050_WriteOffsets(config, REG_XA_OFFS_USRH, config->accelOffConfig[0], config->accelOffConfig[1], config->accelOffConfig[2], FALSE)){
+			return ERR_CONN_0;
+		}
+	}
+	if(config->gyroOffSet){
+		if(WRITE_OK != MPU6050_WriteOffsets(config, REG_XG_OFFS_USRH, config->gyroOffConfig[0], config->gyroOffConfig[1], config->gyroOffConfig[2], FALSE)){
+			return ERR_CONN_0;
+		}
+	}
+	if((config->intPinConfig | config->intEnableConfig) != 0){
+		if(INT_OK != MPU6050_ConfigInterrupts(config, config->intPinConfig, config->intEnableConfig)){
+			return ERR_CONN_0;
+		}
+	}
+	if(config->auxEnabled){
+		if(AUX_OK != MPU6050_AuxApply(config)){
+			return ERR_CONN_0;
+		}
+	}
+	if(config->fifoEnConfig != 0){
+		if(FIFO_OK != MPU6050_FifoEnable(config, config->fifoEnConfig)){
+			return ERR_CONN_0;
+		}
+	}
+	if((config->motThrConfig | config->motDurConfig | config->motDetectCtrlConfig) != 0){
+		if(POWER_OK != MPU6050_ConfigMotion(config, config->motThrConfig, config->motDurConfig, config->motDetectCtrlConfig)){
+			return ERR_CONN_0;
+		}
+	}
+	// Init woke the device up at full rate
+	if(config->cycleMode){
+		if(POWER_OK != MPU6050_CycleApply(config)){
+			return ERR_CONN_0;
+		}
+	}
+
+	return CONN_OK;
+}
+
+// Cheap when connected: the bus is only used when a probe is due or after a failed transfer
+static uint8_t MPU6050_CheckConnUntimed(MPU6050_ConfigTypeDef *config) {
+	switch(config->connState){
+		case CONN_STATE_CONNECTED:
+			if(0 == config->probeIntervalMs || (HAL_GetTick() - config->lastProbeTick) < config->probeIntervalMs){
+				return CONN_OK;
+			}
+			return MPU6050_Test_Conn(config);
+		case CONN_STATE_DEGRADED:
+			if(CONN_OK != MPU6050_Test_Conn(config)){
+				return ERR_CONN_0;
+			}
+			config->connState = CONN_STATE_CONNECTED;
+			return CONN_OK;
+		case CONN_STATE_LOST:
+		default:
+			if(CONN_OK != MPU6050_Test_Conn(config)){
+				return ERR_CONN_0;
+			}
+			if(CONN_OK != MPU6050_Reconnect(config)){
+				return ERR_CONN_0;
+			}
+#if MPU6050_STATS
+			if(config->stats != NULL){
+				config->stats->reconnects++;
+			}
+#endif
+			config->connState = CONN_STATE_CONNECTED;
+			return CONN_OK;
+	}
+}
+
+uint8_t MPU6050_CheckConn(MPU6050_ConfigTypeDef *config) {
+	MPU6050_STATS_RETURN(config, STATS_CHECK_CONN, MPU6050_CheckConnUntimed(config));
+}
+
+// The connection check of a front end call is part of the call, as in the library functions
+uint8_t MPU6050_CallBegin(MPU6050_ConfigTypeDef *config, uint32_t *callTicks) {
+	*callTicks = MPU6050_StatsStart(config);
+	return MPU6050_CheckConnUntimed(config);
+}
+
+uint32_t MPU6050_TransferBegin(MPU6050_ConfigTypeDef *config) {
+	return MPU6050_StatsStart(config);
+}
+
+void MPU6050_TransferEnd(MPU6050_ConfigTypeDef *config, uint32_t startTicks, HAL_StatusTypeDef status, uint32_t bytesRead, uint32_t bytesWritten) {
+	MPU6050_TransferDone(config, startTicks, status, bytesRead, bytesWritten);
+}
+
+uint8_t MPU6050_CallEnd(MPU6050_ConfigTypeDef *config, uint8_t api, uint32_t callTicks, uint8_t result) {
+#if MPU6050_STATS
+	if(config->stats != NULL){
+		MPU6050_StatsRecord(config->stats, api, result != 0, MPU6050_STATS_TICKS() - callTicks);
+	}
+#else
+	(void)config; (void)api; (void)callTicks;
+#endif
+	return result;
+}
+
+uint8_t MPU6050_GetConnState(MPU6050_ConfigTypeDef *config) {
+	return config->connState;
+}
+
+uint32_t MPU6050_GetTimeUs(MPU6050_ConfigTypeDef *config) {
+	if(config->clock != NULL){
+		return config->clock();
+	}
+	return HAL_GetTick() * 1000;
+}
+
+// Output data rate = gyroscope output rate / (1 + SMPLRT_DIV), truncated to Hz
+uint32_t MPU6050_GetSampleRateHz(MPU6050_ConfigTypeDef *config) {
+	return 1000000 / MPU6050_GetSamplePeriodUs(config);
+}
+
+// Wake-up period of the cycle mode, indexed by LP_WAKE_CTRL
+static const uint32_t lpWakePeriodUs[4] = {800000, 200000, 50000, 25000};
+
+// Exact: the gyroscope output period is 125us (8kHz) or 1000us (1kHz). In cycle mode, the wake-up period
+// is returned, from LP_WAKE_CTRL
+uint32_t MPU6050_GetSamplePeriodUs(MPU6050_ConfigTypeDef *config) {
+	if(config->cycleMode){
+		return lpWakePeriodUs[(config->lpWakeCtrlConfig & GET_LP_WAKE_CTRL_CONFIG) >> 6];
+	}
+
+	uint8_t dlpf = config->dlpfFsyncConfig & GET_DLPF_CONFIG;
+	uint32_t gyroPeriodUs = (DLPF_CONFIG_0 == dlpf || GET_DLPF_CONFIG == dlpf) ? 1000000 / GYRO_OUTPUT_RATE_HZ_DLPF_OFF : 1000000 / GYRO_OUTPUT_RATE_HZ_DLPF_ON;
+
+	return gyroPeriodUs * (1 + (uint32_t)config->smplRateDivConfig);
+}
+
+// Shadowed registers in bus order: two contiguous runs, REG_SMPLRT_DIV..REG_ACCEL_CONFIG and REG_PWR_MGMT_1..2
+#define MPU6050_SHADOW_LEN	6
+
+static void MPU6050_ShadowGet(MPU6050_ConfigTypeDef *config, uint8_t *shadow) {
+	shadow[0] = config->smplRateDivConfig;
+	shadow[1] = config->dlpfFsyncConfig;
+	shadow[2] = config->gyroConfig;
+	shadow[3] = config->accelConfig;
+	shadow[4] = config->pwrMgmt1Config;
+	shadow[5] = config->pwrMgmt2Config;
+}
+
+static void MPU6050_ShadowSet(MPU6050_ConfigTypeDef *config, uint8_t *shadow) {
+	config->smplRateDivConfig = shadow[0];
+	config->dlpfFsyncConfig = shadow[1];
+	config->gyroConfig = shadow[2];
+	config->accelConfig = shadow[3];
+	config->pwrMgmt1Config = shadow[4];
+	config->pwrMgmt2Config = shadow[5];
+}
+
+// Writes the registers of regs that differ from the shadow copy, one burst per contiguous run
+static uint8_t MPU6050_ShadowWrite(MPU6050_ConfigTypeDef *config, uint8_t *regs) {
+	static const uint8_t runReg[2] = {REG_SMPLRT_DIV, REG_PWR_MGMT_1};
+	static const uint8_t runStart[3] = {0, 4, MPU6050_SHADOW_LEN};
+	uint8_t shadow[MPU6050_SHADOW_LEN];
+
+	// PWR_MGMT_1/2 and ACCEL_CONFIG hold the cycle mode values on the device
+	if(config->cycleMode){
+		return ERR_CONFIG_CYCLE_MODE;
+	}
+
+	MPU6050_ShadowGet(config, shadow);
+
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_CONFIG_CONN;
+	}
+
+	for(uint8_t run = 0; run < 2; run++){
+		int8_t first = -1;
+		int8_t last = -1;
+
+		for(uint8_t i = runStart[run]; i < runStart[run + 1]; i++){
+			if(regs[i] != shadow[i]){
+				if(first < 0){
+					first = i;
+				}
+				last = i;
+			}
+		}
+
+		// Unchanged registers between two changed ones are rewritten, cheaper than a second transaction
+		if(first < 0){
+			continue;
+		}
+		if(HAL_OK != MPU6050_WriteRegs(config, runReg[run] + (first - runStart[run]), &regs[first], last - first + 1)){
+			return ERR_CONFIG_CONN;
+		}
+
+		// The shadow copy follows every completed run
+		for(int8_t i = first; i <= last; i++){
+			shadow[i] = regs[i];
+		}
+		MPU6050_ShadowSet(config, shadow);
+	}
+
+	return CONFIG_OK;
+}
+
+// Read-modify-write of one field of a shadowed register
+static uint8_t MPU6050_ShadowSetField(MPU6050_ConfigTypeDef *config, uint8_t index, uint8_t mask, uint8_t value) {
+	uint8_t regs[MPU6050_SHADOW_LEN];
+
+	if(value & ~mask){
+		return ERR_CONFIG_INVALID;
+	}
+
+	MPU6050_ShadowGet(config, regs);
+	regs[index] = (regs[index] & ~mask) | value;
+
+	return MPU6050_ShadowWrite(config, regs);
+}
+
+uint8_t MPU6050_SetAccelScale(MPU6050_ConfigTypeDef *config, uint8_t accelScale) {
+	return MPU6050_ShadowSetField(config, 3, GET_ACCEL_FS_CONFIG, accelScale);
+}
+
+uint8_t MPU6050_SetGyroScale(MPU6050_ConfigTypeDef *config, uint8_t gyroScale) {
+	return MPU6050_ShadowSetField(config, 2, GET_GYRO_FS_CONFIG, gyroScale);
+}
+
+uint8_t MPU6050_SetDlpf(MPU6050_ConfigTypeDef *config, uint8_t dlpf) {
+	return MPU6050_ShadowSetField(config, 1, GET_DLPF_CONFIG, dlpf);
+}
+
+uint8_t MPU6050_SetSampleRateDiv(MPU6050_ConfigTypeDef *config, uint8_t smplRateDiv) {
+	return MPU6050_ShadowSetField(config, 0, 0xFF, smplRateDiv);
+}
+
+uint8_t MPU6050_SetClockSource(MPU6050_ConfigTypeDef *config, uint8_t clkSel) {
+	return MPU6050_ShadowSetField(config, 4, GET_CLKSEL_CONFIG, clkSel);
+}
+
+uint8_t MPU6050_SetStandby(MPU6050_ConfigTypeDef *config, uint8_t stby) {
+	return MPU6050_ShadowSetField(config, 5, GET_STBY_CONFIG, stby);
+}
+
+uint8_t MPU6050_ApplyProfile(MPU6050_ConfigTypeDef *config, const MPU6050_Profile *profile) {
+	uint8_t regs[MPU6050_SHADOW_LEN] = {
+		profile->smplRateDivConfig,
+		profile->dlpfFsyncConfig,
+		profile->gyroConfig,
+		profile->accelConfig,
+		profile->pwrMgmt1Config,
+		profile->pwrMgmt2Config
+	};
+
+	return MPU6050_ShadowWrite(config, regs);
+}
+
+void MPU6050_SaveProfile(MPU6050_ConfigTypeDef *config, MPU6050_Profile *profile, const char *name) {
+	profile->name = name;
+	profile->dlpfFsyncConfig = config->dlpfFsyncConfig;
+	profile->smplRateDivConfig = config->smplRateDivConfig;
+	profile->pwrMgmt1Config = config->pwrMgmt1Config;
+	profile->pwrMgmt2Config = config->pwrMgmt2Config;
+	profile->accelConfig = config->accelConfig;
+	profile->gyroConfig = config->gyroConfig;
+}
+
+uint16_t MPU6050_GetAccelSensitivity(MPU6050_ConfigTypeDef *config) {
+	uint8_t accelConf = config->accelConfig & GET_ACCEL_FS_CONFIG;
+
+	switch(accelConf){
+		case ACCEL_CONFIG_SCALE_0:
+			return ACCEL_LSB_SEN_0;
+			break;
+		case ACCEL_CONFIG_SCALE_1:
+			return ACCEL_LSB_SEN_1;
+			break;
+		case ACCEL_CONFIG_SCALE_2:
+			return ACCEL_LSB_SEN_2;
+			break;
+		case ACCEL_CONFIG_SCALE_3:
+			return ACCEL_LSB_SEN_3;
+			break;
+		default:
+			return ERR_CONFIG_ACCEL;
+			break;
+	}
+}
+
+float MPU6050_GetGyroSensitivty(MPU6050_ConfigTypeDef *config) {
+	uint8_t gyroConf = config->gyroConfig & GET_GYRO_FS_CONFIG;
+
+	switch(gyroConf){
+		case GYRO_CONFIG_SCALE_0:
+			return GYRO_LSB_SEN_0;
+			break;
+		case GYRO_CONFIG_SCALE_1:
+			return GYRO_LSB_SEN_1;
+			break;
+		case GYRO_CONFIG_SCALE_2:
+			return GYRO_LSB_SEN_2;
+			break;
+		case GYRO_CONFIG_SCALE_3:
+			return GYRO_LSB_SEN_3;
+			break;
+		default:
+			return (float)ERR_CONFIG_GYRO;
+			break;
+	}
+}
+
+#if MPU6050_GYRO_UNITS == MPU6050_GYRO_RADS
+#define GYRO_UNIT_FACTOR	DEG_TO_RAD
+#else
+#define GYRO_UNIT_FACTOR	1.0f
+#endif
+
+// Reciprocal sensitivities indexed by the AFS_SEL/GFS_SEL value
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+static const int32_t accelScaleTable[4] = {
+	MPU6050_Q16(1000.0 / ACCEL_LSB_SEN_0),
+	MPU6050_Q16(1000.0 / ACCEL_LSB_SEN_1),
+	MPU6050_Q16(1000.0 / ACCEL_LSB_SEN_2),
+	MPU6050_Q16(1000.0 / ACCEL_LSB_SEN_3)
+};
+
+static const int32_t gyroScaleTable[4] = {
+	MPU6050_Q16(1000.0 * GYRO_UNIT_FACTOR / GYRO_LSB_SEN_0),
+	MPU6050_Q16(1000.0 * GYRO_UNIT_FACTOR / GYRO_LSB_SEN_1),
+	MPU6050_Q16(1000.0 * GYRO_UNIT_FACTOR / GYRO_LSB_SEN_2),
+	MPU6050_Q16(1000.0 * GYRO_UNIT_FACTOR / GYRO_LSB_SEN_3)
+};
+#else
+static const float accelScaleTable[4] = {
+	GRAVITY_ACCEL / ACCEL_LSB_SEN_0,
+	GRAVITY_ACCEL / ACCEL_LSB_SEN_1,
+	GRAVITY_ACCEL / ACCEL_LSB_SEN_2,
+	GRAVITY_ACCEL / ACCEL_LSB_SEN_3
+};
+
+static const float gyroScaleTable[4] = {
+	GYRO_UNIT_FACTOR / GYRO_LSB_SEN_0,
+	GYRO_UNIT_FACTOR / GYRO_LSB_SEN_1,
+	GYRO_UNIT_FACTOR / GYRO_LSB_SEN_2,
+	GYRO_UNIT_FACTOR / GYRO_LSB_SEN_3
+};
+#endif
+
+void MPU6050_UpdateScales(MPU6050_ConfigTypeDef *config) {
+	config->accelScale = accelScaleTable[(config->accelConfig & GET_ACCEL_FS_CONFIG) >> FS_CONFIG_SHIFT];
+	config->gyroScale = gyroScaleTable[(config->gyroConfig & GET_GYRO_FS_CONFIG) >> FS_CONFIG_SHIFT];
+	config->scaleAccelConfig = config->accelConfig;
+	config->scaleGyroConfig = config->gyroConfig;
+	config->scaleValid = TRUE;
+}
+
+// Recomputes the factors only if the full-scale configuration changed since they were cached
+static inline void MPU6050_CheckScales(MPU6050_ConfigTypeDef *config) {
+	if(!config->scaleValid || config->scaleAccelConfig != config->accelConfig || config->scaleGyroConfig != config->gyroConfig){
+		MPU6050_UpdateScales(config);
+	}
+}
+
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+#define MPU6050_CONVERT(rawData, scale)	MPU6050_RAW_TO_FIXED(rawData, scale)
+#define MPU6050_CONVERT_TEMP(rawData)	MPU6050_RAW_TO_TEMP_FIXED(rawData)
+#else
+#define MPU6050_CONVERT(rawData, scale)	MPU6050_RAW_TO_SCALED(rawData, scale)
+#define MPU6050_CONVERT_TEMP(rawData)	MPU6050_RAW_TO_TEMP(rawData)
+#endif
+
+static void MPU6050_ConvertAcceleration(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel) {
+	MPU6050_CheckScales(config);
+
+	accel->convertedAccelX = MPU6050_CONVERT(accel->rawAccelX, config->accelScale);
+	accel->convertedAccelY = MPU6050_CONVERT(accel->rawAccelY, config->accelScale);
+	accel->convertedAccelZ = MPU6050_CONVERT(accel->rawAccelZ, config->accelScale);
+}
+
+static void MPU6050_ConvertRotation(MPU6050_ConfigTypeDef *config, MPU6050_Rotations *rota) {
+	MPU6050_CheckScales(config);
+
+	rota->convertedRotaX = MPU6050_CONVERT(rota->rawRotaX, config->gyroScale);
+	rota->convertedRotaY = MPU6050_CONVERT(rota->rawRotaY, config->gyroScale);
+	rota->convertedRotaZ = MPU6050_CONVERT(rota->rawRotaZ, config->gyroScale);
+}
+
+// Converts the raw fields already filled in (recorded or externally read samples), as the getters do
+void MPU6050_ConvertSample(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+	if(accel != NULL){
+		MPU6050_ConvertAcceleration(config, accel);
+	}
+
+	if(temp != NULL){
+		temp->convertedTemp = MPU6050_CONVERT_TEMP(temp->rawTemp);
+	}
+
+	if(rota != NULL){
+		MPU6050_ConvertRotation(config, rota);
+	}
+}
+
+static uint8_t MPU6050_GetAccelerationUntimed(MPU6050_ConfigTypeDef *config , MPU6050_Accelerations *accel) {
+	uint8_t data[6];
+
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_CONN_0;
+	}
+
+	accel->timestampUs = MPU6050_GetTimeUs(config);
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_ACCEL_XOUT_H, data, sizeof(data))){
+		return ERR_CONN_0;
+	}
+
+	accel->rawAccelX = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+	accel->rawAccelY = MPU6050_BYTES_TO_INT16(data[2], data[3]);
+	accel->rawAccelZ = MPU6050_BYTES_TO_INT16(data[4], data[5]);
+
+	MPU6050_ConvertAcceleration(config, accel);
+
+	return CONN_OK;
+}
+
+uint8_t MPU6050_GetAcceleration(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel) {
+	MPU6050_STATS_RETURN(config, STATS_GET_ACCEL, MPU6050_GetAccelerationUntimed(config, accel));
+}
+
+static uint8_t MPU6050_GetRotationUntimed(MPU6050_ConfigTypeDef *config, MPU6050_Rotations *rota) {
+	uint8_t data[6];
+
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_CONN_0;
+	}
+
+	rota->timestampUs = MPU6050_GetTimeUs(config);
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_GYRO_XOUT_H, data, sizeof(data))){
+		return ERR_CONN_0;
+	}
+
+	rota->rawRotaX = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+	rota->rawRotaY = MPU6050_BYTES_TO_INT16(data[2], data[3]);
+	rota->rawRotaZ = MPU6050_BYTES_TO_INT16(data[4], data[5]);
+
+	MPU6050_ConvertRotation(config, rota);
+
+	return CONN_OK;
+}
+
+uint8_t MPU6050_GetRotation(MPU6050_ConfigTypeDef *config, MPU6050_Rotations *rota) {
+	MPU6050_STATS_RETURN(config, STATS_GET_ROTA, MPU6050_GetRotationUntimed(config, rota));
+}
+
+static uint8_t MPU6050_GetTemperatureUntimed(MPU6050_ConfigTypeDef *config, MPU6050_Temperature *temp) {
+	uint8_t data[2];
+
+	if(TEMP_DIS_CONFIG_SET == (config->pwrMgmt1Config & TEMP_DIS_CONFIG_SET)){
+		return ERR_TEMP_DISABLED;
+	}
+
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_CONN_0;
+	}
+
+	temp->timestampUs = MPU6050_GetTimeUs(config);
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_TEMP_OUT_H, data, sizeof(data))){
+		return ERR_CONN_0;
+	}
+
+	temp->rawTemp = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+	temp->convertedTemp = MPU6050_CONVERT_TEMP(temp->rawTemp);
+
+	return CONN_OK;
+}
+
+uint8_t MPU6050_GetTemperature(MPU6050_ConfigTypeDef *config, MPU6050_Temperature *temp) {
+	MPU6050_STATS_RETURN(config, STATS_GET_TEMP, MPU6050_GetTemperatureUntimed(config, temp));
+}
+
+// Decodes a REG_ACCEL_XOUT_H..REG_GYRO_ZOUT_L burst, any output pointer can be NULL
+static void MPU6050_DecodeSensors(MPU6050_ConfigTypeDef *config, uint8_t *data, uint32_t timestampUs, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+	if(accel != NULL){
+		accel->timestampUs = timestampUs;
+		accel->rawAccelX = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+		accel->rawAccelY = MPU6050_BYTES_TO_INT16(data[2], data[3]);
+		accel->rawAccelZ = MPU6050_BYTES_TO_INT16(data[4], data[5]);
+		MPU6050_ConvertAcceleration(config, accel);
+	}
+
+	if(temp != NULL){
+		temp->timestampUs = timestampUs;
+		temp->rawTemp = MPU6050_BYTES_TO_INT16(data[6], data[7]);
+		temp->convertedTemp = MPU6050_CONVERT_TEMP(temp->rawTemp);
+	}
+
+	if(rota != NULL){
+		rota->timestampUs = timestampUs;
+		rota->rawRotaX = MPU6050_BYTES_TO_INT16(data[8], data[9]);
+		rota->rawRotaY = MPU6050_BYTES_TO_INT16(data[10], data[11]);
+		rota->rawRotaZ = MPU6050_BYTES_TO_INT16(data[12], data[13]);
+		MPU6050_ConvertRotation(config, rota);
+	}
+}
+
+static uint8_t MPU6050_GetAllSensorsUntimed(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+	uint8_t data[MPU6050_SENSORS_BURST_LEN];
+
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_CONN_0;
+	}
+
+	// One auto-incrementing read of REG_ACCEL_XOUT_H..REG_GYRO_ZOUT_L, so all axes belong to the same sample
+	uint32_t timestampUs = MPU6050_GetTimeUs(config);
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_ACCEL_XOUT_H, data, sizeof(data))){
+		return ERR_CONN_0;
+	}
+
+	MPU6050_DecodeSensors(config, data, timestampUs, accel, rota, temp);
+
+	return CONN_OK;
+}
+
+uint8_t MPU6050_GetAllSensors(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+	MPU6050_STATS_RETURN(config, STATS_GET_ALL, MPU6050_GetAllSensorsUntimed(config, accel, rota, temp));
+}
+
+// REG_EXT_SENS_DATA_00 follows REG_GYRO_ZOUT_L, the auxiliary bytes extend the same burst
+static uint8_t MPU6050_GetAllSensorsExtUntimed(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp, uint8_t *extData) {
+	uint8_t data[MPU6050_SENSORS_BURST_LEN + MPU6050_EXT_SENS_DATA_LEN];
+	uint8_t extLen = MPU6050_AuxGetExtLen(config);
+
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_CONN_0;
+	}
+
+	uint32_t timestampUs = MPU6050_GetTimeUs(config);
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_ACCEL_XOUT_H, data, MPU6050_SENSORS_BURST_LEN + extLen)){
+		return ERR_CONN_0;
+	}
+
+	MPU6050_DecodeSensors(config, data, timestampUs, accel, rota, temp);
+	for(uint8_t i = 0; i < extLen; i++){
+		extData[i] = data[MPU6050_SENSORS_BURST_LEN + i];
+	}
+
+	return CONN_OK;
+}
+
+uint8_t MPU6050_GetAllSensorsExt(MPU6050_ConfigTypeDef *config, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp, uint8_t *extData) {
+	MPU6050_STATS_RETURN(config, STATS_GET_ALL_EXT, MPU6050_GetAllSensorsExtUntimed(config, accel, rota, temp, extData));
+}
+
+static uint8_t MPU6050_AsyncStartTransport(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len) {
+	if(HAL_OK != MPU6050_GetTransport(config)->startRead(config->hi2c, config->address, reg, data, len)){
+		return ERR_ASYNC_CONN;
+	}
+
+	return ASYNC_OK;
+}
+
+// INT_STATUS is cleared on read: the flags another function waits for are kept until it runs
+static void MPU6050_KeepIntStatus(MPU6050_ConfigTypeDef *config, uint8_t intStatus) {
+	config->intStatusPending |= intStatus & MOT_INT_FLAG;
+}
+
+static uint16_t MPU6050_AsyncBurstLen(MPU6050_AsyncReader *reader) {
+	return MPU6050_SENSORS_BURST_LEN + (REG_ACCEL_XOUT_H - reader->burstReg);
+}
+
+void MPU6050_AsyncInit(MPU6050_AsyncReader *reader, MPU6050_ConfigTypeDef *config, MPU6050_AsyncStartFn startRead, MPU6050_AsyncCallback callback, void *context) {
+	reader->config = config;
+	reader->startRead = startRead;
+	if(NULL == startRead && MPU6050_GetTransport(config)->startRead != NULL){
+		reader->startRead = MPU6050_AsyncStartTransport;
+	}
+	reader->callback = callback;
+	reader->context = context;
+	reader->burstReg = REG_ACCEL_XOUT_H;
+	reader->readyIndex = 0;
+	reader->busy = FALSE;
+	reader->sequence = 0;
+	reader->errors = 0;
+	reader->intStatus = 0;
+}
+
+uint8_t MPU6050_AsyncStart(MPU6050_AsyncReader *reader) {
+	if(reader->busy){
+		return ERR_ASYNC_BUSY;
+	}
+
+	// The transfer always targets the buffer the application is not reading
+	uint8_t writeIndex = reader->readyIndex ^ 1;
+
+	reader->busy = TRUE;
+	reader->startTimestampUs = MPU6050_GetTimeUs(reader->config);
+#if MPU6050_STATS
+	reader->startTicks = MPU6050_StatsStart(reader->config);
+#endif
+
+	// Transports without non-blocking reads complete the transfer here
+	if(NULL == reader->startRead){
+		MPU6050_ConfigTypeDef *config = reader->config;
+		HAL_StatusTypeDef status = MPU6050_GetTransport(config)->read(config->hi2c, config->address, reader->burstReg, reader->rawData[writeIndex], MPU6050_AsyncBurstLen(reader));
+		MPU6050_AsyncComplete(reader, HAL_OK == status);
+		return (HAL_OK == status) ? ASYNC_OK : ERR_ASYNC_CONN;
+	}
+
+	if(ASYNC_OK != reader->startRead(reader->config, reader->burstReg, reader->rawData[writeIndex], MPU6050_AsyncBurstLen(reader))){
+#if MPU6050_STATS
+		MPU6050_StatsTransfer(reader->config, STATS_ASYNC, reader->startTicks, HAL_ERROR, 0, 0);
+#endif
+		reader->busy = FALSE;
+		reader->errors++;
+		return ERR_ASYNC_CONN;
+	}
+
+	return ASYNC_OK;
+}
+
+// Call from HAL_I2C_MemRxCpltCallback (transferOk = TRUE) or HAL_I2C_ErrorCallback (transferOk = FALSE)
+void MPU6050_AsyncComplete(MPU6050_AsyncReader *reader, uint8_t transferOk) {
+	uint8_t status = ASYNC_OK;
+
+	if(!reader->busy){
+		return;
+	}
+
+#if MPU6050_STATS
+	MPU6050_StatsTransfer(reader->config, STATS_ASYNC, reader->startTicks, transferOk ? HAL_OK : HAL_ERROR, MPU6050_AsyncBurstLen(reader), 0);
+#endif
+	MPU6050_UpdateHealth(reader->config, transferOk ? HAL_OK : HAL_ERROR);
+
+	if(transferOk){
+		uint8_t writeIndex = reader->readyIndex ^ 1;
+		uint8_t *sensors = &reader->rawData[writeIndex][REG_ACCEL_XOUT_H - reader->burstReg];
+
+		if(REG_INT_STATUS == reader->burstReg){
+			reader->intStatus = reader->rawData[writeIndex][0];
+			MPU6050_KeepIntStatus(reader->config, reader->intStatus);
+		}
+		MPU6050_DecodeSensors(reader->config, sensors, reader->startTimestampUs, &reader->accel[writeIndex], &reader->rota[writeIndex], &reader->temp[writeIndex]);
+
+		// The sample is complete before it is published, and published before the next decode starts
+		MPU6050_MEMORY_BARRIER();
+		reader->sequence++;
+		reader->readyIndex = writeIndex;
+		reader->sequence++;
+		MPU6050_MEMORY_BARRIER();
+	}
+	else{
+		reader->errors++;
+		status = ERR_ASYNC_CONN;
+	}
+
+	reader->busy = FALSE;
+
+	if(reader->callback != NULL){
+		reader->callback(reader, status, reader->context);
+	}
+}
+
+uint8_t MPU6050_AsyncGetSample(MPU6050_AsyncReader *reader, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+	uint32_t sequence;
+	uint8_t index;
+
+	// Retry if a completion published a new buffer while copying
+	do{
+		sequence = reader->sequence;
+		if(0 == sequence){
+			return ERR_ASYNC_NO_DATA;
+		}
+		// The copies below are neither hoisted above the first sequence read nor sunk below the second
+		MPU6050_MEMORY_BARRIER();
+		index = reader->readyIndex;
+
+		if(accel != NULL){
+			*accel = reader->accel[index];
+		}
+		if(rota != NULL){
+			*rota = reader->rota[index];
+		}
+		if(temp != NULL){
+			*temp = reader->temp[index];
+		}
+		MPU6050_MEMORY_BARRIER();
+	} while((sequence & 1) || (sequence != reader->sequence));
+
+	return ASYNC_OK;
+}
+
+uint8_t MPU6050_ConfigInterrupts(MPU6050_ConfigTypeDef *config, uint8_t intPinConf, uint8_t intEnableConf) {
+	uint8_t data[2] = {intPinConf, intEnableConf};	// REG_INT_PIN_CFG and REG_INT_ENABLE are contiguous
+	uint8_t checkData[2];
+
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_INT_PIN_CFG, data, sizeof(data))){
+		return ERR_INT_CONN;
+	}
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_INT_PIN_CFG, checkData, sizeof(checkData))){
+		return ERR_INT_CONN;
+	}
+	if(checkData[0] != intPinConf || checkData[1] != intEnableConf){
+		return ERR_INT_VERIFY;
+	}
+
+	config->intPinConfig = intPinConf;
+	config->intEnableConfig = intEnableConf;
+
+	return INT_OK;
+}
+
+static uint8_t MPU6050_GetIntStatusUntimed(MPU6050_ConfigTypeDef *config, uint8_t *intStatus) {
+
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_INT_STATUS, intStatus, sizeof(*intStatus))){
+		return ERR_INT_CONN;
+	}
+	MPU6050_KeepIntStatus(config, *intStatus);
+
+	return INT_OK;
+}
+
+uint8_t MPU6050_GetIntStatus(MPU6050_ConfigTypeDef *config, uint8_t *intStatus) {
+	MPU6050_STATS_RETURN(config, STATS_INT_STATUS, MPU6050_GetIntStatusUntimed(config, intStatus));
+}
+
+// The reads are started from the EXTI interrupt: a reader without a non-blocking start (transport
+// without startRead, e.g. Linux or the simulator) would run the whole I2C transfer inside it.
+// The bursts start at INT_STATUS so that a latched INT pin is released by every read
+uint8_t MPU6050_DataReadyInit(MPU6050_DataReady *drdy, MPU6050_AsyncReader *reader) {
+	if(NULL == reader->startRead){
+		return ERR_INT_BLOCKING_READER;
+	}
+
+	reader->burstReg = REG_INT_STATUS;
+	drdy->reader = reader;
+	drdy->pending = FALSE;
+	drdy->dataReadyCount = 0;
+	drdy->missedSamples = 0;
+	drdy->duplicateSamples = 0;
+	drdy->lastSequence = reader->sequence;
+
+	return INT_OK;
+}
+
+// Call from HAL_GPIO_EXTI_Callback for the pin wired to the MPU6050 INT output
+void MPU6050_DataReadyIRQHandler(MPU6050_DataReady *drdy) {
+	drdy->dataReadyCount++;
+
+	if(drdy->reader->busy){
+		// The in-flight read holds the previous sample, read this one as soon as it ends
+		if(drdy->pending){
+			drdy->missedSamples++;
+		}
+		drdy->pending = TRUE;
+		return;
+	}
+
+	if(ASYNC_OK != MPU6050_AsyncStart(drdy->reader)){
+		drdy->missedSamples++;
+	}
+}
+
+// Call instead of MPU6050_AsyncComplete from the HAL I2C completion and error callbacks
+void MPU6050_DataReadyComplete(MPU6050_DataReady *drdy, uint8_t transferOk) {
+	MPU6050_AsyncComplete(drdy->reader, transferOk);
+
+	if(drdy->pending){
+		drdy->pending = FALSE;
+		if(ASYNC_OK != MPU6050_AsyncStart(drdy->reader)){
+			drdy->missedSamples++;
+		}
+	}
+}
+
+uint8_t MPU6050_DataReadyGetSample(MPU6050_DataReady *drdy, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp) {
+	uint32_t sequence = drdy->reader->sequence;
+
+	if(sequence == drdy->lastSequence){
+		drdy->duplicateSamples++;
+		return ERR_INT_NO_NEW_SAMPLE;
+	}
+
+	if(ASYNC_OK != MPU6050_AsyncGetSample(drdy->reader, accel, rota, temp)){
+		return ERR_INT_NO_NEW_SAMPLE;
+	}
+
+	// Samples published and replaced since the last call never reached the consumer
+	uint32_t published = (drdy->reader->sequence - drdy->lastSequence) / 2;
+	if(published > 1){
+		drdy->missedSamples += published - 1;
+	}
+	drdy->lastSequence = drdy->reader->sequence;
+
+	return INT_OK;
+}
+
+uint8_t MPU6050_FifoEnable(MPU6050_ConfigTypeDef *config, uint8_t fifoEnConf) {
+	uint8_t userCtrl;
+
+	config->fifoEnConfig = fifoEnConf;
+
+	if(0 == MPU6050_GetFifoFrameSize(config)){
+		return ERR_FIFO_NOT_CONFIGURED;
+	}
+
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_FIFO_EN, &fifoEnConf, sizeof(fifoEnConf))){
+		return ERR_FIFO_CONN;
+	}
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_FIFO_CONN;
+	}
+
+	// Start from an empty FIFO so the first frame is aligned
+	userCtrl |= FIFO_EN_CONFIG_SET | FIFO_RESET_CONFIG_SET;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_FIFO_CONN;
+	}
+
+	return FIFO_OK;
+}
 
-uint8_t MPU6050_Init(MPU6050_ConfigTypeDef *config) {
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t addr = config->address;
-	uint8_t dlpfFsyncConf = config->dlpfFsyncConfig;
-	uint8_t smplRateConf = config->smplRateDivConfig;
-	uint8_t pwrMgmt1Conf = config->pwrMgmt1Config;
-	uint8_t pwrMgmt2Conf = config->pwrMgmt2Config;
-	uint8_t accelConf = config->accelConfig;
-	uint8_t gyroConf = config->gyroConfig;
-
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_CONFIG, I2C_MEMADD_SIZE_8BIT, &dlpfFsyncConf, sizeof(dlpfFsyncConf), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_SMPLRT_DIV, I2C_MEMADD_SIZE_8BIT, &smplRateConf, sizeof(smplRateConf), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_PWR_MGMT_1, I2C_MEMADD_SIZE_8BIT, &pwrMgmt1Conf, sizeof(pwrMgmt1Conf), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_PWR_MGMT_2, I2C_MEMADD_SIZE_8BIT, &pwrMgmt2Conf, sizeof(pwrMgmt2Conf), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_ACCEL_CONFIG, I2C_MEMADD_SIZE_8BIT, &accelConf, sizeof(accelConf), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_GYRO_CONFIG, I2C_MEMADD_SIZE_8BIT, &gyroConf, sizeof(gyroConf), MPU6050_TIMEOUT_MS);
+uint8_t MPU6050_FifoDisable(MPU6050_ConfigTypeDef *config) {
+	uint8_t userCtrl;
+	uint8_t fifoEnConf = 0;
 
-	uint8_t checkData;
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_CONFIG, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != dlpfFsyncConf){
-		return ERR_INIT_0;
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_FIFO_CONN;
+	}
+
+	userCtrl &= (uint8_t)~FIFO_EN_CONFIG_SET;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_FIFO_CONN;
 	}
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_SMPLRT_DIV, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != smplRateConf){
-		return ERR_INIT_1;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_FIFO_EN, &fifoEnConf, sizeof(fifoEnConf))){
+		return ERR_FIFO_CONN;
 	}
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_PWR_MGMT_1, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != pwrMgmt1Conf){
-		return ERR_INIT_2;
+
+	config->fifoEnConfig = fifoEnConf;
+
+	return FIFO_OK;
+}
+
+uint8_t MPU6050_FifoReset(MPU6050_ConfigTypeDef *config) {
+	uint8_t userCtrl;
+
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_FIFO_CONN;
 	}
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_PWR_MGMT_2, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != pwrMgmt2Conf){
-		return ERR_INIT_3;
+
+	userCtrl |= FIFO_RESET_CONFIG_SET;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_FIFO_CONN;
 	}
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ACCEL_CONFIG, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != accelConf){
-		return ERR_INIT_4;
+
+	return FIFO_OK;
+}
+
+static uint8_t MPU6050_GetFifoCountUntimed(MPU6050_ConfigTypeDef *config, uint16_t *fifoCount) {
+	uint8_t data[2];
+
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_FIFO_COUNTH, data, sizeof(data))){
+		return ERR_FIFO_CONN;
 	}
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_GYRO_CONFIG, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != gyroConf){
-		return ERR_INIT_5;
+
+	*fifoCount = (uint16_t)((data[0] << 8) | data[1]);
+
+	return FIFO_OK;
+}
+
+uint8_t MPU6050_GetFifoCount(MPU6050_ConfigTypeDef *config, uint16_t *fifoCount) {
+	MPU6050_STATS_RETURN(config, STATS_FIFO_COUNT, MPU6050_GetFifoCountUntimed(config, fifoCount));
+}
+
+// EXT_SENS_DATA bytes of a slave (0 when disabled or writing)
+static uint8_t MPU6050_AuxSlaveLen(MPU6050_ConfigTypeDef *config, uint8_t slave) {
+	uint8_t *slvConf = config->i2cSlvConfig[slave];
+
+	if(!(slvConf[2] & I2C_SLV_EN_CONFIG_SET) || !(slvConf[0] & I2C_SLV_RNW_CONFIG_SET)){
+		return 0;
 	}
 
-	return INIT_OK;
+	return slvConf[2] & GET_I2C_SLV_LEN_CONFIG;
 }
 
-uint8_t MPU6050_Test_Conn(MPU6050_ConfigTypeDef *config) {
-	uint8_t addr = config->address;
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
+// Auxiliary bytes at the end of every FIFO frame: slaves 0..2 (REG_FIFO_EN), then slave 3
+// (REG_I2C_MST_CTRL), always last. Slaves not loaded into the FIFO leave no gap
+static uint8_t MPU6050_FifoExtLen(MPU6050_ConfigTypeDef *config) {
+	uint8_t fifoEnConf = config->fifoEnConfig;
+	uint8_t extLen = 0;
 
-	uint8_t checkData;
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_WHO_AM_I, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
+	if(fifoEnConf & SLV0_FIFO_EN_CONFIG_SET){
+		extLen += MPU6050_AuxSlaveLen(config, 0);
+	}
+	if(fifoEnConf & SLV1_FIFO_EN_CONFIG_SET){
+		extLen += MPU6050_AuxSlaveLen(config, 1);
+	}
+	if(fifoEnConf & SLV2_FIFO_EN_CONFIG_SET){
+		extLen += MPU6050_AuxSlaveLen(config, 2);
+	}
+	if(config->i2cMstCtrlConfig & SLV3_FIFO_EN_CONFIG_SET){
+		extLen += MPU6050_AuxSlaveLen(config, 3);
+	}
+
+	return extLen;
+}
+
+uint8_t MPU6050_GetFifoFrameSize(MPU6050_ConfigTypeDef *config) {
+	uint8_t fifoEnConf = config->fifoEnConfig;
+	uint8_t frameSize = MPU6050_FifoExtLen(config);
+
+	if(fifoEnConf & ACCEL_FIFO_EN_CONFIG_SET){
+		frameSize += 6;
+	}
+	if(fifoEnConf & TEMP_FIFO_EN_CONFIG_SET){
+		frameSize += 2;
+	}
+	if(fifoEnConf & XG_FIFO_EN_CONFIG_SET){
+		frameSize += 2;
+	}
+	if(fifoEnConf & YG_FIFO_EN_CONFIG_SET){
+		frameSize += 2;
+	}
+	if(fifoEnConf & ZG_FIFO_EN_CONFIG_SET){
+		frameSize += 2;
+	}
+
+	return frameSize;
+}
+
+// Frames are stored in register order: ACCEL, TEMP, GYRO X/Y/Z, EXT_SENS_DATA of slaves 0..3
+static void MPU6050_DecodeFifoFrame(MPU6050_ConfigTypeDef *config, uint8_t *data, uint8_t extLen, uint32_t timestampUs, MPU6050_FifoSample *sample) {
+	uint8_t fifoEnConf = config->fifoEnConfig;
+
+	sample->accel.timestampUs = timestampUs;
+	sample->rota.timestampUs = timestampUs;
+	sample->temp.timestampUs = timestampUs;
+
+	if(fifoEnConf & ACCEL_FIFO_EN_CONFIG_SET){
+		sample->accel.rawAccelX = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+		sample->accel.rawAccelY = MPU6050_BYTES_TO_INT16(data[2], data[3]);
+		sample->accel.rawAccelZ = MPU6050_BYTES_TO_INT16(data[4], data[5]);
+		MPU6050_ConvertAcceleration(config, &sample->accel);
+		data += 6;
+	}
+	if(fifoEnConf & TEMP_FIFO_EN_CONFIG_SET){
+		sample->temp.rawTemp = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+		sample->temp.convertedTemp = MPU6050_CONVERT_TEMP(sample->temp.rawTemp);
+		data += 2;
+	}
+	if(fifoEnConf & XG_FIFO_EN_CONFIG_SET){
+		sample->rota.rawRotaX = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+		data += 2;
+	}
+	if(fifoEnConf & YG_FIFO_EN_CONFIG_SET){
+		sample->rota.rawRotaY = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+		data += 2;
+	}
+	if(fifoEnConf & ZG_FIFO_EN_CONFIG_SET){
+		sample->rota.rawRotaZ = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+		data += 2;
+	}
+	if(fifoEnConf & (XG_FIFO_EN_CONFIG_SET | YG_FIFO_EN_CONFIG_SET | ZG_FIFO_EN_CONFIG_SET)){
+		MPU6050_ConvertRotation(config, &sample->rota);
+	}
+
+#if MPU6050_FIFO_EXT_LEN > 0
+	// Auxiliary bytes beyond MPU6050_FIFO_EXT_LEN are dropped
+	for(uint8_t i = 0; i < extLen && i < MPU6050_FIFO_EXT_LEN; i++){
+		sample->extData[i] = data[i];
+	}
+#else
+	(void)extLen;
+#endif
+}
 
-	if(0x68 == checkData){
-		return CONN_OK;
+// Places the newest frame of the sensor FIFO on the host clock and refines the period estimate.
+// Returns the time of the oldest frame as an offset from nowUs in 1/256 us
+static int64_t MPU6050_FifoSync(MPU6050_ConfigTypeDef *config, MPU6050_FifoRing *ring, uint32_t nowUs, uint16_t framesAvailable) {
+	uint32_t nominalPeriodUs = MPU6050_GetSamplePeriodUs(config);
+	int64_t newestQ8;
+
+	if(0 == ring->periodQ8 || ring->nominalPeriodUs != nominalPeriodUs){
+		// First drain or interrupted stream: the newest frame is taken as produced half a period ago
+		ring->periodQ8 = nominalPeriodUs << 8;
+		ring->nominalPeriodUs = nominalPeriodUs;
+		ring->streamIndex = 0;
+		ring->refTimestampUs = nowUs;
+		ring->refIndex = framesAvailable - 1;
+		newestQ8 = -(int64_t)(ring->periodQ8 / 2);
 	}
 	else{
-		return ERR_CONN_0;
+		uint32_t windowFrames = ring->streamIndex + framesAvailable - 1 - ring->refIndex;
+		uint32_t windowUs = nowUs - ring->refTimestampUs;
+
+		// Host time over sensor frames: the phase of nowUs within a period averages out over the window
+		if(windowFrames >= MPU6050_FIFO_TS_MIN_WINDOW){
+			uint32_t nominalQ8 = nominalPeriodUs << 8;
+			uint32_t maxDriftQ8 = nominalQ8 / MPU6050_FIFO_TS_MAX_DRIFT;
+			uint32_t periodQ8 = (uint32_t)(((uint64_t)windowUs << 8) / windowFrames);
+
+			if(periodQ8 > nominalQ8 + maxDriftQ8){
+				periodQ8 = nominalQ8 + maxDriftQ8;
+			}
+			else if(periodQ8 < nominalQ8 - maxDriftQ8){
+				periodQ8 = nominalQ8 - maxDriftQ8;
+			}
+			ring->periodQ8 = periodQ8;
+		}
+		if(windowFrames >= MPU6050_FIFO_TS_MAX_WINDOW){
+			ring->refTimestampUs += windowUs / 2;
+			ring->refIndex += windowFrames / 2;
+		}
+
+		// Continues from the last frame drained. nowUs falls at a random point of the period of the
+		// newest frame, so the phase is pulled towards half a period and kept within that period
+		newestQ8 = (int64_t)(int32_t)(ring->lastTimestampUs - nowUs) * 256 + ring->lastTimestampFrac + (int64_t)framesAvailable * ring->periodQ8;
+		newestQ8 += (-(int64_t)(ring->periodQ8 / 2) - newestQ8) / MPU6050_FIFO_TS_PHASE_GAIN;
+		if(newestQ8 > 0){
+			newestQ8 = 0;
+		}
+		else if(newestQ8 < -(int64_t)ring->periodQ8){
+			newestQ8 = -(int64_t)ring->periodQ8;
+		}
 	}
+
+	return newestQ8 - (int64_t)(framesAvailable - 1) * ring->periodQ8;
 }
 
-uint16_t MPU6050_GetAccelSensitivity(MPU6050_ConfigTypeDef *config) {
-	uint8_t accelConf = config->accelConfig & GET_ACCEL_FS_CONFIG;
+static uint8_t MPU6050_FifoDrainUntimed(MPU6050_ConfigTypeDef *config, MPU6050_FifoRing *ring) {
+	uint8_t data[MPU6050_FIFO_CHUNK_LEN];
+	uint8_t intStatus;
+	uint8_t countData[2];
+	MPU6050_RegBlock blocks[2] = {
+		{REG_INT_STATUS, &intStatus, sizeof(intStatus)},
+		{REG_FIFO_COUNTH, countData, sizeof(countData)}
+	};
+
+	uint8_t frameSize = MPU6050_GetFifoFrameSize(config);
+	uint8_t extLen = MPU6050_FifoExtLen(config);
+	if(0 == frameSize){
+		return ERR_FIFO_NOT_CONFIGURED;
+	}
 
-	switch(accelConf){
-		case ACCEL_CONFIG_SCALE_0:
-			return ACCEL_LSB_SEN_0;
-			break;
-		case ACCEL_CONFIG_SCALE_1:
-			return ACCEL_LSB_SEN_1;
-			break;
-		case ACCEL_CONFIG_SCALE_2:
-			return ACCEL_LSB_SEN_2;
-			break;
-		case ACCEL_CONFIG_SCALE_3:
-			return ACCEL_LSB_SEN_3;
-			break;
-		default:
-			return ERR_CONFIG_ACCEL;
-			break;
+	// Reading INT_STATUS also clears the overflow flag. FIFO_COUNT is latched during the read, so
+	// the newest frame is placed against the clock once the read has completed
+	if(HAL_OK != MPU6050_ReadBlocks(config, blocks, 2)){
+		return ERR_FIFO_CONN;
+	}
+	uint32_t nowUs = MPU6050_GetTimeUs(config);
+	MPU6050_KeepIntStatus(config, intStatus);
+	if(intStatus & FIFO_OFLOW_INT_FLAG){
+		// The oldest bytes were overwritten so frame alignment is lost: drop everything and restart
+		ring->overflows++;
+		ring->periodQ8 = 0;
+		if(FIFO_OK != MPU6050_FifoReset(config)){
+			return ERR_FIFO_CONN;
+		}
+		return ERR_FIFO_OVERFLOW;
+	}
+
+	uint16_t fifoCount = (uint16_t)((countData[0] << 8) | countData[1]);
+	uint16_t framesAvailable = fifoCount / frameSize;
+	if(0 == framesAvailable){
+		return FIFO_OK;
 	}
+
+	int64_t frameTimeQ8 = MPU6050_FifoSync(config, ring, nowUs, framesAvailable);
+
+	// Only whole frames that fit in the ring are read, the rest stays in the sensor FIFO
+	uint16_t framesPending = framesAvailable;
+	uint16_t framesFree = ring->size - ring->count;
+	if(framesPending > framesFree){
+		framesPending = framesFree;
+	}
+
+	uint16_t framesPerChunk = MPU6050_FIFO_CHUNK_LEN / frameSize;
+
+	while(framesPending > 0){
+		uint16_t frames = (framesPending < framesPerChunk) ? framesPending : framesPerChunk;
+
+		if(HAL_OK != MPU6050_ReadRegs(config, REG_FIFO_R_W, data, frames * frameSize)){
+			ring->periodQ8 = 0;
+			return ERR_FIFO_CONN;
+		}
+
+		for(uint16_t i = 0; i < frames; i++){
+			ring->lastTimestampUs = nowUs + (uint32_t)(int32_t)(frameTimeQ8 >> 8);
+			ring->lastTimestampFrac = (uint8_t)(frameTimeQ8 & 0xFF);
+			ring->streamIndex++;
+			frameTimeQ8 += ring->periodQ8;
+
+			MPU6050_DecodeFifoFrame(config, &data[i * frameSize], extLen, ring->lastTimestampUs, &ring->samples[ring->head]);
+			ring->head = (ring->head + 1) % ring->size;
+			ring->count++;
+		}
+
+		framesPending -= frames;
+	}
+
+	return FIFO_OK;
 }
 
-float MPU6050_GetGyroSensitivty(MPU6050_ConfigTypeDef *config) {
-	uint8_t gyroConf = config->gyroConfig & GET_GYRO_FS_CONFIG;
+uint8_t MPU6050_FifoDrain(MPU6050_ConfigTypeDef *config, MPU6050_FifoRing *ring) {
+	MPU6050_STATS_RETURN(config, STATS_FIFO_DRAIN, MPU6050_FifoDrainUntimed(config, ring));
+}
 
-	switch(gyroConf){
-		case GYRO_CONFIG_SCALE_0:
-			return GYRO_LSB_SEN_0;
-			break;
-		case GYRO_CONFIG_SCALE_1:
-			return GYRO_LSB_SEN_1;
-			break;
-		case GYRO_CONFIG_SCALE_2:
-			return GYRO_LSB_SEN_2;
-			break;
-		case GYRO_CONFIG_SCALE_3:
-			return GYRO_LSB_SEN_3;
-			break;
-		default:
-			return (float)ERR_CONFIG_GYRO;
-			break;
+void MPU6050_FifoRingInit(MPU6050_FifoRing *ring, MPU6050_FifoSample *samples, uint16_t size) {
+	ring->samples = samples;
+	ring->size = size;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->count = 0;
+	ring->overflows = 0;
+	ring->periodQ8 = 0;
+	ring->nominalPeriodUs = 0;
+	ring->streamIndex = 0;
+	ring->lastTimestampUs = 0;
+	ring->lastTimestampFrac = 0;
+	ring->refTimestampUs = 0;
+	ring->refIndex = 0;
+}
+
+uint8_t MPU6050_FifoPop(MPU6050_FifoRing *ring, MPU6050_FifoSample *sample) {
+	if(0 == ring->count){
+		return ERR_FIFO_EMPTY;
 	}
+
+	*sample = ring->samples[ring->tail];
+	ring->tail = (ring->tail + 1) % ring->size;
+	ring->count--;
+
+	return FIFO_OK;
 }
 
-uint8_t MPU6050_GetAcceleration(MPU6050_ConfigTypeDef *config , MPU6050_Accelerations *accel) {
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t addr = config->address;
-	uint8_t data_L;
-	uint8_t data_H;
+// Writes every auxiliary register from the shadow values, then sets I2C_MST_EN
+static uint8_t MPU6050_AuxApply(MPU6050_ConfigTypeDef *config) {
+	uint8_t mstConf[1 + 3 * MPU6050_AUX_SLAVES];	// REG_I2C_MST_CTRL..REG_I2C_SLV3_CTRL
+	uint8_t doConf[MPU6050_AUX_SLAVES + 1];			// REG_I2C_SLV0_DO..REG_I2C_MST_DELAY_CTRL
+	uint8_t userCtrl;
+
+	mstConf[0] = config->i2cMstCtrlConfig;
+	for(uint8_t i = 0; i < MPU6050_AUX_SLAVES; i++){
+		mstConf[1 + 3 * i] = config->i2cSlvConfig[i][0];
+		mstConf[2 + 3 * i] = config->i2cSlvConfig[i][1];
+		mstConf[3 + 3 * i] = config->i2cSlvConfig[i][2];
+		doConf[i] = config->i2cSlvDoConfig[i];
+	}
+	doConf[MPU6050_AUX_SLAVES] = config->i2cMstDelayCtrlConfig;
 
-	if(CONN_OK != MPU6050_Test_Conn(config)){
-		return ERR_CONN_0;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_I2C_MST_CTRL, mstConf, sizeof(mstConf)) ||
+	   HAL_OK != MPU6050_WriteRegs(config, REG_I2C_SLV4_CTRL, &config->i2cSlv4CtrlConfig, sizeof(config->i2cSlv4CtrlConfig)) ||
+	   HAL_OK != MPU6050_WriteRegs(config, REG_I2C_SLV0_DO, doConf, sizeof(doConf))){
+		return ERR_AUX_CONN;
 	}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ACCEL_XOUT_L, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ACCEL_XOUT_H, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	accel->rawAccelX =  (int16_t)(data_H << 8) | data_L;
+	// The auxiliary bus cannot be mastered while it is bridged to the primary one
+	if(config->intPinConfig & I2C_BYPASS_EN_CONFIG_SET){
+		uint8_t intPinConf = config->intPinConfig & (uint8_t)~I2C_BYPASS_EN_CONFIG_SET;
+		if(HAL_OK != MPU6050_WriteRegs(config, REG_INT_PIN_CFG, &intPinConf, sizeof(intPinConf))){
+			return ERR_AUX_CONN;
+		}
+		config->intPinConfig = intPinConf;
+	}
+
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_AUX_CONN;
+	}
+	userCtrl |= I2C_MST_EN_CONFIG_SET;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_AUX_CONN;
+	}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ACCEL_YOUT_L, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ACCEL_YOUT_H, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	accel->rawAccelY =  (int16_t)(data_H << 8) | data_L;
+	return AUX_OK;
+}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ACCEL_ZOUT_L, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ACCEL_ZOUT_H, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	accel->rawAccelZ =  (int16_t)(data_H << 8) | data_L;
+uint8_t MPU6050_AuxEnable(MPU6050_ConfigTypeDef *config, uint8_t i2cMstCtrlConf, uint8_t mstDelay) {
+	if(mstDelay > GET_I2C_MST_DLY_CONFIG){
+		return ERR_AUX_INVALID;
+	}
 
-	uint16_t lsbSen = MPU6050_GetAccelSensitivity(config);
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_AUX_CONN;
+	}
 
-	accel->convertedAccelX = MPU6050_RAW_TO_F_DATA(accel->rawAccelX, lsbSen);
-	accel->convertedAccelY = MPU6050_RAW_TO_F_DATA(accel->rawAccelY, lsbSen);
-	accel->convertedAccelZ = MPU6050_RAW_TO_F_DATA(accel->rawAccelZ, lsbSen);
+	config->i2cMstCtrlConfig = i2cMstCtrlConf;
+	config->i2cSlv4CtrlConfig = mstDelay;
+	// EXT_SENS_DATA only changes once every slave has been read, a burst never mixes two samples
+	config->i2cMstDelayCtrlConfig |= DELAY_ES_SHADOW_CONFIG_SET;
+	config->auxEnabled = TRUE;
 
-	return CONN_OK;
+	return MPU6050_AuxApply(config);
 }
 
-uint8_t MPU6050_GetRotation(MPU6050_ConfigTypeDef *config, MPU6050_Rotations *rota) {
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t addr = config->address;
-	uint8_t data_L;
-	uint8_t data_H;
+uint8_t MPU6050_AuxDisable(MPU6050_ConfigTypeDef *config) {
+	uint8_t userCtrl;
 
-	if(CONN_OK != MPU6050_Test_Conn(config)){
-		return ERR_CONN_0;
+	if(HAL_OK != MPU6050_ReadRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_AUX_CONN;
+	}
+	userCtrl &= (uint8_t)~I2C_MST_EN_CONFIG_SET;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_USER_CTRL, &userCtrl, sizeof(userCtrl))){
+		return ERR_AUX_CONN;
 	}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_GYRO_XOUT_L, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_GYRO_XOUT_H, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	rota->rawRotaX =  (int16_t)(data_H << 8) | data_L;
+	config->auxEnabled = FALSE;
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_GYRO_YOUT_L, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_GYRO_YOUT_H, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	rota->rawRotaY =  (int16_t)(data_H << 8) | data_L;
+	return AUX_OK;
+}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_GYRO_ZOUT_L, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_GYRO_ZOUT_H, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	rota->rawRotaZ =  (int16_t)(data_H << 8) | data_L;
+uint8_t MPU6050_AuxConfigSlave(MPU6050_ConfigTypeDef *config, uint8_t slave, const MPU6050_AuxSlave *slaveConf) {
+	if(slave >= MPU6050_AUX_SLAVES){
+		return ERR_AUX_INVALID;
+	}
+	if(slaveConf->write ? (1 != slaveConf->len) : (0 == slaveConf->len || slaveConf->len > GET_I2C_SLV_LEN_CONFIG)){
+		return ERR_AUX_INVALID;
+	}
 
-	float lsbSen = MPU6050_GetGyroSensitivty(config);
+	// Read slaves fill EXT_SENS_DATA one after another
+	uint8_t extLen = slaveConf->write ? 0 : slaveConf->len;
+	for(uint8_t i = 0; i < MPU6050_AUX_SLAVES; i++){
+		if(i != slave){
+			extLen += MPU6050_AuxSlaveLen(config, i);
+		}
+	}
+	if(extLen > MPU6050_EXT_SENS_DATA_LEN){
+		return ERR_AUX_INVALID;
+	}
 
-	rota->convertedRotaX = MPU6050_RAW_TO_F_DATA(rota->rawRotaX, lsbSen);
-	rota->convertedRotaY = MPU6050_RAW_TO_F_DATA(rota->rawRotaY, lsbSen);
-	rota->convertedRotaZ = MPU6050_RAW_TO_F_DATA(rota->rawRotaZ, lsbSen);
+	uint8_t slvConf[3] = {
+		(uint8_t)((slaveConf->address & 0x7F) | (slaveConf->write ? 0 : I2C_SLV_RNW_CONFIG_SET)),
+		slaveConf->reg,
+		(uint8_t)(I2C_SLV_EN_CONFIG_SET | (slaveConf->flags & (I2C_SLV_BYTE_SW_CONFIG_SET | I2C_SLV_REG_DIS_CONFIG_SET | I2C_SLV_GRP_CONFIG_SET)) | slaveConf->len)
+	};
+	uint8_t delayCtrl = config->i2cMstDelayCtrlConfig & (uint8_t)~(I2C_SLV0_DLY_EN_CONFIG_SET << slave);
+	if(slaveConf->delayed){
+		delayCtrl |= (uint8_t)(I2C_SLV0_DLY_EN_CONFIG_SET << slave);
+	}
 
-	return CONN_OK;
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_AUX_CONN;
+	}
+
+	if(slaveConf->write){
+		uint8_t dataOut = slaveConf->dataOut;
+		if(HAL_OK != MPU6050_WriteRegs(config, REG_I2C_SLV0_DO + slave, &dataOut, sizeof(dataOut))){
+			return ERR_AUX_CONN;
+		}
+		config->i2cSlvDoConfig[slave] = dataOut;
+	}
+	if(delayCtrl != config->i2cMstDelayCtrlConfig){
+		if(HAL_OK != MPU6050_WriteRegs(config, REG_I2C_MST_DELAY_CTRL, &delayCtrl, sizeof(delayCtrl))){
+			return ERR_AUX_CONN;
+		}
+		config->i2cMstDelayCtrlConfig = delayCtrl;
+	}
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_I2C_SLV0_ADDR + 3 * slave, slvConf, sizeof(slvConf))){
+		return ERR_AUX_CONN;
+	}
+	for(uint8_t i = 0; i < 3; i++){
+		config->i2cSlvConfig[slave][i] = slvConf[i];
+	}
+
+	return AUX_OK;
 }
 
-uint8_t MPU6050_GetTemperature(MPU6050_ConfigTypeDef *config, MPU6050_Temperature *temp) {
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t addr = config->address;
-	uint8_t data_L;
-	uint8_t data_H;
+uint8_t MPU6050_AuxDisableSlave(MPU6050_ConfigTypeDef *config, uint8_t slave) {
+	uint8_t slvCtrl = 0;
 
-	if(TEMP_DIS_CONFIG_SET == (config->pwrMgmt1Config & TEMP_DIS_CONFIG_SET)){
-		return ERR_TEMP_DISABLED;
+	if(slave >= MPU6050_AUX_SLAVES){
+		return ERR_AUX_INVALID;
 	}
 
-	if(CONN_OK != MPU6050_Test_Conn(config)){
-		return ERR_CONN_0;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_I2C_SLV0_CTRL + 3 * slave, &slvCtrl, sizeof(slvCtrl))){
+		return ERR_AUX_CONN;
 	}
+	config->i2cSlvConfig[slave][2] = slvCtrl;
+
+	return AUX_OK;
+}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_TEMP_OUT_L, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_TEMP_OUT_H, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	temp->rawTemp =  (int16_t)(data_H << 8) | data_L;
+uint8_t MPU6050_AuxGetExtLen(MPU6050_ConfigTypeDef *config) {
+	return MPU6050_AuxGetExtOffset(config, MPU6050_AUX_SLAVES);
+}
 
-	float convTemp = (float)(temp->rawTemp / 340) + 36.54;
-	temp->convertedTemp = convTemp;
+// Position of the slave bytes in EXT_SENS_DATA (FIFO frames only hold the slaves enabled in the FIFO)
+uint8_t MPU6050_AuxGetExtOffset(MPU6050_ConfigTypeDef *config, uint8_t slave) {
+	uint8_t offset = 0;
 
-	return CONN_OK;
+	for(uint8_t i = 0; i < slave && i < MPU6050_AUX_SLAVES; i++){
+		offset += MPU6050_AuxSlaveLen(config, i);
+	}
+
+	return offset;
 }
 
-uint8_t MPU6050_GetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_AccelOffsets *accelOff) {
-	uint8_t addr = config->address;
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t data_L;
-	uint8_t data_H;
+// Single transfer through slave 4, run by the MPU6050 at its next sample
+static uint8_t MPU6050_AuxTransfer(MPU6050_ConfigTypeDef *config, uint8_t address, uint8_t reg, uint8_t *data, uint8_t read) {
+	// REG_I2C_SLV4_ADDR, REG_I2C_SLV4_REG, REG_I2C_SLV4_DO, REG_I2C_SLV4_CTRL
+	uint8_t slv4Conf[4] = {
+		(uint8_t)((address & 0x7F) | (read ? I2C_SLV_RNW_CONFIG_SET : 0)),
+		reg,
+		read ? 0 : *data,
+		(uint8_t)(I2C_SLV_EN_CONFIG_SET | config->i2cSlv4CtrlConfig)
+	};
+	uint8_t diStatus[2];	// REG_I2C_SLV4_DI, REG_I2C_MST_STATUS
+
+	if(!config->auxEnabled){
+		return ERR_AUX_INVALID;
+	}
 
-	if(CONN_OK != MPU6050_Test_Conn(config)){
-		return ERR_CONN_0;
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_AUX_CONN;
 	}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	accelOff->xOffset =  (int16_t)(data_H << 8) | data_L;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_I2C_SLV4_ADDR, slv4Conf, sizeof(slv4Conf))){
+		return ERR_AUX_CONN;
+	}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	accelOff->yOffset =  (int16_t)(data_H << 8) | data_L;
+	uint32_t startTick = HAL_GetTick();
+	do{
+		if(HAL_OK != MPU6050_ReadRegs(config, REG_I2C_SLV4_DI, diStatus, sizeof(diStatus))){
+			return ERR_AUX_CONN;
+		}
+		if(diStatus[1] & I2C_SLV4_NACK_FLAG){
+			return ERR_AUX_NACK;
+		}
+		if(diStatus[1] & I2C_SLV4_DONE_FLAG){
+			if(read){
+				*data = diStatus[0];
+			}
+			return AUX_OK;
+		}
+	} while((HAL_GetTick() - startTick) <= MPU6050_AUX_TIMEOUT_MS);
+
+	// Cancelled so it does not run later
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_I2C_SLV4_CTRL, &config->i2cSlv4CtrlConfig, sizeof(config->i2cSlv4CtrlConfig))){
+		return ERR_AUX_CONN;
+	}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	accelOff->zOffset =  (int16_t)(data_H << 8) | data_L;
+	return ERR_AUX_TIMEOUT;
+}
 
-	return CONN_OK;
+uint8_t MPU6050_AuxRead(MPU6050_ConfigTypeDef *config, uint8_t address, uint8_t reg, uint8_t *value) {
+	MPU6050_STATS_RETURN(config, STATS_AUX_READ, MPU6050_AuxTransfer(config, address, reg, value, TRUE));
 }
 
-uint8_t MPU6050_GetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_GyroOffsets *gyroOff) {
-	uint8_t addr = config->address;
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t data_L;
-	uint8_t data_H;
+uint8_t MPU6050_AuxWrite(MPU6050_ConfigTypeDef *config, uint8_t address, uint8_t reg, uint8_t value) {
+	MPU6050_STATS_RETURN(config, STATS_AUX_WRITE, MPU6050_AuxTransfer(config, address, reg, &value, FALSE));
+}
 
-	if(CONN_OK != MPU6050_Test_Conn(config)){
-		return ERR_CONN_0;
+uint8_t MPU6050_ConfigMotion(MPU6050_ConfigTypeDef *config, uint8_t motThr, uint8_t motDur, uint8_t motDetectCtrl) {
+	uint8_t motConf[2] = {motThr, motDur};	// REG_MOT_THR and REG_MOT_DUR are contiguous
+
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_MOT_THR, motConf, sizeof(motConf)) ||
+	   HAL_OK != MPU6050_WriteRegs(config, REG_MOT_DETECT_CTRL, &motDetectCtrl, sizeof(motDetectCtrl))){
+		return ERR_POWER_CONN;
 	}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	gyroOff->xOffset =  (int16_t)(data_H << 8) | data_L;
+	config->motThrConfig = motThr;
+	config->motDurConfig = motDur;
+	config->motDetectCtrlConfig = motDetectCtrl;
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	gyroOff->yOffset =  (int16_t)(data_H << 8) | data_L;
+	return POWER_OK;
+}
 
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	gyroOff->zOffset =  (int16_t)(data_H << 8) | data_L;
+// Accelerometer-only cycle mode: gyroscopes and temperature sensor in standby, the accelerometer
+// wakes up at LP_WAKE_CTRL. The motion detection compares every sample with the one held on entry
+static uint8_t MPU6050_CycleApply(MPU6050_ConfigTypeDef *config) {
+	uint8_t accelConf = (config->accelConfig & (uint8_t)~GET_ACCEL_HPF_CONFIG) | ACCEL_HPF_CONFIG_HOLD;
+	uint8_t pwrMgmtConf[2] = {
+		(uint8_t)((config->pwrMgmt1Config & (uint8_t)~SLEEP_CONFIG_SET) | CYCLE_CONFIG_SET | TEMP_DIS_CONFIG_SET),
+		(uint8_t)(config->lpWakeCtrlConfig | (config->pwrMgmt2Config & (STBY_XA_CONFIG_SET | STBY_YA_CONFIG_SET | STBY_ZA_CONFIG_SET)) |
+				  STBY_XG_CONFIG_SET | STBY_YG_CONFIG_SET | STBY_ZG_CONFIG_SET)
+	};
+
+	// Interrupts first, so the data-ready of the last full rate samples does not wake the host
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_INT_ENABLE, &config->cycleIntEnableConfig, sizeof(config->cycleIntEnableConfig)) ||
+	   HAL_OK != MPU6050_WriteRegs(config, REG_ACCEL_CONFIG, &accelConf, sizeof(accelConf)) ||
+	   HAL_OK != MPU6050_WriteRegs(config, REG_PWR_MGMT_1, pwrMgmtConf, sizeof(pwrMgmtConf))){
+		return ERR_POWER_CONN;
+	}
 
-	return CONN_OK;
+	return POWER_OK;
 }
 
-uint8_t MPU6050_SetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_AccelOffsets *accelOff) {
-	uint8_t addr = config->address;
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t data_L;
-	uint8_t data_H;
-	uint8_t checkData;
+uint8_t MPU6050_EnterCycleMode(MPU6050_ConfigTypeDef *config, uint8_t lpWakeCtrl, uint8_t intEnableConf) {
+	if(lpWakeCtrl & (uint8_t)~GET_LP_WAKE_CTRL_CONFIG){
+		return ERR_POWER_INVALID;
+	}
+
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_POWER_CONN;
+	}
+
+	config->lpWakeCtrlConfig = lpWakeCtrl;
+	config->cycleIntEnableConfig = intEnableConf;
+	config->cycleMode = TRUE;
+	config->intStatusPending &= (uint8_t)~MOT_INT_FLAG;
+
+	return MPU6050_CycleApply(config);
+}
+
+// Back to the registers of the configuration structure. The gyroscopes need up to 30ms to settle
+uint8_t MPU6050_ExitCycleMode(MPU6050_ConfigTypeDef *config) {
+	uint8_t pwrMgmtConf[2] = {config->pwrMgmt1Config, config->pwrMgmt2Config};
 
-	data_L = accelOff->xOffset & LOW_BYTE_MASK;
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_XA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_L){
-		return ERR_WRITE_OFF_X_L;
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_POWER_CONN;
 	}
 
-	data_H = ((accelOff->xOffset & HIGH_BYTE_MASK) >> (8));
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_XA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_H){
-		return ERR_WRITE_OFF_X_H;
+	if(HAL_OK != MPU6050_WriteRegs(config, REG_PWR_MGMT_1, pwrMgmtConf, sizeof(pwrMgmtConf)) ||
+	   HAL_OK != MPU6050_WriteRegs(config, REG_ACCEL_CONFIG, &config->accelConfig, sizeof(config->accelConfig)) ||
+	   HAL_OK != MPU6050_WriteRegs(config, REG_INT_ENABLE, &config->intEnableConfig, sizeof(config->intEnableConfig))){
+		return ERR_POWER_CONN;
 	}
 
-	data_L = accelOff->yOffset & LOW_BYTE_MASK;
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_YA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_L){
-		return ERR_WRITE_OFF_Y_L;
+	config->cycleMode = FALSE;
+
+	return POWER_OK;
+}
+
+// Motion detection must be configured first (MPU6050_ConfigMotion), its threshold is also used
+// on the samples of the active mode
+uint8_t MPU6050_PowerInit(MPU6050_PowerManager *pm, MPU6050_ConfigTypeDef *config, uint8_t lpWakeCtrl, uint32_t idleTimeoutMs) {
+	if((lpWakeCtrl & (uint8_t)~GET_LP_WAKE_CTRL_CONFIG) || 0 == config->motThrConfig){
+		return ERR_POWER_INVALID;
+	}
+
+	pm->config = config;
+	pm->lpWakeCtrl = lpWakeCtrl;
+	pm->idleTimeoutMs = idleTimeoutMs;
+	pm->pollIntervalMs = 0;
+	pm->motionPending = FALSE;
+	pm->lastMotionUs = MPU6050_GetTimeUs(config);
+	pm->lastPollUs = pm->lastMotionUs;
+	pm->refValid = FALSE;
+	pm->wakeUps = 0;
+	pm->idleEntries = 0;
+
+	return POWER_OK;
+}
+
+// Call from HAL_GPIO_EXTI_Callback for the pin wired to the MPU6050 INT output
+void MPU6050_PowerIRQHandler(MPU6050_PowerManager *pm) {
+	pm->motionPending = TRUE;
+}
+
+// Motion check of the active mode, on the samples the application reads anyway (no bus access).
+// A sample moving more than MOT_THR away from the reference restarts the idle timeout
+void MPU6050_PowerFeedSample(MPU6050_PowerManager *pm, const MPU6050_Accelerations *accel) {
+	int16_t sample[3] = {accel->rawAccelX, accel->rawAccelY, accel->rawAccelZ};
+	int32_t threshold = (int32_t)pm->config->motThrConfig * MPU6050_MOT_THR_MG * MPU6050_GetAccelSensitivity(pm->config) / 1000;
+	uint8_t moving = !pm->refValid;
+
+	for(uint8_t axis = 0; axis < 3; axis++){
+		if(ABS((int32_t)sample[axis] - pm->refAccel[axis]) > threshold){
+			moving = TRUE;
+		}
 	}
 
-	data_H = ((accelOff->yOffset & HIGH_BYTE_MASK) >> (8));
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_YA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_H){
-		return ERR_WRITE_OFF_Y_H;
+	if(moving){
+		pm->refAccel[0] = sample[0];
+		pm->refAccel[1] = sample[1];
+		pm->refAccel[2] = sample[2];
+		pm->refValid = TRUE;
+		pm->lastMotionUs = accel->timestampUs;
 	}
+}
 
-	data_L = accelOff->zOffset & LOW_BYTE_MASK;
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_ZA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZA_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_L){
-		return ERR_WRITE_OFF_Z_L;
+// Call periodically from the main loop. Active: enters the cycle mode after idleTimeoutMs without
+// motion. Cycle: reads INT_STATUS once the INT pin fired (or every pollIntervalMs) and wakes up on MOT_INT,
+// also when the flag was cleared by another read of INT_STATUS (FIFO drain, data-ready burst)
+uint8_t MPU6050_PowerUpdate(MPU6050_PowerManager *pm) {
+	MPU6050_ConfigTypeDef *config = pm->config;
+	uint32_t nowUs = MPU6050_GetTimeUs(config);
+	uint8_t intStatus;
+
+	if(!config->cycleMode){
+		if((nowUs - pm->lastMotionUs) < pm->idleTimeoutMs * 1000){
+			return POWER_OK;
+		}
+		if(POWER_OK != MPU6050_EnterCycleMode(config, pm->lpWakeCtrl, MOT_EN_CONFIG_SET)){
+			return ERR_POWER_CONN;
+		}
+		pm->motionPending = FALSE;
+		pm->lastPollUs = nowUs;
+		pm->idleEntries++;
+		return POWER_OK;
 	}
 
-	data_H = ((accelOff->zOffset & HIGH_BYTE_MASK) >> (8));
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_ZA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZA_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_H){
-		return ERR_WRITE_OFF_Z_H;
+	if(!pm->motionPending && !(config->intStatusPending & MOT_INT_FLAG)){
+		if(0 == pm->pollIntervalMs || (nowUs - pm->lastPollUs) < pm->pollIntervalMs * 1000){
+			return POWER_OK;
+		}
 	}
+	pm->motionPending = FALSE;
+	pm->lastPollUs = nowUs;
 
-	return WRITE_OK;
+	if(!(config->intStatusPending & MOT_INT_FLAG) && INT_OK != MPU6050_GetIntStatusUntimed(config, &intStatus)){
+		return ERR_POWER_CONN;
+	}
+	if(!(config->intStatusPending & MOT_INT_FLAG)){
+		return POWER_OK;
+	}
+	config->intStatusPending &= (uint8_t)~MOT_INT_FLAG;
+
+	if(POWER_OK != MPU6050_ExitCycleMode(config)){
+		return ERR_POWER_CONN;
+	}
+	pm->lastMotionUs = nowUs;
+	pm->refValid = FALSE;
+	pm->wakeUps++;
+
+	return POWER_OK;
 }
 
-uint8_t MPU6050_SetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_GyroOffsets *gyroOff) {
-	uint8_t addr = config->address;
-	I2C_HandleTypeDef *handleI2C = config->hi2c;
-	uint8_t data_L;
-	uint8_t data_H;
-	uint8_t checkData;
+uint8_t MPU6050_PowerGetMode(MPU6050_PowerManager *pm) {
+	return pm->config->cycleMode ? POWER_MODE_CYCLE : POWER_MODE_ACTIVE;
+}
+
+// The 3 offsets of a sensor are contiguous (X, Y, Z, high byte first)
+static uint8_t MPU6050_ReadOffsets(MPU6050_ConfigTypeDef *config, uint8_t reg, int16_t *x, int16_t *y, int16_t *z) {
+	uint8_t data[6];
 
-	data_L = gyroOff->xOffset & LOW_BYTE_MASK;
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_XG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_L){
-		return ERR_WRITE_OFF_X_L;
+	if(CONN_OK != MPU6050_CheckConnUntimed(config)){
+		return ERR_CONN_0;
 	}
 
-	data_H = ((gyroOff->xOffset & HIGH_BYTE_MASK) >> (8));
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_XG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_XG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_H){
-		return ERR_WRITE_OFF_X_H;
+	if(HAL_OK != MPU6050_ReadRegs(config, reg, data, sizeof(data))){
+		return ERR_CONN_0;
 	}
 
-	data_L = gyroOff->yOffset & LOW_BYTE_MASK;
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_YG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_L){
-		return ERR_WRITE_OFF_Y_L;
+	*x = MPU6050_BYTES_TO_INT16(data[0], data[1]);
+	*y = MPU6050_BYTES_TO_INT16(data[2], data[3]);
+	*z = MPU6050_BYTES_TO_INT16(data[4], data[5]);
+
+	return CONN_OK;
+}
+
+// One burst, no axis is ever left with a half-written 16-bit offset
+static uint8_t MPU6050_WriteOffsets(MPU6050_ConfigTypeDef *config, uint8_t reg, int16_t x, int16_t y, int16_t z, uint8_t verify) {
+	uint8_t data[6] = {
+		(uint8_t)((uint16_t)x >> 8), (uint8_t)(x & LOW_BYTE_MASK),
+		(uint8_t)((uint16_t)y >> 8), (uint8_t)(y & LOW_BYTE_MASK),
+		(uint8_t)((uint16_t)z >> 8), (uint8_t)(z & LOW_BYTE_MASK)
+	};
+	// WritingError of each byte of data
+	static const uint8_t errors[6] = {ERR_WRITE_OFF_X_H, ERR_WRITE_OFF_X_L, ERR_WRITE_OFF_Y_H, ERR_WRITE_OFF_Y_L, ERR_WRITE_OFF_Z_H, ERR_WRITE_OFF_Z_L};
+	uint8_t checkData[6];
+
+	if(HAL_OK != MPU6050_WriteRegs(config, reg, data, sizeof(data))){
+		return ERR_WRITE_CONN;
 	}
 
-	data_H = ((gyroOff->yOffset & HIGH_BYTE_MASK) >> (8));
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_YG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_YG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_H){
-		return ERR_WRITE_OFF_Y_H;
+	// Shadow for MPU6050_Reconnect
+	int16_t *shadow = (REG_XA_OFFS_USRH == reg) ? config->accelOffConfig : config->gyroOffConfig;
+	shadow[0] = x;
+	shadow[1] = y;
+	shadow[2] = z;
+	if(REG_XA_OFFS_USRH == reg){
+		config->accelOffSet = TRUE;
+	}
+	else{
+		config->gyroOffSet = TRUE;
 	}
 
-	data_L = gyroOff->zOffset & LOW_BYTE_MASK;
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_ZG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &data_L, sizeof(data_L), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZG_OFFS_USRL, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_L){
-		return ERR_WRITE_OFF_Z_L;
+	if(!verify){
+		return WRITE_OK;
 	}
 
-	data_H = ((gyroOff->zOffset & HIGH_BYTE_MASK) >> (8));
-	HAL_I2C_Mem_Write(handleI2C, addr<<1, REG_ZG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &data_H, sizeof(data_H), MPU6050_TIMEOUT_MS);
-	HAL_I2C_Mem_Read(handleI2C, addr<<1, REG_ZG_OFFS_USRH, I2C_MEMADD_SIZE_8BIT, &checkData, sizeof(checkData), MPU6050_TIMEOUT_MS);
-	if(checkData != data_H){
-		return ERR_WRITE_OFF_Z_H;
+	if(HAL_OK != MPU6050_ReadRegs(config, reg, checkData, sizeof(checkData))){
+		return ERR_WRITE_CONN;
+	}
+	for(uint8_t i = 0; i < sizeof(data); i++){
+		if(checkData[i] != data[i]){
+			return errors[i];
+		}
 	}
 
 	return WRITE_OK;
 }
 
-uint8_t MPU6050_CalibAccel(MPU6050_ConfigTypeDef *config, float calibTolerance) {
-    uint32_t readingsCount = 0;
-    uint32_t iterationsCount = 0;
+uint8_t MPU6050_GetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_AccelOffsets *accelOff) {
+	return MPU6050_ReadOffsets(config, REG_XA_OFFS_USRH, &accelOff->xOffset, &accelOff->yOffset, &accelOff->zOffset);
+}
+
+uint8_t MPU6050_GetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_GyroOffsets *gyroOff) {
+	return MPU6050_ReadOffsets(config, REG_XG_OFFS_USRH, &gyroOff->xOffset, &gyroOff->yOffset, &gyroOff->zOffset);
+}
+
+uint8_t MPU6050_SetAccelOffset(MPU6050_ConfigTypeDef *config, MPU6050_AccelOffsets *accelOff) {
+	return MPU6050_WriteOffsets(config, REG_XA_OFFS_USRH, accelOff->xOffset, accelOff->yOffset, accelOff->zOffset, MPU6050_OFFSET_VERIFY);
+}
+
+uint8_t MPU6050_SetGyroOffset(MPU6050_ConfigTypeDef *config, MPU6050_GyroOffsets *gyroOff) {
+	return MPU6050_WriteOffsets(config, REG_XG_OFFS_USRH, gyroOff->xOffset, gyroOff->yOffset, gyroOff->zOffset, MPU6050_OFFSET_VERIFY);
+}
+
+// Averages numReadings bursts of the 3 axes starting at reg, after discarding one possibly stale sample
+static HAL_StatusTypeDef MPU6050_CalibAverage(MPU6050_ConfigTypeDef *config, uint8_t reg, uint16_t numReadings, int32_t avg[3]) {
+	uint8_t data[6];
+	int32_t sum[3] = {0, 0, 0};
+
+	if(HAL_OK != MPU6050_ReadRegs(config, reg, data, sizeof(data))){
+		return HAL_ERROR;
+	}
+
+	for(uint16_t i = 0; i < numReadings; i++){
+		if(HAL_OK != MPU6050_ReadRegs(config, reg, data, sizeof(data))){
+			return HAL_ERROR;
+		}
+		for(uint8_t axis = 0; axis < 3; axis++){
+			sum[axis] += MPU6050_BYTES_TO_INT16(data[2 * axis], data[2 * axis + 1]);
+		}
+	}
+
+	for(uint8_t axis = 0; axis < 3; axis++){
+		avg[axis] = (sum[axis] + (sum[axis] < 0 ? -(int32_t)numReadings / 2 : (int32_t)numReadings / 2)) / numReadings;
+	}
+
+	return HAL_OK;
+}
+
+// New offset register value cancelling error (output LSB), offsetLsbPerOutLsb = offset register LSB per output LSB
+static int16_t MPU6050_CalibCorrect(int16_t offset, int32_t error, float offsetLsbPerOutLsb, uint16_t keepMask) {
+	float correction = -(float)error * offsetLsbPerOutLsb;
+	int32_t value = offset + (int32_t)(correction < 0.0f ? correction - 0.5f : correction + 0.5f);
 
-    MPU6050_Accelerations accel;
-    MPU6050_AccelOffsets accelOff;
+	if(value > INT16_MAX){
+		value = INT16_MAX;
+	}
+	if(value < INT16_MIN){
+		value = INT16_MIN;
+	}
 
-    int32_t avgAccelX = 0;
-    int32_t avgAccelY = 0;
-    int32_t avgAccelZ = 0;
+	return (int16_t)(((uint16_t)value & ~keepMask) | ((uint16_t)offset & keepMask));
+}
 
-    if(calibTolerance <= 0 || calibTolerance > 1){
-    	return ERR_CALIB_INVALID_TOLERANCE;
-    }
+static uint8_t MPU6050_CalibAccelUntimed(MPU6050_ConfigTypeDef *config, float calibTolerance, uint8_t gravityAxis) {
+	MPU6050_AccelOffsets accelOff;
+	int32_t avgAccel[3];
+	int32_t target[3] = {0, 0, 0};
 
-    MPU6050_GetAccelOffset(config, &accelOff);
+	if(calibTolerance <= 0 || calibTolerance > 1){
+		return ERR_CALIB_INVALID_TOLERANCE;
+	}
 
-    uint16_t lsbSen = MPU6050_GetAccelSensitivity(config);
+	if(gravityAxis > GRAVITY_AXIS_Z_NEG){
+		return ERR_CALIB_INVALID_AXIS;
+	}
 
-    uint16_t maxStableError = (uint16_t)(calibTolerance * lsbSen);	// 1g m/s^2
+	if(MPU6050_GetAccelOffset(config, &accelOff) != CONN_OK){
+		return ERR_CALIB_CONN;
+	}
 
-    while (iterationsCount < ACCEL_MAX_CALIB_ITERATIONS) {
-        readingsCount = 0;
-        avgAccelX = 0;
-        avgAccelY = 0;
-        avgAccelZ = 0;
+	uint16_t lsbSen = MPU6050_GetAccelSensitivity(config);
 
-        while (readingsCount < ACCEL_NUM_CALIB_READINGS) {
-            MPU6050_GetAcceleration(config, &accel);
+	uint16_t maxStableError = (uint16_t)(calibTolerance * lsbSen);	// 1g m/s^2
 
-            avgAccelX += accel.rawAccelX;
-            avgAccelY += accel.rawAccelY;
-            avgAccelZ += accel.rawAccelZ;
+	// GRAVITY_AXIS_X_POS, X_NEG, Y_POS, Y_NEG, Z_POS, Z_NEG
+	target[gravityAxis / 2] = (gravityAxis & 1) ? -(int32_t)lsbSen : (int32_t)lsbSen;
 
-            readingsCount++;
-        }
+	int16_t *offsets[3] = {&accelOff.xOffset, &accelOff.yOffset, &accelOff.zOffset};
+	float offsetLsbPerOutLsb = (float)ACCEL_OFFSET_LSB_SEN / lsbSen;
 
-        avgAccelX /= ACCEL_NUM_CALIB_READINGS;
-        avgAccelY /= ACCEL_NUM_CALIB_READINGS;
-        avgAccelZ /= ACCEL_NUM_CALIB_READINGS;
+	// The first iteration corrects the whole bias, the next ones only the residual
+	for(uint32_t iterationsCount = 0; iterationsCount < ACCEL_MAX_CALIB_ITERATIONS; iterationsCount++){
+		if(MPU6050_CalibAverage(config, REG_ACCEL_XOUT_H, ACCEL_NUM_CALIB_READINGS, avgAccel) != HAL_OK){
+			return ERR_CALIB_CONN;
+		}
 
-        if (ABS(avgAccelX) <= maxStableError && ABS(avgAccelY) <= maxStableError && ABS(avgAccelZ - lsbSen) <= maxStableError) {
-            MPU6050_SetAccelOffset(config, &accelOff);
-            return CALIB_OK;
-        } else {
-            if (avgAccelX > 0) {
-                accelOff.xOffset--;
-            } else {
-                accelOff.xOffset++;
-            }
+		uint8_t stable = TRUE;
+		for(uint8_t axis = 0; axis < 3; axis++){
+			int32_t error = avgAccel[axis] - target[axis];
 
-            if (avgAccelY > 0) {
-                accelOff.yOffset--;
-            } else {
-                accelOff.yOffset++;
-            }
+			if(ABS(error) > maxStableError){
+				stable = FALSE;
+			}
+			// Bit 0 of the accelerometer offsets is reserved (temperature compensation)
+			*offsets[axis] = MPU6050_CalibCorrect(*offsets[axis], error, offsetLsbPerOutLsb, 0x0001);
+		}
 
-            if ((avgAccelZ - lsbSen) > 0) {
-                accelOff.zOffset--;
-            } else {
-                accelOff.zOffset++;
-            }
+		if(stable){
+			return CALIB_OK;
+		}
 
-            MPU6050_SetAccelOffset(config, &accelOff);
-        }
+		// Not read back, the next measurement shows the effect of the new offsets
+		if(MPU6050_WriteOffsets(config, REG_XA_OFFS_USRH, accelOff.xOffset, accelOff.yOffset, accelOff.zOffset, FALSE) != WRITE_OK){
+			return ERR_CALIB_CONN;
+		}
+	}
 
-        iterationsCount++;
-    }
+	return CALIB_TIMEOUT;
+}
 
-    return CALIB_TIMEOUT;
+uint8_t MPU6050_CalibAccel(MPU6050_ConfigTypeDef *config, float calibTolerance, uint8_t gravityAxis) {
+	MPU6050_STATS_RETURN(config, STATS_CALIB_ACCEL, MPU6050_CalibAccelUntimed(config, calibTolerance, gravityAxis));
 }
 
-uint8_t MPU6050_CalibGyro(MPU6050_ConfigTypeDef *config, float calibTolerance) {
-    uint32_t readingsCount = 0;
-    uint32_t iterationsCount = 0;
+static uint8_t MPU6050_CalibGyroUntimed(MPU6050_ConfigTypeDef *config, float calibTolerance) {
+	MPU6050_GyroOffsets gyroOff;
+	int32_t avgRota[3];
 
-    MPU6050_Rotations rota;
-    MPU6050_GyroOffsets gyroOff;
+	if(calibTolerance <= 0 || calibTolerance > 1){
+		return ERR_CALIB_INVALID_TOLERANCE;
+	}
 
-    int32_t avgRotaX = 0;
-    int32_t avgRotaY = 0;
-    int32_t avgRotaZ = 0;
+	if(MPU6050_GetGyroOffset(config, &gyroOff) != CONN_OK){
+		return ERR_CALIB_CONN;
+	}
 
-    if(calibTolerance <= 0 || calibTolerance > 1){
-    	return ERR_CALIB_INVALID_TOLERANCE;
-    }
+	float lsbSen = MPU6050_GetGyroSensitivty(config);
 
-    MPU6050_GetGyroOffset(config, &gyroOff);
+	uint16_t maxStableError = (uint16_t)(calibTolerance * lsbSen * 125);	// 125º/s
 
-    uint16_t lsbSen = MPU6050_GetGyroOffset(config, &gyroOff);
+	int16_t *offsets[3] = {&gyroOff.xOffset, &gyroOff.yOffset, &gyroOff.zOffset};
+	float offsetLsbPerOutLsb = GYRO_OFFSET_LSB_SEN / lsbSen;
 
-    uint16_t maxStableError = (uint16_t)(calibTolerance * lsbSen * 125);	// 125º/s
+	for(uint32_t iterationsCount = 0; iterationsCount < GYRO_MAX_CALIB_ITERATIONS; iterationsCount++){
+		if(MPU6050_CalibAverage(config, REG_GYRO_XOUT_H, GYRO_NUM_CALIB_READINGS, avgRota) != HAL_OK){
+			return ERR_CALIB_CONN;
+		}
 
-    while (iterationsCount < GYRO_MAX_CALIB_ITERATIONS) {
-        readingsCount = 0;
-        avgRotaX = 0;
-        avgRotaY = 0;
-        avgRotaZ = 0;
+		uint8_t stable = TRUE;
+		for(uint8_t axis = 0; axis < 3; axis++){
+			if(ABS(avgRota[axis]) > maxStableError){
+				stable = FALSE;
+			}
+			*offsets[axis] = MPU6050_CalibCorrect(*offsets[axis], avgRota[axis], offsetLsbPerOutLsb, 0x0000);
+		}
 
-        while (readingsCount < GYRO_NUM_CALIB_READINGS) {
-            MPU6050_GetRotation(config, &rota);
+		if(stable){
+			return CALIB_OK;
+		}
 
-            avgRotaX += rota.rawRotaX;
-            avgRotaY += rota.rawRotaY;
-            avgRotaZ += rota.rawRotaZ;
+		if(MPU6050_WriteOffsets(config, REG_XG_OFFS_USRH, gyroOff.xOffset, gyroOff.yOffset, gyroOff.zOffset, FALSE) != WRITE_OK){
+			return ERR_CALIB_CONN;
+		}
+	}
 
-            readingsCount++;
-        }
+	return CALIB_TIMEOUT;
+}
 
-        avgRotaX /= GYRO_NUM_CALIB_READINGS;
-        avgRotaY /= GYRO_NUM_CALIB_READINGS;
-        avgRotaZ /= GYRO_NUM_CALIB_READINGS;
+uint8_t MPU6050_CalibGyro(MPU6050_ConfigTypeDef *config, float calibTolerance) {
+	MPU6050_STATS_RETURN(config, STATS_CALIB_GYRO, MPU6050_CalibGyroUntimed(config, calibTolerance));
+}
 
-        if (ABS(avgRotaX) <= maxStableError && ABS(avgRotaY) <= maxStableError && ABS(avgRotaZ) <= maxStableError) {
-            MPU6050_SetGyroOffset(config, &gyroOff);
-            return CALIB_OK;
-        } else {
-            if (avgRotaX > 0) {
-                gyroOff.xOffset--;
-            } else {
-                gyroOff.xOffset++;
-            }
+#if MPU6050_STATS
 
-            if (avgRotaY > 0) {
-                gyroOff.yOffset--;
-            } else {
-                gyroOff.yOffset++;
-            }
+// Attaches stats to the device (NULL stops the collection) and clears it
+void MPU6050_StatsInit(MPU6050_ConfigTypeDef *config, MPU6050_Stats *stats) {
+#ifdef MPU6050_STATS_DWT
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
 
-            if (avgRotaZ > 0) {
-                gyroOff.zOffset--;
-            } else {
-                gyroOff.zOffset++;
-            }
+	config->stats = stats;
+	MPU6050_StatsReset(config);
+}
 
-            MPU6050_SetGyroOffset(config, &gyroOff);
-        }
+void MPU6050_StatsReset(MPU6050_ConfigTypeDef *config) {
+	if(config->stats != NULL){
+		*config->stats = (MPU6050_Stats){0};
+	}
+}
 
-        iterationsCount++;
-    }
+// Plain copy: counters updated by MPU6050_AsyncComplete in the middle of it may be off by one
+uint8_t MPU6050_StatsSnapshot(MPU6050_ConfigTypeDef *config, MPU6050_Stats *snapshot, uint8_t reset) {
+	if(NULL == config->stats){
+		return ERR_STATS_DISABLED;
+	}
 
-    return CALIB_TIMEOUT;
-}
+	*snapshot = *config->stats;
+	snapshot->ticksHz = MPU6050_STATS_TICKS_HZ;
 
+	if(reset){
+		MPU6050_StatsReset(config);
+	}
 
+	return STATS_OK;
+}
 
+// Upper bound in ticks of the given percentile of the calls (0 when there are none)
+uint32_t MPU6050_StatsPercentile(const MPU6050_ApiStats *apiStats, uint8_t percent) {
+	uint64_t target = ((uint64_t)apiStats->calls * percent + 99) / 100;
+	uint64_t count = 0;
 
+	if(0 == apiStats->calls){
+		return 0;
+	}
+	if(0 == target){
+		return apiStats->minTicks;
+	}
 
+	for(uint8_t bucket = 0; bucket < MPU6050_STATS_BUCKETS - 1; bucket++){
+		count += apiStats->histogram[bucket];
+		if(count >= target){
+			uint32_t bound = (bucket < 32) ? (uint32_t)((1ull << bucket) - 1) : UINT32_MAX;
+			return (bound < apiStats->maxTicks) ? bound : apiStats->maxTicks;
+		}
+	}
 
+	return apiStats->maxTicks;
+}
 
+#endif
@@ -0,0 +1,139 @@
+#define _GNU_SOURCE
+#include "MPU6050_LIB.h"
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+static HAL_StatusTypeDef MPU6050_Linux_Status(int result) {
+	if(result >= 0){
+		return HAL_OK;
+	}
+
+	switch(errno){
+		case ETIMEDOUT:
+			return HAL_TIMEOUT;
+		case EBUSY:
+		case EAGAIN:
+			return HAL_BUSY;
+		default:
+			return HAL_ERROR;
+	}
+}
+
+static HAL_StatusTypeDef MPU6050_Linux_Transfer(I2C_HandleTypeDef *hi2c, struct i2c_msg *msgs, uint32_t numMsgs) {
+	struct i2c_rdwr_ioctl_data transfer = {
+		.msgs = msgs,
+		.nmsgs = numMsgs
+	};
+
+	if(hi2c->ioctlFn != NULL){
+		return MPU6050_Linux_Status(hi2c->ioctlFn(hi2c->fd, I2C_RDWR, &transfer));
+	}
+	return MPU6050_Linux_Status(ioctl(hi2c->fd, I2C_RDWR, &transfer));
+}
+
+static HAL_StatusTypeDef MPU6050_Linux_Read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	// Register write followed by a repeated start read, as HAL_I2C_Mem_Read does
+	struct i2c_msg msgs[2] = {
+		{.addr = address, .flags = 0, .len = 1, .buf = &reg},
+		{.addr = address, .flags = I2C_M_RD, .len = len, .buf = data}
+	};
+
+	return MPU6050_Linux_Transfer(hi2c, msgs, 2);
+}
+
+static HAL_StatusTypeDef MPU6050_Linux_Write(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	uint8_t buffer[1 + MPU6050_LINUX_MAX_WRITE];
+
+	if(len > MPU6050_LINUX_MAX_WRITE){
+		return HAL_ERROR;
+	}
+
+	buffer[0] = reg;
+	memcpy(&buffer[1], data, len);
+
+	struct i2c_msg msg = {.addr = address, .flags = 0, .len = (uint16_t)(len + 1), .buf = buffer};
+
+	return MPU6050_Linux_Transfer(hi2c, &msg, 1);
+}
+
+// Every block costs two messages, as many blocks as the kernel accepts go in one ioctl
+static HAL_StatusTypeDef MPU6050_Linux_ReadBlocks(I2C_HandleTypeDef *hi2c, uint8_t address, MPU6050_RegBlock *blocks, uint8_t numBlocks) {
+	struct i2c_msg msgs[MPU6050_LINUX_MAX_MSGS];
+	uint8_t done = 0;
+
+	while(done < numBlocks){
+		uint32_t numMsgs = 0;
+
+		while(done < numBlocks && numMsgs + 2 <= MPU6050_LINUX_MAX_MSGS){
+			msgs[numMsgs++] = (struct i2c_msg){.addr = address, .flags = 0, .len = 1, .buf = &blocks[done].reg};
+			msgs[numMsgs++] = (struct i2c_msg){.addr = address, .flags = I2C_M_RD, .len = blocks[done].len, .buf = blocks[done].data};
+			done++;
+		}
+
+		HAL_StatusTypeDef status = MPU6050_Linux_Transfer(hi2c, msgs, numMsgs);
+		if(HAL_OK != status){
+			return status;
+		}
+	}
+
+	return HAL_OK;
+}
+
+const MPU6050_Transport MPU6050_DefaultTransport = {
+	.read = MPU6050_Linux_Read,
+	.write = MPU6050_Linux_Write,
+	.readBlocks = MPU6050_Linux_ReadBlocks,
+	.startRead = NULL
+};
+
+int MPU6050_LinuxOpen(I2C_HandleTypeDef *hi2c, const char *device) {
+	hi2c->fd = open(device, O_RDWR | O_CLOEXEC);
+	hi2c->ioctlFn = NULL;
+
+	return (hi2c->fd >= 0) ? 0 : -errno;
+}
+
+void MPU6050_LinuxClose(I2C_HandleTypeDef *hi2c) {
+	if(hi2c->fd >= 0){
+		close(hi2c->fd);
+		hi2c->fd = -1;
+	}
+}
+
+// CLOCK_MONOTONIC in nanoseconds, wraps every 4.29 s (tick source of MPU6050_STATS)
+uint32_t MPU6050_LinuxGetNs(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+}
+
+uint32_t HAL_GetTick(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint32_t)(now.tv_sec * 1000u + now.tv_nsec / 1000000);
+}
+
+void HAL_Delay(uint32_t delay) {
+	struct timespec duration = {
+		.tv_sec = delay / 1000,
+		.tv_nsec = (long)(delay % 1000) * 1000000
+	};
+
+	while(nanosleep(&duration, &duration) != 0 && EINTR == errno){
+	}
+}
+
+#endif
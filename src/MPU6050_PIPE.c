@@ -0,0 +1,425 @@
+#define _GNU_SOURCE
+#include "MPU6050_PIPE.h"
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MPU6050_PIPE_WARMUP_BYTES	4096	// First look-back window for the moving average
+
+// State shared by the workers of a run
+typedef struct {
+	const uint8_t *data;
+	size_t size;
+	size_t start;						// First block byte (after the file header)
+	const MPU6050_PipeConfig *pipeConfig;
+	MPU6050_ConfigTypeDef config;		// From the file header
+	uint32_t chunkBytes;
+	uint32_t numChunks;
+
+	pthread_mutex_t lock;
+	pthread_cond_t turn;
+	uint32_t nextChunk;					// Next chunk to decode
+	uint32_t nextOrdered;				// Next chunk for the ordered callback
+	uint64_t orderedFrames;
+	uint64_t frames;
+	uint32_t corruptBlocks;
+	double cpuSeconds;
+	uint8_t error;
+} MPU6050_PipeShared;
+
+typedef struct {
+	MPU6050_PipeShared *shared;
+	MPU6050_ConfigTypeDef config;		// Private copy, the conversion refreshes its scale cache
+	MPU6050_CaptureReader reader;
+	MPU6050_PipeChunk chunk;
+	uint32_t capacity;
+	uint32_t corruptBlocks;
+	uint8_t aligned;					// The reader is at the end of a block
+
+	// Moving average: last averageLen frames after the bias removal
+	int16_t history[MPU6050_PIPE_MAX_AVERAGE][MPU6050_CAPTURE_CHANNELS];
+	int32_t sum[MPU6050_CAPTURE_CHANNELS];
+	uint8_t historyLen;
+	uint8_t historyPos;
+} MPU6050_PipeWorker;
+
+static double MPU6050_PipeSeconds(clockid_t clock) {
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int16_t MPU6050_PipeSubSat(int16_t value, int16_t bias) {
+	int32_t result = (int32_t)value - bias;
+
+	if(result > INT16_MAX){
+		return INT16_MAX;
+	}
+	if(result < INT16_MIN){
+		return INT16_MIN;
+	}
+	return (int16_t)result;
+}
+
+// Opens the first valid block at or after offset, FALSE if there is none before end
+static uint8_t MPU6050_PipeOpenBlock(MPU6050_PipeWorker *worker, size_t offset, size_t end) {
+	MPU6050_CaptureReader *reader = &worker->reader;
+	uint8_t found = (CAPTURE_OK == MPU6050_CaptureSeek(reader, offset));
+	size_t blockStart = found ? reader->pos - MPU6050_CAPTURE_BLOCK_HEADER_LEN : reader->size;
+
+	// Only the end of a block must be followed by another one
+	if(worker->aligned && blockStart > offset){
+		worker->corruptBlocks++;
+	}
+	worker->aligned = TRUE;
+
+	return found && blockStart < end;
+}
+
+// Decodes the frames of the blocks starting in [begin, end), FALSE at the end
+static uint8_t MPU6050_PipeReadFrame(MPU6050_PipeWorker *worker, MPU6050_CaptureFrame *frame, size_t end) {
+	MPU6050_CaptureReader *reader = &worker->reader;
+
+	while(1){
+		if(0 == reader->framesLeft){
+			if(!MPU6050_PipeOpenBlock(worker, reader->blockEnd, end)){
+				return FALSE;
+			}
+			continue;
+		}
+
+		// A malformed frame makes the reader open the next block by itself: reopen it here
+		// so that the chunk limit is still checked
+		size_t blockEnd = reader->blockEnd;
+		if(CAPTURE_OK != MPU6050_CaptureReadFrame(reader, frame)){
+			return FALSE;
+		}
+		if(reader->blockEnd == blockEnd){
+			return TRUE;
+		}
+
+		worker->corruptBlocks++;
+		if(!MPU6050_PipeOpenBlock(worker, blockEnd, end)){
+			return FALSE;
+		}
+	}
+}
+
+// Removes the bias and applies the moving average in place
+static void MPU6050_PipeFilter(MPU6050_PipeWorker *worker, int16_t raw[MPU6050_CAPTURE_CHANNELS]) {
+	const MPU6050_PipeConfig *pipeConfig = worker->shared->pipeConfig;
+	uint8_t averageLen = pipeConfig->averageLen;
+
+	for(uint8_t i = 0; i < 3; i++){
+		raw[i] = MPU6050_PipeSubSat(raw[i], pipeConfig->accelBias[i]);
+		raw[4 + i] = MPU6050_PipeSubSat(raw[4 + i], pipeConfig->gyroBias[i]);
+	}
+
+	if(averageLen < 2){
+		return;
+	}
+
+	int16_t *slot = worker->history[worker->historyPos];
+	for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+		if(worker->historyLen == averageLen){
+			worker->sum[i] -= slot[i];
+		}
+		slot[i] = raw[i];
+		worker->sum[i] += raw[i];
+	}
+	if(worker->historyLen < averageLen){
+		worker->historyLen++;
+	}
+	worker->historyPos = (worker->historyPos + 1) % averageLen;
+
+	// Rounded to the nearest, halves away from zero
+	for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+		int32_t half = worker->historyLen / 2;
+		int32_t sum = worker->sum[i];
+		raw[i] = (int16_t)((sum >= 0) ? (sum + half) / worker->historyLen : (sum - half) / worker->historyLen);
+	}
+}
+
+// Loads the moving average with the frames before the chunk, as a sequential run would have it
+static void MPU6050_PipeWarmUp(MPU6050_PipeWorker *worker, size_t begin) {
+	MPU6050_PipeShared *shared = worker->shared;
+	MPU6050_CaptureFrame frame;
+	uint8_t need = shared->pipeConfig->averageLen - 1;
+	size_t window = MPU6050_PIPE_WARMUP_BYTES;
+
+	while(1){
+		size_t from = (begin - shared->start > window) ? begin - window : shared->start;
+		uint32_t corruptBlocks = worker->corruptBlocks;
+
+		worker->historyLen = 0;
+		worker->historyPos = 0;
+		memset(worker->sum, 0, sizeof(worker->sum));
+
+		worker->reader.framesLeft = 0;
+		worker->reader.blockEnd = from;
+		worker->aligned = FALSE;
+		while(MPU6050_PipeReadFrame(worker, &frame, begin)){
+			MPU6050_PipeFilter(worker, frame.raw);
+		}
+		// Counted by the worker of the previous chunk
+		worker->corruptBlocks = corruptBlocks;
+
+		if(worker->historyLen >= need || from == shared->start){
+			return;
+		}
+		window *= 2;
+	}
+}
+
+static uint8_t MPU6050_PipeReserve(MPU6050_PipeWorker *worker) {
+	MPU6050_PipeChunk *chunk = &worker->chunk;
+
+	if(chunk->count < worker->capacity){
+		return PIPE_OK;
+	}
+
+	uint32_t capacity = (worker->capacity > 0) ? 2 * worker->capacity : 4096;
+	MPU6050_Accelerations *accel = realloc(chunk->accel, capacity * sizeof(*accel));
+	if(accel != NULL){
+		chunk->accel = accel;
+	}
+	MPU6050_Rotations *rota = realloc(chunk->rota, capacity * sizeof(*rota));
+	if(rota != NULL){
+		chunk->rota = rota;
+	}
+	MPU6050_Temperature *temp = realloc(chunk->temp, capacity * sizeof(*temp));
+	if(temp != NULL){
+		chunk->temp = temp;
+	}
+	if(accel == NULL || rota == NULL || temp == NULL){
+		return ERR_PIPE_MEMORY;
+	}
+
+	worker->capacity = capacity;
+	return PIPE_OK;
+}
+
+static uint8_t MPU6050_PipeDecodeChunk(MPU6050_PipeWorker *worker, uint32_t index) {
+	MPU6050_PipeShared *shared = worker->shared;
+	MPU6050_PipeChunk *chunk = &worker->chunk;
+	MPU6050_CaptureFrame frame;
+	size_t begin = shared->start + (size_t)index * shared->chunkBytes;
+	size_t end = (index + 1 == shared->numChunks) ? shared->size : begin + shared->chunkBytes;
+
+	chunk->index = index;
+	chunk->firstFrame = 0;
+	chunk->count = 0;
+
+	worker->historyLen = 0;
+	worker->historyPos = 0;
+	memset(worker->sum, 0, sizeof(worker->sum));
+	if(shared->pipeConfig->averageLen > 1 && begin > shared->start){
+		MPU6050_PipeWarmUp(worker, begin);
+	}
+
+	worker->reader.framesLeft = 0;
+	worker->reader.blockEnd = begin;
+	worker->aligned = FALSE;
+	while(MPU6050_PipeReadFrame(worker, &frame, end)){
+		if(PIPE_OK != MPU6050_PipeReserve(worker)){
+			return ERR_PIPE_MEMORY;
+		}
+
+		MPU6050_PipeFilter(worker, frame.raw);
+
+		MPU6050_Accelerations *accel = &chunk->accel[chunk->count];
+		MPU6050_Rotations *rota = &chunk->rota[chunk->count];
+		MPU6050_Temperature *temp = &chunk->temp[chunk->count];
+		accel->timestampUs = rota->timestampUs = temp->timestampUs = frame.timestampUs;
+		accel->rawAccelX = frame.raw[0];
+		accel->rawAccelY = frame.raw[1];
+		accel->rawAccelZ = frame.raw[2];
+		temp->rawTemp = frame.raw[3];
+		rota->rawRotaX = frame.raw[4];
+		rota->rawRotaY = frame.raw[5];
+		rota->rawRotaZ = frame.raw[6];
+		MPU6050_ConvertSample(&worker->config, accel, rota, temp);
+
+		chunk->count++;
+	}
+
+	return PIPE_OK;
+}
+
+static void MPU6050_PipeFail(MPU6050_PipeShared *shared, uint8_t error) {
+	pthread_mutex_lock(&shared->lock);
+	if(PIPE_OK == shared->error){
+		shared->error = error;
+	}
+	pthread_cond_broadcast(&shared->turn);
+	pthread_mutex_unlock(&shared->lock);
+}
+
+static void *MPU6050_PipeWorkerRun(void *arg) {
+	MPU6050_PipeWorker *worker = arg;
+	MPU6050_PipeShared *shared = worker->shared;
+	const MPU6050_PipeConfig *pipeConfig = shared->pipeConfig;
+	MPU6050_PipeChunk *chunk = &worker->chunk;
+	double cpuStart = MPU6050_PipeSeconds(CLOCK_THREAD_CPUTIME_ID);
+
+	while(1){
+		pthread_mutex_lock(&shared->lock);
+		if(shared->error != PIPE_OK || shared->nextChunk >= shared->numChunks){
+			pthread_mutex_unlock(&shared->lock);
+			break;
+		}
+		uint32_t index = shared->nextChunk++;
+		pthread_mutex_unlock(&shared->lock);
+
+		uint8_t error = MPU6050_PipeDecodeChunk(worker, index);
+		if(error != PIPE_OK){
+			MPU6050_PipeFail(shared, error);
+			break;
+		}
+
+		if(pipeConfig->process != NULL){
+			pipeConfig->process(pipeConfig->context, chunk);
+		}
+
+		pthread_mutex_lock(&shared->lock);
+		if(pipeConfig->ordered != NULL){
+			// Chunks are taken in order, so the one awaited is always being decoded
+			while(shared->nextOrdered != index && PIPE_OK == shared->error){
+				pthread_cond_wait(&shared->turn, &shared->lock);
+			}
+			if(shared->error != PIPE_OK){
+				pthread_mutex_unlock(&shared->lock);
+				break;
+			}
+			chunk->firstFrame = shared->orderedFrames;
+			pthread_mutex_unlock(&shared->lock);
+
+			pipeConfig->ordered(pipeConfig->context, chunk);
+
+			pthread_mutex_lock(&shared->lock);
+			shared->orderedFrames += chunk->count;
+			shared->nextOrdered++;
+			pthread_cond_broadcast(&shared->turn);
+		}
+		shared->frames += chunk->count;
+		pthread_mutex_unlock(&shared->lock);
+	}
+
+	pthread_mutex_lock(&shared->lock);
+	shared->corruptBlocks += worker->corruptBlocks;
+	shared->cpuSeconds += MPU6050_PipeSeconds(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+	pthread_mutex_unlock(&shared->lock);
+
+	return NULL;
+}
+
+uint8_t MPU6050_PipeRun(const uint8_t *data, size_t size, const MPU6050_PipeConfig *pipeConfig, MPU6050_PipeStats *stats) {
+	MPU6050_PipeShared shared;
+	MPU6050_CaptureReader reader;
+	pthread_t threads[MPU6050_PIPE_MAX_THREADS];
+
+	if(pipeConfig->averageLen > MPU6050_PIPE_MAX_AVERAGE){
+		return ERR_PIPE_CONFIG;
+	}
+	if(CAPTURE_OK != MPU6050_CaptureReaderInit(&reader, data, size)){
+		return ERR_PIPE_FORMAT;
+	}
+
+	memset(&shared, 0, sizeof(shared));
+	shared.data = data;
+	shared.size = size;
+	shared.start = reader.pos;
+	shared.pipeConfig = pipeConfig;
+	MPU6050_CaptureApplyHeader(&reader.header, &shared.config);
+	shared.chunkBytes = (pipeConfig->chunkBytes > 0) ? pipeConfig->chunkBytes : MPU6050_PIPE_CHUNK_BYTES;
+	shared.numChunks = (uint32_t)((size - shared.start + shared.chunkBytes - 1) / shared.chunkBytes);
+	if(0 == shared.numChunks){
+		shared.numChunks = 1;
+	}
+
+	long numThreads = pipeConfig->threads;
+	if(0 == numThreads){
+		numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(numThreads < 1){
+		numThreads = 1;
+	}
+	if(numThreads > MPU6050_PIPE_MAX_THREADS){
+		numThreads = MPU6050_PIPE_MAX_THREADS;
+	}
+	if(numThreads > (long)shared.numChunks){
+		numThreads = shared.numChunks;
+	}
+
+	MPU6050_PipeWorker *workers = calloc((size_t)numThreads, sizeof(*workers));
+	if(NULL == workers){
+		return ERR_PIPE_MEMORY;
+	}
+	pthread_mutex_init(&shared.lock, NULL);
+	pthread_cond_init(&shared.turn, NULL);
+
+	double wallStart = MPU6050_PipeSeconds(CLOCK_MONOTONIC);
+
+	// The calling thread is worker 0
+	long started = 1;
+	for(long i = 0; i < numThreads; i++){
+		workers[i].shared = &shared;
+		workers[i].config = shared.config;
+		workers[i].reader = reader;
+		if(i > 0){
+			if(pthread_create(&threads[i], NULL, MPU6050_PipeWorkerRun, &workers[i]) != 0){
+				MPU6050_PipeFail(&shared, ERR_PIPE_THREAD);
+				break;
+			}
+			started++;
+		}
+	}
+	MPU6050_PipeWorkerRun(&workers[0]);
+	for(long i = 1; i < started; i++){
+		pthread_join(threads[i], NULL);
+	}
+
+	double wallSeconds = MPU6050_PipeSeconds(CLOCK_MONOTONIC) - wallStart;
+
+	for(long i = 0; i < numThreads; i++){
+		free(workers[i].chunk.accel);
+		free(workers[i].chunk.rota);
+		free(workers[i].chunk.temp);
+	}
+	free(workers);
+	pthread_cond_destroy(&shared.turn);
+	pthread_mutex_destroy(&shared.lock);
+
+	if(stats != NULL){
+		stats->frames = shared.frames;
+		stats->chunks = shared.numChunks;
+		stats->corruptBlocks = shared.corruptBlocks;
+		stats->threads = (uint8_t)started;
+		stats->seconds = wallSeconds;
+		stats->cpuSeconds = shared.cpuSeconds;
+		stats->samplesPerSec = (wallSeconds > 0.0) ? (double)shared.frames / wallSeconds : 0.0;
+	}
+
+	return shared.error;
+}
+
+uint8_t MPU6050_PipeRunFile(const char *path, const MPU6050_PipeConfig *pipeConfig, MPU6050_PipeStats *stats) {
+	size_t size;
+	const uint8_t *data = MPU6050_CaptureMapFile(path, &size);
+
+	if(NULL == data){
+		return ERR_PIPE_FILE;
+	}
+
+	uint8_t error = MPU6050_PipeRun(data, size, pipeConfig, stats);
+	MPU6050_CaptureUnmapFile(data, size);
+
+	return error;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "MPU6050_SCHED.h"
+
+static uint32_t MPU6050_SchedNow(MPU6050_Scheduler *sched) {
+	if(sched->clock != NULL){
+		return sched->clock();
+	}
+	return HAL_GetTick() * 1000;
+}
+
+static uint8_t MPU6050_SchedBusBusy(MPU6050_Scheduler *sched, I2C_HandleTypeDef *hi2c) {
+	for(uint8_t i = 0; i < sched->numDevices; i++){
+		MPU6050_SchedDevice *dev = &sched->devices[i];
+		if(dev->reader.config->hi2c == hi2c && dev->reader.busy){
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// Readers without a non-blocking start (Linux, simulator) complete inside MPU6050_AsyncStart
+static uint8_t MPU6050_SchedIsBlocking(MPU6050_SchedDevice *dev) {
+	return NULL == dev->reader.startRead;
+}
+
+// Starts the next queued device on the bus, skipping devices that fail to start. Blocking
+// devices are read in this loop instead of chaining from their completion, so the stack
+// does not grow with the number of devices
+static void MPU6050_SchedStartNext(MPU6050_Scheduler *sched, I2C_HandleTypeDef *hi2c) {
+	for(uint8_t i = 0; i < sched->numDevices; i++){
+		MPU6050_SchedDevice *dev = &sched->devices[i];
+		if(dev->reader.config->hi2c != hi2c || !dev->queued){
+			continue;
+		}
+		dev->queued = FALSE;
+		if(ASYNC_OK == MPU6050_AsyncStart(&dev->reader) && !MPU6050_SchedIsBlocking(dev)){
+			return;
+		}
+	}
+}
+
+static void MPU6050_SchedOnComplete(MPU6050_AsyncReader *reader, uint8_t status, void *context) {
+	MPU6050_Scheduler *sched = (MPU6050_Scheduler *)context;
+	MPU6050_SchedDevice *dev = (MPU6050_SchedDevice *)reader;
+
+	if(ASYNC_OK == status){
+		uint32_t now = MPU6050_SchedNow(sched);
+		uint32_t previousPeriod = dev->period;
+
+		// Period needs two samples, jitter needs two periods unless the expected period is known
+		if(dev->samples > 0){
+			dev->period = now - dev->lastSampleTime;
+
+			uint32_t expected = (sched->periodUs != 0) ? sched->periodUs : previousPeriod;
+			if(sched->periodUs != 0 || dev->samples > 1){
+				dev->jitter = (dev->period > expected) ? (dev->period - expected) : (expected - dev->period);
+				if(dev->jitter > dev->maxJitter){
+					dev->maxJitter = dev->jitter;
+				}
+			}
+		}
+
+		dev->lastSampleTime = now;
+		dev->samples++;
+	}
+
+	// Keep the bus busy: the next device on the same handle goes back-to-back
+	if(!MPU6050_SchedIsBlocking(dev)){
+		MPU6050_SchedStartNext(sched, reader->config->hi2c);
+	}
+}
+
+void MPU6050_SchedInit(MPU6050_Scheduler *sched, MPU6050_ClockFn clock, uint32_t periodUs) {
+	sched->numDevices = 0;
+	sched->clock = clock;
+	sched->periodUs = periodUs;
+}
+
+uint8_t MPU6050_SchedAddDevice(MPU6050_Scheduler *sched, MPU6050_ConfigTypeDef *config, MPU6050_AsyncStartFn startRead, uint8_t *index) {
+	if(sched->numDevices >= MPU6050_SCHED_MAX_DEVICES){
+		return ERR_SCHED_FULL;
+	}
+
+	MPU6050_SchedDevice *dev = &sched->devices[sched->numDevices];
+
+	MPU6050_AsyncInit(&dev->reader, config, startRead, MPU6050_SchedOnComplete, sched);
+	dev->queued = FALSE;
+	dev->samples = 0;
+	dev->lastSampleTime = 0;
+	dev->period = 0;
+	dev->jitter = 0;
+	dev->maxJitter = 0;
+	dev->overruns = 0;
+
+	if(index != NULL){
+		*index = sched->numDevices;
+	}
+	sched->numDevices++;
+
+	return SCHED_OK;
+}
+
+void MPU6050_SchedTrigger(MPU6050_Scheduler *sched) {
+	for(uint8_t i = 0; i < sched->numDevices; i++){
+		MPU6050_SchedDevice *dev = &sched->devices[i];
+		if(dev->queued || dev->reader.busy){
+			dev->overruns++;
+			continue;
+		}
+		dev->queued = TRUE;
+	}
+
+	// Start the first queued device of every idle bus, the rest follow from the completions
+	for(uint8_t i = 0; i < sched->numDevices; i++){
+		I2C_HandleTypeDef *hi2c = sched->devices[i].reader.config->hi2c;
+		if(sched->devices[i].queued && !MPU6050_SchedBusBusy(sched, hi2c)){
+			MPU6050_SchedStartNext(sched, hi2c);
+		}
+	}
+}
+
+// Call from HAL_I2C_MemRxCpltCallback (transferOk = TRUE) or HAL_I2C_ErrorCallback (transferOk = FALSE)
+void MPU6050_SchedComplete(MPU6050_Scheduler *sched, I2C_HandleTypeDef *hi2c, uint8_t transferOk) {
+	for(uint8_t i = 0; i < sched->numDevices; i++){
+		MPU6050_SchedDevice *dev = &sched->devices[i];
+		if(dev->reader.config->hi2c == hi2c && dev->reader.busy){
+			MPU6050_AsyncComplete(&dev->reader, transferOk);
+			return;
+		}
+	}
+}
+
+uint8_t MPU6050_SchedGetSample(MPU6050_Scheduler *sched, uint8_t index, MPU6050_Accelerations *accel, MPU6050_Rotations *rota, MPU6050_Temperature *temp, uint32_t *ageUs) {
+	if(index >= sched->numDevices){
+		return ERR_SCHED_INVALID_DEVICE;
+	}
+
+	MPU6050_SchedDevice *dev = &sched->devices[index];
+
+	if(ASYNC_OK != MPU6050_AsyncGetSample(&dev->reader, accel, rota, temp)){
+		return ERR_SCHED_NO_DATA;
+	}
+
+	if(ageUs != NULL){
+		*ageUs = MPU6050_SchedNow(sched) - dev->lastSampleTime;
+	}
+
+	return SCHED_OK;
+}
@@ -0,0 +1,613 @@
+#include "MPU6050_SIM.h"
+
+#if MPU6050_TRANSPORT == MPU6050_TRANSPORT_LINUX
+
+#include <string.h>
+
+static const float simAccelSen[4] = {ACCEL_LSB_SEN_0, ACCEL_LSB_SEN_1, ACCEL_LSB_SEN_2, ACCEL_LSB_SEN_3};
+static const float simGyroSen[4] = {GYRO_LSB_SEN_0, GYRO_LSB_SEN_1, GYRO_LSB_SEN_2, GYRO_LSB_SEN_3};
+// Indexed by LP_WAKE_CTRL
+static const uint64_t simLpWakePeriodNs[4] = {800000000ull, 200000000ull, 50000000ull, 25000000ull};
+static const uint32_t simLpWakeCurrentUa[4] = {10, 20, 70, 140};
+// Cut-off of the motion detection high-pass filter, indexed by ACCEL_HPF (0 = reset, 7 = hold)
+static const float simHpfCutoffHz[5] = {0.0f, 5.0f, 2.5f, 1.25f, 0.63f};
+
+static int16_t MPU6050_SimClamp(float value) {
+	if(value > 32767.0f){
+		return 32767;
+	}
+	if(value < -32768.0f){
+		return -32768;
+	}
+	return (int16_t)(value < 0.0f ? value - 0.5f : value + 0.5f);
+}
+
+static int16_t MPU6050_SimReg16(MPU6050_Sim *sim, uint8_t regH) {
+	return MPU6050_BYTES_TO_INT16(sim->regs[regH], sim->regs[regH + 1]);
+}
+
+static void MPU6050_SimPutReg16(MPU6050_Sim *sim, uint8_t regH, int16_t value) {
+	sim->regs[regH] = (uint8_t)((uint16_t)value >> 8);
+	sim->regs[regH + 1] = (uint8_t)(value & LOW_BYTE_MASK);
+}
+
+static float MPU6050_SimNoise(MPU6050_Sim *sim) {
+	if(0 == sim->noiseLsb){
+		return 0.0f;
+	}
+	sim->noiseSeed = sim->noiseSeed * 1664525u + 1013904223u;
+	return ((float)(sim->noiseSeed >> 8) / 16777216.0f * 2.0f - 1.0f) * sim->noiseLsb;
+}
+
+static void MPU6050_SimFifoPush(MPU6050_Sim *sim, uint8_t value) {
+	if(MPU6050_FIFO_SIZE == sim->fifoCount){
+		// The oldest byte is overwritten
+		sim->fifoHead = (sim->fifoHead + 1) % MPU6050_FIFO_SIZE;
+		sim->fifoCount--;
+		sim->regs[REG_INT_STATUS] |= FIFO_OFLOW_INT_FLAG;
+	}
+	sim->fifo[(sim->fifoHead + sim->fifoCount) % MPU6050_FIFO_SIZE] = value;
+	sim->fifoCount++;
+}
+
+static uint8_t MPU6050_SimFifoPop(MPU6050_Sim *sim) {
+	if(0 == sim->fifoCount){
+		return 0xFF;
+	}
+	uint8_t value = sim->fifo[sim->fifoHead];
+	sim->fifoHead = (sim->fifoHead + 1) % MPU6050_FIFO_SIZE;
+	sim->fifoCount--;
+	return value;
+}
+
+static MPU6050_SimAux *MPU6050_SimFindAux(MPU6050_Sim *sim, uint8_t address) {
+	for(uint8_t i = 0; i < sim->numAux; i++){
+		if(sim->aux[i]->address == address){
+			return sim->aux[i];
+		}
+	}
+	return NULL;
+}
+
+// EXT_SENS_DATA bytes of a slave (0 when disabled or writing), returns its position
+static uint8_t MPU6050_SimExtSlot(MPU6050_Sim *sim, uint8_t slave, uint8_t *len) {
+	uint8_t pos = 0;
+
+	*len = 0;
+
+	for(uint8_t i = 0; i <= slave; i++){
+		uint8_t ctrl = sim->regs[REG_I2C_SLV0_CTRL + 3 * i];
+		uint8_t slaveLen = 0;
+		if((ctrl & I2C_SLV_EN_CONFIG_SET) && (sim->regs[REG_I2C_SLV0_ADDR + 3 * i] & I2C_SLV_RNW_CONFIG_SET)){
+			slaveLen = ctrl & GET_I2C_SLV_LEN_CONFIG;
+		}
+		if(i == slave){
+			*len = (pos + slaveLen <= MPU6050_EXT_SENS_DATA_LEN) ? slaveLen : 0;
+			break;
+		}
+		pos += slaveLen;
+	}
+
+	return pos;
+}
+
+// Auxiliary I2C master: slaves 0..3, then a pending single transfer of slave 4
+static void MPU6050_SimAuxRun(MPU6050_Sim *sim) {
+	if(!(sim->regs[REG_USER_CTRL] & I2C_MST_EN_CONFIG_SET)){
+		return;
+	}
+
+	uint8_t delayCtrl = sim->regs[REG_I2C_MST_DELAY_CTRL];
+	uint8_t delayedDue = 0 == sim->samples % (1 + (sim->regs[REG_I2C_SLV4_CTRL] & GET_I2C_MST_DLY_CONFIG));
+	uint8_t status = 0;
+
+	for(uint8_t slave = 0; slave < MPU6050_AUX_SLAVES; slave++){
+		uint8_t addr = sim->regs[REG_I2C_SLV0_ADDR + 3 * slave];
+		uint8_t reg = sim->regs[REG_I2C_SLV0_REG + 3 * slave];
+		uint8_t ctrl = sim->regs[REG_I2C_SLV0_CTRL + 3 * slave];
+		uint8_t len;
+		uint8_t pos = MPU6050_SimExtSlot(sim, slave, &len);
+
+		if(!(ctrl & I2C_SLV_EN_CONFIG_SET) || ((delayCtrl & (1 << slave)) && !delayedDue)){
+			continue;
+		}
+
+		MPU6050_SimAux *aux = MPU6050_SimFindAux(sim, addr & 0x7F);
+		if(NULL == aux){
+			status |= (uint8_t)(I2C_SLV0_NACK_FLAG << slave);
+			continue;
+		}
+
+		if(addr & I2C_SLV_RNW_CONFIG_SET){
+			for(uint8_t i = 0; i < len; i++){
+				// Words start at even registers, odd ones with GRP. An unpaired byte is not swapped
+				uint8_t src = i;
+				if(ctrl & I2C_SLV_BYTE_SW_CONFIG_SET){
+					uint8_t wordStart = ((uint8_t)(reg + i) & 1) == ((ctrl & I2C_SLV_GRP_CONFIG_SET) ? 1 : 0);
+					if(wordStart && i + 1 < len){
+						src = i + 1;
+					}
+					else if(!wordStart && i > 0){
+						src = i - 1;
+					}
+				}
+				sim->regs[REG_EXT_SENS_DATA_00 + pos + i] = aux->regs[(uint8_t)(reg + src)];
+			}
+			aux->reads++;
+		}
+		else{
+			aux->regs[reg] = sim->regs[REG_I2C_SLV0_DO + slave];
+			aux->writes++;
+		}
+	}
+
+	uint8_t ctrl4 = sim->regs[REG_I2C_SLV4_CTRL];
+	if((ctrl4 & I2C_SLV_EN_CONFIG_SET) && (!(delayCtrl & I2C_SLV4_DLY_EN_CONFIG_SET) || delayedDue)){
+		uint8_t addr = sim->regs[REG_I2C_SLV4_ADDR];
+		uint8_t reg = sim->regs[REG_I2C_SLV4_REG];
+		MPU6050_SimAux *aux = MPU6050_SimFindAux(sim, addr & 0x7F);
+
+		if(NULL == aux){
+			status |= I2C_SLV4_NACK_FLAG;
+		}
+		else if(addr & I2C_SLV_RNW_CONFIG_SET){
+			sim->regs[REG_I2C_SLV4_DI] = aux->regs[reg];
+			aux->reads++;
+		}
+		else{
+			aux->regs[reg] = sim->regs[REG_I2C_SLV4_DO];
+			aux->writes++;
+		}
+
+		sim->regs[REG_I2C_SLV4_CTRL] = ctrl4 & (uint8_t)~I2C_SLV_EN_CONFIG_SET;
+		status |= I2C_SLV4_DONE_FLAG;
+		if(ctrl4 & I2C_SLV4_INT_EN_CONFIG_SET){
+			sim->regs[REG_INT_STATUS] |= I2C_MST_INT_FLAG;
+		}
+	}
+
+	sim->regs[REG_I2C_MST_STATUS] |= status;
+}
+
+static uint8_t MPU6050_SimCycleMode(MPU6050_Sim *sim) {
+	return (sim->regs[REG_PWR_MGMT_1] & (SLEEP_CONFIG_SET | CYCLE_CONFIG_SET)) == CYCLE_CONFIG_SET;
+}
+
+// Sample period of the internal oscillator, clockErrorPpm included
+static uint64_t MPU6050_SimPeriodNs(MPU6050_Sim *sim) {
+	uint8_t dlpf = sim->regs[REG_CONFIG] & GET_DLPF_CONFIG;
+	uint64_t gyroPeriodNs = (0 == dlpf || 7 == dlpf) ? 1000000000ull / GYRO_OUTPUT_RATE_HZ_DLPF_OFF : 1000000000ull / GYRO_OUTPUT_RATE_HZ_DLPF_ON;
+	int64_t periodNs = (int64_t)gyroPeriodNs * (1 + sim->regs[REG_SMPLRT_DIV]);
+
+	if(MPU6050_SimCycleMode(sim)){
+		periodNs = (int64_t)simLpWakePeriodNs[(sim->regs[REG_PWR_MGMT_2] & GET_LP_WAKE_CTRL_CONFIG) >> 6];
+	}
+
+	return (uint64_t)(periodNs + periodNs * sim->clockErrorPpm / 1000000);
+}
+
+// Motion detection on the high-passed accelerometer output. MOT_DUR counts samples
+// (1ms each at the 1kHz accelerometer rate, one wake-up each in cycle mode)
+static void MPU6050_SimMotion(MPU6050_Sim *sim, float accelSen, float sampleRateHz) {
+	uint8_t hpf = sim->regs[REG_ACCEL_CONFIG] & GET_ACCEL_HPF_CONFIG;
+	uint8_t moving = FALSE;
+
+	for(uint8_t axis = 0; axis < 3; axis++){
+		float accelG = (float)MPU6050_SimReg16(sim, REG_ACCEL_XOUT_H + 2 * axis) / accelSen;
+
+		if(ACCEL_HPF_CONFIG_RESET == hpf){
+			sim->motionRefG[axis] = accelG;
+		}
+		else if(hpf < sizeof(simHpfCutoffHz) / sizeof(simHpfCutoffHz[0])){
+			float k = 6.2831853f * simHpfCutoffHz[hpf] / sampleRateHz;
+			sim->motionRefG[axis] += (accelG - sim->motionRefG[axis]) * (k < 1.0f ? k : 1.0f);
+		}
+
+		float highPassMg = (accelG - sim->motionRefG[axis]) * 1000.0f;
+		if(highPassMg > (float)sim->regs[REG_MOT_THR] * MPU6050_MOT_THR_MG || -highPassMg > (float)sim->regs[REG_MOT_THR] * MPU6050_MOT_THR_MG){
+			moving = TRUE;
+		}
+	}
+
+	if(!moving){
+		uint8_t decrement = sim->regs[REG_MOT_DETECT_CTRL] & MOT_COUNT_CONFIG_4;
+		if(MOT_COUNT_CONFIG_RESET == decrement || sim->motionCount < (1 << (decrement - 1))){
+			sim->motionCount = 0;
+		}
+		else{
+			sim->motionCount -= (uint8_t)(1 << (decrement - 1));
+		}
+		return;
+	}
+
+	if(sim->motionCount < 0xFF){
+		sim->motionCount++;
+	}
+	if(sim->motionCount >= sim->regs[REG_MOT_DUR] && (sim->regs[REG_INT_ENABLE] & MOT_EN_CONFIG_SET)){
+		sim->regs[REG_INT_STATUS] |= MOT_INT_FLAG;
+	}
+}
+
+static void MPU6050_SimFifoPushExt(MPU6050_Sim *sim, uint8_t slave) {
+	uint8_t len;
+	uint8_t pos = MPU6050_SimExtSlot(sim, slave, &len);
+
+	for(uint8_t i = 0; i < len; i++){
+		MPU6050_SimFifoPush(sim, sim->regs[REG_EXT_SENS_DATA_00 + pos + i]);
+	}
+}
+
+// Latches one sample into the output registers and the FIFO
+static void MPU6050_SimSample(MPU6050_Sim *sim, uint64_t timeNs) {
+	float accelG[3] = {sim->accelG[0], sim->accelG[1], sim->accelG[2]};
+	float gyroDps[3] = {sim->gyroDps[0], sim->gyroDps[1], sim->gyroDps[2]};
+	float tempC = sim->tempC;
+
+	if(sim->signal != NULL){
+		sim->signal(sim, timeNs, accelG, gyroDps, &tempC);
+	}
+
+	float accelSen = simAccelSen[(sim->regs[REG_ACCEL_CONFIG] & GET_ACCEL_FS_CONFIG) >> FS_CONFIG_SHIFT];
+	float gyroSen = simGyroSen[(sim->regs[REG_GYRO_CONFIG] & GET_GYRO_FS_CONFIG) >> FS_CONFIG_SHIFT];
+
+	// User offsets are added to the output in their own fixed full-scale format. Axes in standby keep their last output
+	for(uint8_t axis = 0; axis < 3; axis++){
+		float accelOffset = (float)MPU6050_SimReg16(sim, REG_XA_OFFS_USRH + 2 * axis) * accelSen / ACCEL_OFFSET_LSB_SEN;
+		float gyroOffset = (float)MPU6050_SimReg16(sim, REG_XG_OFFS_USRH + 2 * axis) * gyroSen / GYRO_OFFSET_LSB_SEN;
+
+		if(!(sim->regs[REG_PWR_MGMT_2] & (STBY_XA_CONFIG_SET >> axis))){
+			MPU6050_SimPutReg16(sim, REG_ACCEL_XOUT_H + 2 * axis, MPU6050_SimClamp(accelG[axis] * accelSen + accelOffset + MPU6050_SimNoise(sim)));
+		}
+		if(!(sim->regs[REG_PWR_MGMT_2] & (STBY_XG_CONFIG_SET >> axis))){
+			MPU6050_SimPutReg16(sim, REG_GYRO_XOUT_H + 2 * axis, MPU6050_SimClamp(gyroDps[axis] * gyroSen + gyroOffset + MPU6050_SimNoise(sim)));
+		}
+	}
+
+	MPU6050_SimMotion(sim, accelSen, 1e9f / (float)MPU6050_SimPeriodNs(sim));
+
+	if(!(sim->regs[REG_PWR_MGMT_1] & TEMP_DIS_CONFIG_SET)){
+		MPU6050_SimPutReg16(sim, REG_TEMP_OUT_H, MPU6050_SimClamp((tempC - TEMP_OFFSET) * TEMP_LSB_SEN));
+	}
+
+	MPU6050_SimAuxRun(sim);
+
+	sim->regs[REG_INT_STATUS] |= DATA_RDY_INT_FLAG;
+	sim->samples++;
+
+	if(sim->regs[REG_USER_CTRL] & FIFO_EN_CONFIG_SET){
+		uint8_t fifoEn = sim->regs[REG_FIFO_EN];
+
+		if(fifoEn & ACCEL_FIFO_EN_CONFIG_SET){
+			for(uint8_t reg = REG_ACCEL_XOUT_H; reg <= REG_ACCEL_ZOUT_L; reg++){
+				MPU6050_SimFifoPush(sim, sim->regs[reg]);
+			}
+		}
+		if(fifoEn & TEMP_FIFO_EN_CONFIG_SET){
+			MPU6050_SimFifoPush(sim, sim->regs[REG_TEMP_OUT_H]);
+			MPU6050_SimFifoPush(sim, sim->regs[REG_TEMP_OUT_L]);
+		}
+		if(fifoEn & XG_FIFO_EN_CONFIG_SET){
+			MPU6050_SimFifoPush(sim, sim->regs[REG_GYRO_XOUT_H]);
+			MPU6050_SimFifoPush(sim, sim->regs[REG_GYRO_XOUT_L]);
+		}
+		if(fifoEn & YG_FIFO_EN_CONFIG_SET){
+			MPU6050_SimFifoPush(sim, sim->regs[REG_GYRO_YOUT_H]);
+			MPU6050_SimFifoPush(sim, sim->regs[REG_GYRO_YOUT_L]);
+		}
+		if(fifoEn & ZG_FIFO_EN_CONFIG_SET){
+			MPU6050_SimFifoPush(sim, sim->regs[REG_GYRO_ZOUT_H]);
+			MPU6050_SimFifoPush(sim, sim->regs[REG_GYRO_ZOUT_L]);
+		}
+		for(uint8_t slave = 0; slave < 3; slave++){
+			if(fifoEn & (SLV0_FIFO_EN_CONFIG_SET << slave)){
+				MPU6050_SimFifoPushExt(sim, slave);
+			}
+		}
+		if(sim->regs[REG_I2C_MST_CTRL] & SLV3_FIFO_EN_CONFIG_SET){
+			MPU6050_SimFifoPushExt(sim, 3);
+		}
+	}
+}
+
+uint32_t MPU6050_SimSampleRateHz(MPU6050_Sim *sim) {
+	uint8_t dlpf = sim->regs[REG_CONFIG] & GET_DLPF_CONFIG;
+	uint32_t gyroRate = (0 == dlpf || 7 == dlpf) ? GYRO_OUTPUT_RATE_HZ_DLPF_OFF : GYRO_OUTPUT_RATE_HZ_DLPF_ON;
+
+	return gyroRate / (1 + sim->regs[REG_SMPLRT_DIV]);
+}
+
+uint32_t MPU6050_SimSupplyCurrentUa(MPU6050_Sim *sim) {
+	uint8_t pwrMgmt2 = sim->regs[REG_PWR_MGMT_2];
+	uint8_t gyroOn = (pwrMgmt2 & (STBY_XG_CONFIG_SET | STBY_YG_CONFIG_SET | STBY_ZG_CONFIG_SET)) != (STBY_XG_CONFIG_SET | STBY_YG_CONFIG_SET | STBY_ZG_CONFIG_SET);
+	uint8_t accelOn = (pwrMgmt2 & (STBY_XA_CONFIG_SET | STBY_YA_CONFIG_SET | STBY_ZA_CONFIG_SET)) != (STBY_XA_CONFIG_SET | STBY_YA_CONFIG_SET | STBY_ZA_CONFIG_SET);
+
+	if(sim->regs[REG_PWR_MGMT_1] & SLEEP_CONFIG_SET){
+		return MPU6050_SIM_IDD_SLEEP_UA;
+	}
+	if(MPU6050_SimCycleMode(sim)){
+		return simLpWakeCurrentUa[(pwrMgmt2 & GET_LP_WAKE_CTRL_CONFIG) >> 6];
+	}
+	if(gyroOn){
+		return accelOn ? MPU6050_SIM_IDD_GYRO_ACCEL_UA : MPU6050_SIM_IDD_GYRO_UA;
+	}
+	return accelOn ? MPU6050_SIM_IDD_ACCEL_UA : MPU6050_SIM_IDD_SLEEP_UA;
+}
+
+// Produces every sample due up to timeNs
+static void MPU6050_SimRun(MPU6050_Sim *sim, uint64_t timeNs) {
+	sim->chargeFc += (uint64_t)MPU6050_SimSupplyCurrentUa(sim) * (timeNs - sim->chargeTimeNs);
+	sim->chargeTimeNs = timeNs;
+
+	if(sim->regs[REG_PWR_MGMT_1] & SLEEP_CONFIG_SET){
+		sim->nextSampleNs = timeNs;
+		return;
+	}
+
+	uint64_t periodNs = MPU6050_SimPeriodNs(sim);
+
+	while(sim->nextSampleNs <= timeNs){
+		MPU6050_SimSample(sim, sim->nextSampleNs);
+		sim->nextSampleNs += periodNs;
+	}
+}
+
+static uint8_t MPU6050_SimReadReg(MPU6050_Sim *sim, uint8_t reg) {
+	uint8_t value;
+
+	switch(reg){
+		case REG_FIFO_R_W:
+			return MPU6050_SimFifoPop(sim);
+		case REG_FIFO_COUNTH:
+			return (uint8_t)(sim->fifoCount >> 8);
+		case REG_FIFO_COUNTL:
+			return (uint8_t)(sim->fifoCount & LOW_BYTE_MASK);
+		case REG_INT_STATUS:
+			value = sim->regs[REG_INT_STATUS];
+			sim->regs[REG_INT_STATUS] = 0;
+			return value;
+		case REG_I2C_MST_STATUS:
+			value = sim->regs[REG_I2C_MST_STATUS];
+			sim->regs[REG_I2C_MST_STATUS] &= PASS_THROUGH_FLAG;
+			return value;
+		default:
+			return (reg < MPU6050_SIM_REGS) ? sim->regs[reg] : 0;
+	}
+}
+
+static void MPU6050_SimWriteReg(MPU6050_Sim *sim, uint8_t reg, uint8_t value, uint64_t timeNs) {
+	uint8_t restart;
+
+	switch(reg){
+		case REG_PWR_MGMT_1:
+			if(value & DEVICE_RESET_CONFIG_SET){
+				MPU6050_SimReset(sim, timeNs);
+				return;
+			}
+			// Sampling restarts on wake up, and when entering or leaving the cycle mode
+			restart = ((sim->regs[REG_PWR_MGMT_1] & SLEEP_CONFIG_SET) && !(value & SLEEP_CONFIG_SET)) ||
+					  ((sim->regs[REG_PWR_MGMT_1] ^ value) & CYCLE_CONFIG_SET);
+			sim->regs[reg] = value;
+			if(restart){
+				sim->nextSampleNs = timeNs + MPU6050_SimPeriodNs(sim);
+			}
+			return;
+		case REG_PWR_MGMT_2:
+			restart = MPU6050_SimCycleMode(sim) && ((sim->regs[reg] ^ value) & GET_LP_WAKE_CTRL_CONFIG);
+			sim->regs[reg] = value;
+			if(restart){
+				sim->nextSampleNs = timeNs + MPU6050_SimPeriodNs(sim);
+			}
+			return;
+		case REG_USER_CTRL:
+			if(value & FIFO_RESET_CONFIG_SET){
+				sim->fifoHead = 0;
+				sim->fifoCount = 0;
+			}
+			sim->regs[reg] = value & (uint8_t)~(FIFO_RESET_CONFIG_SET | I2C_MST_RESET_CONFIG_SET | SIG_COND_RESET_CONFIG_SET);
+			return;
+		case REG_FIFO_R_W:
+			MPU6050_SimFifoPush(sim, value);
+			return;
+		case REG_INT_STATUS:
+		case REG_I2C_SLV4_DI:
+		case REG_I2C_MST_STATUS:
+		case REG_FIFO_COUNTH:
+		case REG_FIFO_COUNTL:
+		case REG_WHO_AM_I:
+			return;
+		default:
+			// Output registers are read-only
+			if(reg >= REG_ACCEL_XOUT_H && reg <= REG_EXT_SENS_DATA_23){
+				return;
+			}
+			if(reg < MPU6050_SIM_REGS){
+				sim->regs[reg] = value;
+			}
+			return;
+	}
+}
+
+uint64_t MPU6050_SimTransactionNs(MPU6050_SimBus *bus, uint16_t writeBytes, uint16_t readBytes) {
+	// START + address + written bytes + STOP, then repeated START + address + read bytes
+	uint32_t bits = 2 + 9 * (1 + writeBytes);
+	if(readBytes > 0){
+		bits += 1 + 9 * (1 + readBytes);
+	}
+
+	return (uint64_t)bits * 1000000000ull / bus->clockHz + bus->latencyNs;
+}
+
+static MPU6050_Sim *MPU6050_SimFind(MPU6050_SimBus *bus, uint8_t address) {
+	for(uint8_t i = 0; i < bus->numDevices; i++){
+		if(bus->devices[i]->address == address){
+			return bus->devices[i];
+		}
+	}
+	return NULL;
+}
+
+// Accounts the transaction and returns the addressed device, or NULL if it is not acknowledged
+static MPU6050_Sim *MPU6050_SimBegin(MPU6050_SimBus *bus, uint8_t address, uint16_t writeBytes, uint16_t readBytes, HAL_StatusTypeDef *status) {
+	uint64_t durationNs = MPU6050_SimTransactionNs(bus, writeBytes, readBytes);
+	MPU6050_Sim *sim = MPU6050_SimFind(bus, address);
+
+	bus->transactions++;
+	if(readBytes > 0){
+		bus->reads++;
+	}
+	else{
+		bus->writes++;
+	}
+	*status = HAL_OK;
+
+	if(SIM_FAULT_NACK == bus->fault || SIM_FAULT_STUCK_BUS == bus->fault){
+		*status = (SIM_FAULT_NACK == bus->fault) ? HAL_ERROR : HAL_TIMEOUT;
+		// A NACK ends after the address byte, a stuck bus waits for the whole timeout
+		durationNs = (SIM_FAULT_NACK == bus->fault) ? MPU6050_SimTransactionNs(bus, 0, 0) : MPU6050_SIM_STUCK_TIMEOUT_NS;
+		if(bus->faultCount > 0 && 0 == --bus->faultCount){
+			bus->fault = SIM_FAULT_NONE;
+		}
+		sim = NULL;
+	}
+	else if(NULL == sim){
+		*status = HAL_ERROR;
+		durationNs = MPU6050_SimTransactionNs(bus, 0, 0);
+	}
+
+	if(HAL_OK != *status){
+		bus->errors++;
+	}
+
+	bus->busTimeNs += durationNs;
+	MPU6050_SimAdvance(bus, durationNs);
+
+	return sim;
+}
+
+static HAL_StatusTypeDef MPU6050_SimRead(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	MPU6050_SimBus *bus = (MPU6050_SimBus *)hi2c->context;
+	HAL_StatusTypeDef status;
+
+	MPU6050_Sim *sim = MPU6050_SimBegin(bus, address, 1, len, &status);
+	if(NULL == sim){
+		return status;
+	}
+
+	// Auto-increment, except on FIFO_R_W which keeps returning FIFO bytes
+	sim->regPointer = reg;
+	for(uint16_t i = 0; i < len; i++){
+		data[i] = MPU6050_SimReadReg(sim, sim->regPointer);
+		if(REG_WHO_AM_I == sim->regPointer && SIM_FAULT_BAD_WHO_AM_I == bus->fault){
+			data[i] ^= 0xFF;
+		}
+		if(sim->regPointer != REG_FIFO_R_W){
+			sim->regPointer++;
+		}
+	}
+	bus->bytesRead += len;
+
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef MPU6050_SimWrite(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	MPU6050_SimBus *bus = (MPU6050_SimBus *)hi2c->context;
+	HAL_StatusTypeDef status;
+
+	MPU6050_Sim *sim = MPU6050_SimBegin(bus, address, 1 + len, 0, &status);
+	if(NULL == sim){
+		return status;
+	}
+
+	sim->regPointer = reg;
+	for(uint16_t i = 0; i < len; i++){
+		MPU6050_SimWriteReg(sim, sim->regPointer, data[i], bus->timeNs);
+		if(sim->regPointer != REG_FIFO_R_W){
+			sim->regPointer++;
+		}
+	}
+	bus->bytesWritten += len;
+
+	return HAL_OK;
+}
+
+const MPU6050_Transport MPU6050_SimTransport = {
+	.read = MPU6050_SimRead,
+	.write = MPU6050_SimWrite,
+	.readBlocks = NULL,
+	.startRead = NULL
+};
+
+void MPU6050_SimBusInit(MPU6050_SimBus *bus, uint32_t clockHz) {
+	memset(bus, 0, sizeof(*bus));
+	bus->clockHz = clockHz;
+}
+
+void MPU6050_SimInit(MPU6050_Sim *sim, uint8_t address) {
+	memset(sim, 0, sizeof(*sim));
+	sim->address = address;
+	sim->accelG[2] = 1.0f;		// Lying flat
+	sim->tempC = 25.0f;
+	sim->noiseSeed = 1;
+	MPU6050_SimReset(sim, 0);
+}
+
+// Power-on register values
+void MPU6050_SimReset(MPU6050_Sim *sim, uint64_t timeNs) {
+	memset(sim->regs, 0, sizeof(sim->regs));
+	sim->regs[REG_PWR_MGMT_1] = SLEEP_CONFIG_SET;
+	sim->regs[REG_WHO_AM_I] = MPU6050_WHO_AM_I_VALUE;
+	sim->regPointer = 0;
+	sim->fifoHead = 0;
+	sim->fifoCount = 0;
+	sim->nextSampleNs = timeNs;
+	sim->samples = 0;
+	memset(sim->motionRefG, 0, sizeof(sim->motionRefG));
+	sim->motionCount = 0;
+}
+
+uint8_t MPU6050_SimAttach(MPU6050_SimBus *bus, MPU6050_Sim *sim) {
+	if(bus->numDevices >= MPU6050_SIM_MAX_DEVICES){
+		return FALSE;
+	}
+	sim->nextSampleNs = bus->timeNs;
+	sim->chargeTimeNs = bus->timeNs;
+	bus->devices[bus->numDevices++] = sim;
+	return TRUE;
+}
+
+void MPU6050_SimAuxInit(MPU6050_SimAux *aux, uint8_t address) {
+	memset(aux, 0, sizeof(*aux));
+	aux->address = address;
+}
+
+uint8_t MPU6050_SimAttachAux(MPU6050_Sim *sim, MPU6050_SimAux *aux) {
+	if(sim->numAux >= MPU6050_SIM_MAX_AUX){
+		return FALSE;
+	}
+	sim->aux[sim->numAux++] = aux;
+	return TRUE;
+}
+
+void MPU6050_SimAdvance(MPU6050_SimBus *bus, uint64_t durationNs) {
+	bus->timeNs += durationNs;
+	for(uint8_t i = 0; i < bus->numDevices; i++){
+		MPU6050_SimRun(bus->devices[i], bus->timeNs);
+	}
+}
+
+void MPU6050_SimInjectFault(MPU6050_SimBus *bus, uint8_t fault, uint32_t count) {
+	bus->fault = fault;
+	bus->faultCount = count;
+}
+
+void MPU6050_SimResetStats(MPU6050_SimBus *bus) {
+	bus->transactions = 0;
+	bus->reads = 0;
+	bus->writes = 0;
+	bus->bytesRead = 0;
+	bus->bytesWritten = 0;
+	bus->errors = 0;
+	bus->busTimeNs = 0;
+}
+
+#endif
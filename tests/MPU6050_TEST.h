@@ -0,0 +1,56 @@
+/*
+ * MPU6050_TEST.h
+ * Minimal assertions and simulator setup shared by the host tests.
+ */
+
+#ifndef MPU6050_TEST
+#define MPU6050_TEST
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MPU6050_SIM.h"
+
+static int testFailures = 0;
+
+#define CHECK(cond) do{ \
+		if(!(cond)){ \
+			fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+			testFailures++; \
+		} \
+	} while(0)
+
+#define CHECK_EQ(actual, expected) do{ \
+		long long checkActual = (long long)(actual), checkExpected = (long long)(expected); \
+		if(checkActual != checkExpected){ \
+			fprintf(stderr, "%s:%d: CHECK_EQ failed: %s = %lld, expected %lld\n", __FILE__, __LINE__, #actual, checkActual, checkExpected); \
+			testFailures++; \
+		} \
+	} while(0)
+
+#define TEST_RESULT() (testFailures ? (fprintf(stderr, "%d check(s) failed\n", testFailures), EXIT_FAILURE) : EXIT_SUCCESS)
+
+// Simulated device on its own bus, configured for 1 kHz samples
+typedef struct {
+	MPU6050_SimBus bus;
+	MPU6050_Sim sim;
+	I2C_HandleTypeDef hi2c;
+	MPU6050_ConfigTypeDef config;
+} MPU6050_TestDevice;
+
+static inline void MPU6050_TestDeviceInit(MPU6050_TestDevice *dev, uint8_t address) {
+	memset(dev, 0, sizeof(*dev));
+	MPU6050_SimBusInit(&dev->bus, MPU6050_SIM_I2C_400KHZ);
+	MPU6050_SimInit(&dev->sim, address);
+	MPU6050_SimAttach(&dev->bus, &dev->sim);
+	dev->hi2c.fd = -1;
+	dev->hi2c.context = &dev->bus;
+
+	dev->config.hi2c = &dev->hi2c;
+	dev->config.address = address;
+	dev->config.transport = &MPU6050_SimTransport;
+	dev->config.dlpfFsyncConfig = DLPF_CONFIG_3;
+	dev->config.pwrMgmt1Config = CLKSEL_CONFIG_1;
+}
+
+#endif /* MPU6050_TEST */
@@ -0,0 +1,44 @@
+// Writes the three benchmark reports as JSON: bench.json (public functions on the simulated bus),
+// bench_fusion.json and bench_filter.json, in the directory given as argument (default: current)
+#include <stdlib.h>
+#include "MPU6050_BENCH.h"
+
+static FILE *OpenReport(const char *dir, const char *name) {
+	char path[512];
+	FILE *out;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	out = fopen(path, "w");
+	if(NULL == out){
+		perror(path);
+	}
+	return out;
+}
+
+int main(int argc, char **argv) {
+	static MPU6050_BenchResult results[MPU6050_BENCH_MAX_CASES];
+	static MPU6050_BenchFusionResult fusionResults[MPU6050_BENCH_FUSION_FILTERS];
+	static MPU6050_BenchFilterResult filterResults[MPU6050_BENCH_FILTER_CASES];
+	const char *dir = (argc > 1) ? argv[1] : ".";
+	FILE *out;
+
+	if(NULL == (out = OpenReport(dir, "bench.json"))){
+		return EXIT_FAILURE;
+	}
+	MPU6050_BenchWriteJson(out, results, MPU6050_BenchRunAll(results, MPU6050_BENCH_MAX_CASES));
+	fclose(out);
+
+	if(NULL == (out = OpenReport(dir, "bench_fusion.json"))){
+		return EXIT_FAILURE;
+	}
+	MPU6050_BenchWriteFusionJson(out, fusionResults, MPU6050_BenchFusionRunAll(fusionResults));
+	fclose(out);
+
+	if(NULL == (out = OpenReport(dir, "bench_filter.json"))){
+		return EXIT_FAILURE;
+	}
+	MPU6050_BenchWriteFilterJson(out, filterResults, MPU6050_BenchFilterRunAll(filterResults));
+	fclose(out);
+
+	return EXIT_SUCCESS;
+}
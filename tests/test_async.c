@@ -0,0 +1,88 @@
+// MPU6050_AsyncGetSample never returns a torn sample while completions run on another thread,
+// and MPU6050_DataReadyInit refuses readers that would block in the interrupt
+#include <pthread.h>
+#include "MPU6050_TEST.h"
+
+#define COMPLETIONS		2000000
+#define SEQUENCE_MOD	30000
+
+static MPU6050_AsyncReader reader;
+static volatile uint8_t writerDone;
+static uint32_t counter;
+
+// Fake bus: every field of the burst holds the same counter value (INT_STATUS left alone)
+static uint8_t FakeStartRead(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len) {
+	(void)config;
+	int16_t value = (int16_t)(counter % SEQUENCE_MOD);
+
+	for(uint16_t i = REG_ACCEL_XOUT_H - reg; i + 1 < len; i += 2){
+		data[i] = (uint8_t)((uint16_t)value >> 8);
+		data[i + 1] = (uint8_t)(value & LOW_BYTE_MASK);
+	}
+	counter++;
+
+	return ASYNC_OK;
+}
+
+// Plays the transfer-complete interrupt
+static void *Writer(void *arg) {
+	(void)arg;
+
+	for(uint32_t i = 0; i < COMPLETIONS; i++){
+		if(ASYNC_OK == MPU6050_AsyncStart(&reader)){
+			MPU6050_AsyncComplete(&reader, TRUE);
+		}
+	}
+	writerDone = TRUE;
+
+	return NULL;
+}
+
+int main(void) {
+	MPU6050_ConfigTypeDef config = {0};
+	MPU6050_Accelerations accel;
+	MPU6050_Rotations rota;
+	MPU6050_Temperature temp;
+	pthread_t writer;
+	uint32_t reads = 0;
+	uint32_t changes = 0;
+	int16_t last = -1;
+
+	// DATA_RDY reads start in the EXTI interrupt, a reader with the blocking fallback is refused
+	MPU6050_DataReady drdy;
+	MPU6050_TestDevice dev;
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	MPU6050_AsyncInit(&reader, &dev.config, NULL, NULL, NULL);
+	CHECK_EQ(MPU6050_DataReadyInit(&drdy, &reader), ERR_INT_BLOCKING_READER);
+
+	MPU6050_AsyncInit(&reader, &config, FakeStartRead, NULL, NULL);
+	CHECK_EQ(MPU6050_DataReadyInit(&drdy, &reader), INT_OK);
+	CHECK_EQ(MPU6050_AsyncGetSample(&reader, &accel, &rota, &temp), ERR_ASYNC_NO_DATA);
+
+	CHECK_EQ(pthread_create(&writer, NULL, Writer, NULL), 0);
+	while(!writerDone){
+		if(ASYNC_OK != MPU6050_AsyncGetSample(&reader, &accel, &rota, &temp)){
+			continue;
+		}
+		reads++;
+
+		int16_t value = accel.rawAccelX;
+		if(accel.rawAccelY != value || accel.rawAccelZ != value || temp.rawTemp != value ||
+		   rota.rawRotaX != value || rota.rawRotaY != value || rota.rawRotaZ != value){
+			CHECK(!"torn sample");
+			break;
+		}
+		if(value != last){
+			changes++;
+			last = value;
+		}
+	}
+	pthread_join(writer, NULL);
+
+	CHECK_EQ(reader.errors, 0);
+	CHECK_EQ(MPU6050_AsyncGetSample(&reader, &accel, NULL, NULL), ASYNC_OK);
+	CHECK_EQ(accel.rawAccelX, (COMPLETIONS - 1) % SEQUENCE_MOD);
+	printf("%u samples read, %u distinct\n", reads, changes);
+
+	return TEST_RESULT();
+}
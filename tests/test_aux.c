@@ -0,0 +1,106 @@
+// Auxiliary slaves on simulated external devices: EXT_SENS_DATA packs the read slaves in slave
+// order after the sensors of the burst, and a FIFO frame holds the slaves loaded into the FIFO
+// without gaps, slave 3 last. Built with MPU6050_FIFO_EXT_LEN so the frame bytes are kept
+#include "MPU6050_TEST.h"
+
+#define MAG_ADDRESS		0x0D
+#define BARO_ADDRESS	0x77
+#define MAG_WHO_AM_I	0xFF
+
+// Slave 0: 6 magnetometer bytes, slave 1: barometer conversion trigger, slave 2: 3 barometer
+// bytes, slave 3: 2 magnetometer bytes
+static const MPU6050_AuxSlave slaves[MPU6050_AUX_SLAVES] = {
+	{.address = MAG_ADDRESS, .reg = 0x03, .len = 6},
+	{.address = BARO_ADDRESS, .reg = 0xF4, .len = 1, .write = TRUE, .dataOut = 0x2E},
+	{.address = BARO_ADDRESS, .reg = 0xF6, .len = 3},
+	{.address = MAG_ADDRESS, .reg = 0x10, .len = 2}
+};
+static const uint8_t extOffsets[MPU6050_AUX_SLAVES + 1] = {0, 6, 6, 9, 11};
+
+static MPU6050_SimAux mag, baro;
+
+// Accelerometer X carries the sample number, and so do the registers read by slaves 2 and 3
+static void SequenceSignal(MPU6050_Sim *sim, uint64_t timeNs, float accelG[3], float gyroDps[3], float *tempC) {
+	uint32_t *sequence = sim->context;
+	(void)timeNs; (void)gyroDps; (void)tempC;
+
+	accelG[0] = (float)(*sequence % 256) / ACCEL_LSB_SEN_0;
+	baro.regs[0xF6] = (uint8_t)*sequence;
+	mag.regs[0x11] = (uint8_t)~*sequence;
+	(*sequence)++;
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_FifoSample storage[16];
+	MPU6050_FifoSample sample;
+	MPU6050_FifoRing ring;
+	uint8_t extData[MPU6050_EXT_SENS_DATA_LEN];
+	uint32_t sequence = 0;
+	uint32_t popped = 0;
+	uint8_t id;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	MPU6050_SimAuxInit(&mag, MAG_ADDRESS);
+	MPU6050_SimAuxInit(&baro, BARO_ADDRESS);
+	for(uint16_t r = 0; r < MPU6050_SIM_AUX_REGS; r++){
+		mag.regs[r] = (uint8_t)(0x10 + r);
+		baro.regs[r] = (uint8_t)(0x80 + r);
+	}
+	mag.regs[0x00] = MAG_WHO_AM_I;
+	CHECK_EQ(MPU6050_SimAttachAux(&dev.sim, &mag), TRUE);
+	CHECK_EQ(MPU6050_SimAttachAux(&dev.sim, &baro), TRUE);
+	dev.sim.signal = SequenceSignal;
+	dev.sim.context = &sequence;
+
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	CHECK_EQ(MPU6050_AuxEnable(&dev.config, WAIT_FOR_ES_CONFIG_SET | I2C_MST_CLK_CONFIG_13 | SLV3_FIFO_EN_CONFIG_SET, 0), AUX_OK);
+	CHECK_EQ(MPU6050_AuxRead(&dev.config, MAG_ADDRESS, 0x00, &id), AUX_OK);
+	CHECK_EQ(id, MAG_WHO_AM_I);
+	CHECK_EQ(MPU6050_AuxRead(&dev.config, 0x1E, 0x00, &id), ERR_AUX_NACK);
+
+	// The write slave takes no room in EXT_SENS_DATA
+	for(uint8_t s = 0; s < MPU6050_AUX_SLAVES; s++){
+		CHECK_EQ(MPU6050_AuxConfigSlave(&dev.config, s, &slaves[s]), AUX_OK);
+	}
+	for(uint8_t s = 0; s <= MPU6050_AUX_SLAVES; s++){
+		CHECK_EQ(MPU6050_AuxGetExtOffset(&dev.config, s), extOffsets[s]);
+	}
+	CHECK_EQ(MPU6050_AuxGetExtLen(&dev.config), extOffsets[MPU6050_AUX_SLAVES]);
+
+	// One burst of the sensors and the 11 enabled bytes, at the offsets of the getters
+	MPU6050_SimAdvance(&dev.bus, 2000000);
+	MPU6050_SimResetStats(&dev.bus);
+	memset(extData, 0, sizeof(extData));
+	CHECK_EQ(MPU6050_GetAllSensorsExt(&dev.config, NULL, NULL, NULL, extData), CONN_OK);
+	CHECK_EQ(dev.bus.reads, 1);
+	CHECK_EQ(dev.bus.bytesRead, MPU6050_SENSORS_BURST_LEN + extOffsets[MPU6050_AUX_SLAVES]);
+	CHECK(0 == memcmp(&extData[extOffsets[0]], &mag.regs[0x03], 6));
+	CHECK(0 == memcmp(&extData[extOffsets[2]], &baro.regs[0xF6], 3));
+	CHECK(0 == memcmp(&extData[extOffsets[3]], &mag.regs[0x10], 2));
+	CHECK_EQ(baro.regs[0xF4], 0x2E);
+	CHECK(baro.writes > 0);
+
+	// FIFO with slaves 2 and 3 only: accelerometer, then 3 barometer bytes at 0 and 2 magnetometer
+	// bytes at 3 of extData, whatever their EXT_SENS_DATA offsets
+	MPU6050_FifoRingInit(&ring, storage, sizeof(storage) / sizeof(storage[0]));
+	CHECK_EQ(MPU6050_FifoEnable(&dev.config, ACCEL_FIFO_EN_CONFIG_SET | SLV2_FIFO_EN_CONFIG_SET), FIFO_OK);
+	CHECK_EQ(MPU6050_GetFifoFrameSize(&dev.config), 6 + 3 + 2);
+	for(uint8_t i = 0; i < 20; i++){
+		MPU6050_SimAdvance(&dev.bus, 5000000);
+		CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+		while(FIFO_OK == MPU6050_FifoPop(&ring, &sample)){
+			uint8_t n = (uint8_t)sample.accel.rawAccelX;
+
+			CHECK_EQ(sample.extData[0], n);
+			CHECK_EQ(sample.extData[1], baro.regs[0xF7]);
+			CHECK_EQ(sample.extData[2], baro.regs[0xF8]);
+			CHECK_EQ(sample.extData[3], mag.regs[0x10]);
+			CHECK_EQ(sample.extData[4], (uint8_t)~n);
+			popped++;
+		}
+	}
+	CHECK(popped > 90);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,102 @@
+// MPU6050_ConvertBatch matches MPU6050_ConvertSample frame by frame for every full scale, with
+// lengths around the vector width and MPU6050_BATCH_BLOCK, and skips the NULL channels
+#include <math.h>
+#include "MPU6050_BATCH.h"
+#include "MPU6050_TEST.h"
+
+#define MAX_FRAMES		1001
+#define SENTINEL		-12345.0f
+
+// Bit-exact on x86-64, a fused multiply-add (NEON, FMA) may round the last bit differently
+#define NEAR(a, b)		(fabsf((a) - (b)) <= 1e-6f * fabsf(b) + 1e-6f)
+
+static uint8_t frames[MAX_FRAMES * MPU6050_SENSORS_BURST_LEN];
+static float channel[MPU6050_BATCH_CHANNELS][MAX_FRAMES + 1];
+
+static void CheckBatch(MPU6050_ConfigTypeDef *config, uint32_t numFrames) {
+	MPU6050_BatchData out = {channel[0], channel[1], channel[2], NULL, channel[4], channel[5], channel[6]};
+	uint32_t mismatches = 0;
+
+	for(uint8_t ch = 0; ch < MPU6050_BATCH_CHANNELS; ch++){
+		for(uint32_t i = 0; i <= MAX_FRAMES; i++){
+			channel[ch][i] = SENTINEL;
+		}
+	}
+	MPU6050_ConvertBatch(config, frames, numFrames, &out);
+
+	for(uint32_t i = 0; i < numFrames; i++){
+		const uint8_t *f = &frames[i * MPU6050_SENSORS_BURST_LEN];
+		MPU6050_Accelerations accel = {0};
+		MPU6050_Rotations rota = {0};
+
+		accel.rawAccelX = MPU6050_BYTES_TO_INT16(f[0], f[1]);
+		accel.rawAccelY = MPU6050_BYTES_TO_INT16(f[2], f[3]);
+		accel.rawAccelZ = MPU6050_BYTES_TO_INT16(f[4], f[5]);
+		rota.rawRotaX = MPU6050_BYTES_TO_INT16(f[8], f[9]);
+		rota.rawRotaY = MPU6050_BYTES_TO_INT16(f[10], f[11]);
+		rota.rawRotaZ = MPU6050_BYTES_TO_INT16(f[12], f[13]);
+		MPU6050_ConvertSample(config, &accel, &rota, NULL);
+
+		if(!NEAR(channel[0][i], accel.convertedAccelX) || !NEAR(channel[1][i], accel.convertedAccelY) ||
+		   !NEAR(channel[2][i], accel.convertedAccelZ) || !NEAR(channel[4][i], rota.convertedRotaX) ||
+		   !NEAR(channel[5][i], rota.convertedRotaY) || !NEAR(channel[6][i], rota.convertedRotaZ)){
+			mismatches++;
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+
+	// Nothing written past the last frame, nor in the skipped channel
+	CHECK(SENTINEL == channel[0][numFrames]);
+	CHECK(SENTINEL == channel[6][numFrames]);
+	CHECK(SENTINEL == channel[3][0]);
+}
+
+// Unaligned source and destination, every length up to past the vector loops
+static void CheckScale(void) {
+	static int16_t raw[MAX_FRAMES + 1];
+	static float dst[MAX_FRAMES + 2];
+	uint32_t mismatches = 0;
+
+	for(uint32_t i = 0; i <= MAX_FRAMES; i++){
+		raw[i] = (int16_t)(i * 2654435761u >> 16);
+	}
+	for(uint32_t len = 0; len <= 3 * MPU6050_BATCH_BLOCK; len++){
+		dst[len + 1] = SENTINEL;
+		MPU6050_ScaleInt16(&raw[1], &dst[1], len, 0.0123f, -4.5f);
+		for(uint32_t i = 0; i < len; i++){
+			if(!NEAR(dst[1 + i], (float)raw[1 + i] * 0.0123f - 4.5f)){
+				mismatches++;
+			}
+		}
+		CHECK(SENTINEL == dst[len + 1]);
+	}
+	CHECK_EQ(mismatches, 0);
+}
+
+int main(void) {
+	static const uint32_t lengths[] = {0, 1, 7, 9, MPU6050_BATCH_BLOCK - 1, MPU6050_BATCH_BLOCK, MPU6050_BATCH_BLOCK + 1, 2 * MPU6050_BATCH_BLOCK + 3, MAX_FRAMES};
+	MPU6050_ConfigTypeDef config = {0};
+	uint32_t seed = 7;
+
+	// Full-range raw values, extremes included
+	for(uint32_t i = 0; i < sizeof(frames); i++){
+		seed = seed * 1103515245u + 12345u;
+		frames[i] = (uint8_t)(seed >> 24);
+	}
+	frames[0] = 0x80;
+	frames[1] = 0x00;
+	frames[2] = 0x7F;
+	frames[3] = 0xFF;
+
+	CheckScale();
+
+	for(uint8_t fs = 0; fs < 4; fs++){
+		config.accelConfig = (uint8_t)(fs << FS_CONFIG_SHIFT);
+		config.gyroConfig = (uint8_t)((3 - fs) << FS_CONFIG_SHIFT);
+		for(uint8_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++){
+			CheckBatch(&config, lengths[l]);
+		}
+	}
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,59 @@
+// MPU6050_GetAllSensors reads every sensor in one 14-byte transaction
+#include "MPU6050_TEST.h"
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_Accelerations accel, accelSingle;
+	MPU6050_Rotations rota, rotaSingle;
+	MPU6050_Temperature temp, tempSingle;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	dev.sim.accelG[0] = 0.25f;
+	dev.sim.accelG[1] = -0.5f;
+	dev.sim.accelG[2] = 1.0f;
+	dev.sim.gyroDps[0] = 10.0f;
+	dev.sim.gyroDps[1] = -20.0f;
+	dev.sim.gyroDps[2] = 30.0f;
+	dev.sim.tempC = 30.0f;
+
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	MPU6050_SimAdvance(&dev.bus, 5000000);
+
+	MPU6050_SimResetStats(&dev.bus);
+	CHECK_EQ(MPU6050_GetAllSensors(&dev.config, &accel, &rota, &temp), CONN_OK);
+	CHECK_EQ(dev.bus.transactions, 1);
+	CHECK_EQ(dev.bus.reads, 1);
+	CHECK_EQ(dev.bus.writes, 0);
+	CHECK_EQ(dev.bus.bytesRead, MPU6050_SENSORS_BURST_LEN);
+	CHECK_EQ(dev.bus.errors, 0);
+
+	// NULL outputs do not change the bus traffic
+	MPU6050_SimResetStats(&dev.bus);
+	CHECK_EQ(MPU6050_GetAllSensors(&dev.config, NULL, NULL, NULL), CONN_OK);
+	CHECK_EQ(dev.bus.transactions, 1);
+	CHECK_EQ(dev.bus.bytesRead, MPU6050_SENSORS_BURST_LEN);
+
+	// Same sample as the single-sensor getters (constant input, no noise)
+	CHECK_EQ(MPU6050_GetAcceleration(&dev.config, &accelSingle), CONN_OK);
+	CHECK_EQ(MPU6050_GetRotation(&dev.config, &rotaSingle), CONN_OK);
+	CHECK_EQ(MPU6050_GetTemperature(&dev.config, &tempSingle), CONN_OK);
+	CHECK_EQ(accel.rawAccelX, accelSingle.rawAccelX);
+	CHECK_EQ(accel.rawAccelY, accelSingle.rawAccelY);
+	CHECK_EQ(accel.rawAccelZ, accelSingle.rawAccelZ);
+	CHECK_EQ(rota.rawRotaX, rotaSingle.rawRotaX);
+	CHECK_EQ(rota.rawRotaY, rotaSingle.rawRotaY);
+	CHECK_EQ(rota.rawRotaZ, rotaSingle.rawRotaZ);
+	CHECK_EQ(temp.rawTemp, tempSingle.rawTemp);
+	CHECK_EQ(accel.rawAccelX, ACCEL_LSB_SEN_0 / 4);
+	CHECK_EQ(accel.rawAccelZ, ACCEL_LSB_SEN_0);
+	CHECK_EQ(accel.timestampUs, rota.timestampUs);
+	CHECK_EQ(accel.timestampUs, temp.timestampUs);
+
+	// A failed transfer is one transaction and reports the connection error
+	MPU6050_SimInjectFault(&dev.bus, SIM_FAULT_NACK, 1);
+	MPU6050_SimResetStats(&dev.bus);
+	CHECK_EQ(MPU6050_GetAllSensors(&dev.config, &accel, &rota, &temp), ERR_CONN_0);
+	CHECK_EQ(dev.bus.transactions, 1);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,83 @@
+// MPU6050_CalibAccel and MPU6050_CalibGyro cancel a known bias of the simulated device within
+// the tolerance, in one correction step: two averaged measurements and one offset write
+#include <math.h>
+#include "MPU6050_TEST.h"
+
+#define TOLERANCE		0.005f
+#define NOISE_LSB		4
+
+// Offset read, then two measurements of one discarded and NUM_CALIB_READINGS bursts
+#define ACCEL_CALIB_READS	(1 + 2 * (ACCEL_NUM_CALIB_READINGS + 1))
+#define GYRO_CALIB_READS	(1 + 2 * (GYRO_NUM_CALIB_READINGS + 1))
+
+static const float accelBiasG[3] = {0.05f, -0.03f, 0.04f};
+static const float gyroBiasDps[3] = {3.0f, -2.0f, 1.5f};
+
+// Offset register value within the tolerance of the one cancelling bias
+static void CheckOffset(int16_t offset, float bias, float offsetLsbSen, float toleranceLsb) {
+	float expected = -bias * offsetLsbSen;
+
+	if(fabsf((float)offset - expected) > toleranceLsb + 1.0f){
+		fprintf(stderr, "offset %d, expected %.1f\n", offset, expected);
+		CHECK(FALSE);
+	}
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_AccelOffsets accelOff;
+	MPU6050_GyroOffsets gyroOff;
+	MPU6050_Accelerations accel;
+	MPU6050_Rotations rota;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	dev.config.accelConfig = ACCEL_CONFIG_SCALE_1;
+	dev.config.gyroConfig = GYRO_CONFIG_SCALE_1;
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	for(uint8_t axis = 0; axis < 3; axis++){
+		dev.sim.accelG[axis] = accelBiasG[axis];
+		dev.sim.gyroDps[axis] = gyroBiasDps[axis];
+	}
+	dev.sim.accelG[2] += 1.0f;
+	dev.sim.noiseLsb = NOISE_LSB;
+	MPU6050_SimAdvance(&dev.bus, 2000000);
+
+	MPU6050_SimResetStats(&dev.bus);
+	CHECK_EQ(MPU6050_CalibAccel(&dev.config, TOLERANCE, GRAVITY_AXIS_Z_POS), CALIB_OK);
+	CHECK_EQ(dev.bus.reads, ACCEL_CALIB_READS);
+	CHECK_EQ(dev.bus.writes, 1);
+
+	MPU6050_SimResetStats(&dev.bus);
+	CHECK_EQ(MPU6050_CalibGyro(&dev.config, TOLERANCE), CALIB_OK);
+	CHECK_EQ(dev.bus.reads, GYRO_CALIB_READS);
+	CHECK_EQ(dev.bus.writes, 1);
+
+	// Offsets in their fixed format whatever the full scale, bit 0 of the accelerometer kept
+	CHECK_EQ(MPU6050_GetAccelOffset(&dev.config, &accelOff), CONN_OK);
+	CHECK_EQ(MPU6050_GetGyroOffset(&dev.config, &gyroOff), CONN_OK);
+	CheckOffset(accelOff.xOffset, accelBiasG[0], ACCEL_OFFSET_LSB_SEN, TOLERANCE * ACCEL_OFFSET_LSB_SEN);
+	CheckOffset(accelOff.yOffset, accelBiasG[1], ACCEL_OFFSET_LSB_SEN, TOLERANCE * ACCEL_OFFSET_LSB_SEN);
+	CheckOffset(accelOff.zOffset, accelBiasG[2], ACCEL_OFFSET_LSB_SEN, TOLERANCE * ACCEL_OFFSET_LSB_SEN);
+	CheckOffset(gyroOff.xOffset, gyroBiasDps[0], GYRO_OFFSET_LSB_SEN, TOLERANCE * 125 * GYRO_OFFSET_LSB_SEN);
+	CheckOffset(gyroOff.yOffset, gyroBiasDps[1], GYRO_OFFSET_LSB_SEN, TOLERANCE * 125 * GYRO_OFFSET_LSB_SEN);
+	CheckOffset(gyroOff.zOffset, gyroBiasDps[2], GYRO_OFFSET_LSB_SEN, TOLERANCE * 125 * GYRO_OFFSET_LSB_SEN);
+	CHECK_EQ(accelOff.xOffset & 1, 0);
+	CHECK_EQ(accelOff.yOffset & 1, 0);
+	CHECK_EQ(accelOff.zOffset & 1, 0);
+
+	// The corrected output reads 1g on Z and no rotation
+	dev.sim.noiseLsb = 0;
+	MPU6050_SimAdvance(&dev.bus, 2000000);
+	CHECK_EQ(MPU6050_GetAllSensors(&dev.config, &accel, &rota, NULL), CONN_OK);
+	CHECK(fabsf(accel.convertedAccelX) < TOLERANCE * GRAVITY_ACCEL);
+	CHECK(fabsf(accel.convertedAccelY) < TOLERANCE * GRAVITY_ACCEL);
+	CHECK(fabsf(accel.convertedAccelZ - GRAVITY_ACCEL) < TOLERANCE * GRAVITY_ACCEL);
+	CHECK(fabsf(rota.convertedRotaX) < TOLERANCE * 125);
+	CHECK(fabsf(rota.convertedRotaY) < TOLERANCE * 125);
+	CHECK(fabsf(rota.convertedRotaZ) < TOLERANCE * 125);
+
+	CHECK_EQ(MPU6050_CalibAccel(&dev.config, 0.0f, GRAVITY_AXIS_Z_POS), ERR_CALIB_INVALID_TOLERANCE);
+	CHECK_EQ(MPU6050_CalibAccel(&dev.config, TOLERANCE, GRAVITY_AXIS_Z_NEG + 1), ERR_CALIB_INVALID_AXIS);
+
+	return TEST_RESULT();
+}
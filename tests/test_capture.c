@@ -0,0 +1,183 @@
+// A capture decodes to the frames written, a corrupted block is skipped without losing the
+// blocks after it, and a replay through the library returns the recorded samples bit for bit
+#include "MPU6050_CAPTURE.h"
+#include "MPU6050_TEST.h"
+
+#define FRAMES			3000
+#define BLOCK_SIZE		256
+#define MAX_BLOCKS		(FRAMES * MPU6050_CAPTURE_MAX_FRAME_LEN / (BLOCK_SIZE - MPU6050_CAPTURE_BLOCK_HEADER_LEN - MPU6050_CAPTURE_MAX_FRAME_LEN) + 1)
+#define FILE_SIZE		(MPU6050_CAPTURE_HEADER_LEN + MAX_BLOCKS * BLOCK_SIZE)
+
+// File in memory, with the offset of every block
+typedef struct {
+	uint8_t data[FILE_SIZE];
+	size_t size;
+	size_t blockOffset[MAX_BLOCKS];
+	uint16_t blocks;
+} CaptureFile;
+
+static CaptureFile file, corrupted;
+static MPU6050_CaptureFrame frames[FRAMES];
+static MPU6050_CaptureReplay replay;
+
+static uint8_t MemorySink(void *context, const uint8_t *data, uint16_t len) {
+	CaptureFile *f = (CaptureFile *)context;
+
+	if(f->size + len > sizeof(f->data)){
+		return FALSE;
+	}
+	if(f->size > 0){
+		f->blockOffset[f->blocks++] = f->size;
+	}
+	memcpy(&f->data[f->size], data, len);
+	f->size += len;
+
+	return TRUE;
+}
+
+static uint32_t ReplayClock(void) {
+	return MPU6050_CaptureReplayNextTimestampUs(&replay);
+}
+
+// Small changes most of the time, full-scale jumps and jittered sample times now and then
+static void MakeFrames(void) {
+	uint32_t seed = 12345;
+	uint32_t timestampUs = 0xFFFF0000u;			// Wraps around during the capture
+
+	for(uint32_t n = 0; n < FRAMES; n++){
+		for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+			seed = seed * 1103515245u + 12345u;
+			int16_t prev = (n > 0) ? frames[n - 1].raw[i] : 0;
+			frames[n].raw[i] = (0 == n % 97) ? (int16_t)(seed >> 16) : (int16_t)(prev + (int16_t)((seed >> 16) % 64) - 32);
+		}
+		timestampUs += 1000 + ((0 == n % 50) ? (seed >> 20) % 500 : 0);
+		frames[n].timestampUs = timestampUs;
+	}
+}
+
+static void CheckFrame(const MPU6050_CaptureFrame *actual, const MPU6050_CaptureFrame *expected) {
+	CHECK(0 == memcmp(actual->raw, expected->raw, sizeof(actual->raw)));
+	CHECK_EQ(actual->timestampUs, expected->timestampUs);
+}
+
+static void CheckRoundTrip(MPU6050_ConfigTypeDef *config) {
+	static uint8_t buffer[2 * BLOCK_SIZE];
+	MPU6050_CaptureWriter writer;
+	MPU6050_CaptureReader reader;
+	MPU6050_CaptureFrame frame;
+
+	CHECK_EQ(MPU6050_CaptureWriterInit(&writer, buffer, sizeof(buffer), MemorySink, &file), CAPTURE_OK);
+	CHECK_EQ(MPU6050_CaptureBegin(&writer, config, MPU6050_CAPTURE_ALL), CAPTURE_OK);
+	for(uint32_t n = 0; n < FRAMES; n++){
+		CHECK_EQ(MPU6050_CaptureWriteRaw(&writer, frames[n].raw, frames[n].timestampUs), CAPTURE_OK);
+	}
+	CHECK_EQ(MPU6050_CaptureFlush(&writer), CAPTURE_OK);
+	CHECK_EQ(writer.frames, FRAMES);
+	CHECK_EQ(writer.bytes, file.size);
+	CHECK_EQ(writer.droppedBlocks, 0);
+	CHECK(file.blocks > 3);
+	printf("%u frames in %u blocks, %.2f bytes per frame\n", FRAMES, file.blocks, (double)file.size / FRAMES);
+
+	CHECK_EQ(MPU6050_CaptureReaderInit(&reader, file.data, file.size), CAPTURE_OK);
+	CHECK_EQ(reader.header.channels, MPU6050_CAPTURE_ALL);
+	CHECK_EQ(reader.header.samplePeriodUs, MPU6050_GetSamplePeriodUs(config));
+	for(uint32_t n = 0; n < FRAMES; n++){
+		CHECK_EQ(MPU6050_CaptureReadFrame(&reader, &frame), CAPTURE_OK);
+		CheckFrame(&frame, &frames[n]);
+	}
+	CHECK_EQ(MPU6050_CaptureReadFrame(&reader, &frame), ERR_CAPTURE_END);
+	CHECK_EQ(reader.frames, FRAMES);
+	CHECK_EQ(reader.corruptBlocks, 0);
+}
+
+// One flipped payload byte in the third block: its frames are lost, the reader resynchronizes
+static void CheckCorruptedBlock(void) {
+	MPU6050_CaptureReader reader;
+	MPU6050_CaptureFrame frame;
+	size_t offset = file.blockOffset[2];
+	uint32_t first = 0;
+
+	corrupted = file;
+	corrupted.data[offset + MPU6050_CAPTURE_BLOCK_HEADER_LEN + 5] ^= 0x10;
+	for(uint16_t b = 0; b < 2; b++){
+		first += (uint16_t)(file.data[file.blockOffset[b] + 4] | (file.data[file.blockOffset[b] + 5] << 8));
+	}
+	uint32_t lost = (uint16_t)(file.data[offset + 4] | (file.data[offset + 5] << 8));
+
+	CHECK_EQ(MPU6050_CaptureReaderInit(&reader, corrupted.data, corrupted.size), CAPTURE_OK);
+	for(uint32_t n = 0; n < FRAMES; n++){
+		if(n >= first && n < first + lost){
+			continue;
+		}
+		CHECK_EQ(MPU6050_CaptureReadFrame(&reader, &frame), CAPTURE_OK);
+		CheckFrame(&frame, &frames[n]);
+	}
+	CHECK_EQ(MPU6050_CaptureReadFrame(&reader, &frame), ERR_CAPTURE_END);
+	CHECK_EQ(reader.frames, FRAMES - lost);
+	CHECK_EQ(reader.corruptBlocks, 1);
+}
+
+// Samples of the simulator recorded with their conversions, then replayed through the library
+static void CheckReplay(MPU6050_TestDevice *dev) {
+	static uint8_t buffer[2 * BLOCK_SIZE];
+	static MPU6050_Accelerations accel[FRAMES];
+	static MPU6050_Rotations rota[FRAMES];
+	static MPU6050_Temperature temp[FRAMES];
+	MPU6050_CaptureWriter writer;
+	MPU6050_ConfigTypeDef config;
+	I2C_HandleTypeDef hi2c;
+	MPU6050_Accelerations replayAccel;
+	MPU6050_Rotations replayRota;
+	MPU6050_Temperature replayTemp;
+
+	dev->sim.noiseLsb = 200;
+	dev->sim.accelG[2] = 1.0f;
+	dev->sim.gyroDps[0] = 30.0f;
+	memset(&file, 0, sizeof(file));
+	CHECK_EQ(MPU6050_CaptureWriterInit(&writer, buffer, sizeof(buffer), MemorySink, &file), CAPTURE_OK);
+	CHECK_EQ(MPU6050_CaptureBegin(&writer, &dev->config, MPU6050_CAPTURE_ALL), CAPTURE_OK);
+	for(uint32_t n = 0; n < FRAMES; n++){
+		MPU6050_SimAdvance(&dev->bus, 1000000);
+		CHECK_EQ(MPU6050_GetAllSensors(&dev->config, &accel[n], &rota[n], &temp[n]), CONN_OK);
+		CHECK_EQ(MPU6050_CaptureWriteSample(&writer, &accel[n], &rota[n], &temp[n]), CAPTURE_OK);
+	}
+	CHECK_EQ(MPU6050_CaptureFlush(&writer), CAPTURE_OK);
+
+	memset(&config, 0, sizeof(config));
+	memset(&hi2c, 0, sizeof(hi2c));
+	hi2c.fd = -1;
+	hi2c.context = &replay;
+	CHECK_EQ(MPU6050_CaptureReplayInit(&replay, file.data, file.size), CAPTURE_OK);
+	config.hi2c = &hi2c;
+	config.transport = &MPU6050_CaptureReplayTransport;
+	config.clock = ReplayClock;
+	MPU6050_CaptureApplyHeader(&replay.reader.header, &config);
+	CHECK_EQ(config.address, dev->config.address);
+
+	for(uint32_t n = 0; n < FRAMES; n++){
+		CHECK_EQ(MPU6050_GetAllSensors(&config, &replayAccel, &replayRota, &replayTemp), CONN_OK);
+		CHECK_EQ(replayAccel.rawAccelX, accel[n].rawAccelX);
+		CHECK_EQ(replayAccel.rawAccelZ, accel[n].rawAccelZ);
+		CHECK_EQ(replayRota.rawRotaX, rota[n].rawRotaX);
+		CHECK_EQ(replayTemp.rawTemp, temp[n].rawTemp);
+		CHECK(replayAccel.convertedAccelZ == accel[n].convertedAccelZ);
+		CHECK(replayRota.convertedRotaX == rota[n].convertedRotaX);
+		CHECK(replayTemp.convertedTemp == temp[n].convertedTemp);
+		CHECK_EQ(replayAccel.timestampUs, accel[n].timestampUs);
+	}
+	CHECK(CONN_OK != MPU6050_GetAllSensors(&config, &replayAccel, &replayRota, &replayTemp));
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+
+	MakeFrames();
+	CheckRoundTrip(&dev.config);
+	CheckCorruptedBlock();
+	CheckReplay(&dev);
+
+	return TEST_RESULT();
+}
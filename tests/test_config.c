@@ -0,0 +1,148 @@
+// The setters and MPU6050_ApplyProfile write only the registers that change, one burst per
+// contiguous run of REG_SMPLRT_DIV..REG_ACCEL_CONFIG and REG_PWR_MGMT_1..2, and read nothing back.
+// The offset setters write one 6-byte burst, read back as one burst unless built with
+// MPU6050_OFFSET_VERIFY=FALSE
+#include "MPU6050_TEST.h"
+
+// Simulator transport whose reads of REG_YA_OFFS_USRL return a wrong value
+static HAL_StatusTypeDef BadOffsetRead(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	HAL_StatusTypeDef status = MPU6050_SimTransport.read(hi2c, address, reg, data, len);
+
+	if(reg <= REG_YA_OFFS_USRL && reg + len > REG_YA_OFFS_USRL){
+		data[REG_YA_OFFS_USRL - reg] ^= 0x10;
+	}
+	return status;
+}
+
+// Write transactions and data bytes of the last call
+static void CheckWrites(MPU6050_TestDevice *dev, uint32_t writes, uint32_t bytes) {
+	CHECK_EQ(dev->bus.reads, 0);
+	CHECK_EQ(dev->bus.writes, writes);
+	CHECK_EQ(dev->bus.bytesWritten, bytes);
+	MPU6050_SimResetStats(&dev->bus);
+}
+
+// The device, the shadow copy and the profile agree
+static void CheckProfile(MPU6050_TestDevice *dev, const MPU6050_Profile *profile) {
+	CHECK_EQ(dev->sim.regs[REG_SMPLRT_DIV], profile->smplRateDivConfig);
+	CHECK_EQ(dev->sim.regs[REG_CONFIG], profile->dlpfFsyncConfig);
+	CHECK_EQ(dev->sim.regs[REG_GYRO_CONFIG], profile->gyroConfig);
+	CHECK_EQ(dev->sim.regs[REG_ACCEL_CONFIG], profile->accelConfig);
+	CHECK_EQ(dev->sim.regs[REG_PWR_MGMT_1], profile->pwrMgmt1Config);
+	CHECK_EQ(dev->sim.regs[REG_PWR_MGMT_2], profile->pwrMgmt2Config);
+	CHECK_EQ(dev->config.smplRateDivConfig, profile->smplRateDivConfig);
+	CHECK_EQ(dev->config.dlpfFsyncConfig, profile->dlpfFsyncConfig);
+	CHECK_EQ(dev->config.gyroConfig, profile->gyroConfig);
+	CHECK_EQ(dev->config.accelConfig, profile->accelConfig);
+	CHECK_EQ(dev->config.pwrMgmt1Config, profile->pwrMgmt1Config);
+	CHECK_EQ(dev->config.pwrMgmt2Config, profile->pwrMgmt2Config);
+}
+
+static void CheckOffsets(MPU6050_TestDevice *dev) {
+	MPU6050_AccelOffsets accelOff = {-1200, 350, 2048};
+	MPU6050_GyroOffsets gyroOff = {17, -42, 1000};
+	MPU6050_Transport badTransport = MPU6050_SimTransport;
+	uint32_t verifyReads = MPU6050_OFFSET_VERIFY ? 1 : 0;
+
+	// One write of the 6 bytes, one read of the 6 bytes when verified
+	MPU6050_SimResetStats(&dev->bus);
+	CHECK_EQ(MPU6050_SetAccelOffset(&dev->config, &accelOff), WRITE_OK);
+	CHECK_EQ(dev->bus.writes, 1);
+	CHECK_EQ(dev->bus.bytesWritten, 6);
+	CHECK_EQ(dev->bus.reads, verifyReads);
+	CHECK_EQ(dev->bus.bytesRead, 6 * verifyReads);
+	CHECK_EQ(MPU6050_BYTES_TO_INT16(dev->sim.regs[REG_XA_OFFS_USRH], dev->sim.regs[REG_XA_OFFS_USRH + 1]), -1200);
+	CHECK_EQ(MPU6050_BYTES_TO_INT16(dev->sim.regs[REG_XA_OFFS_USRH + 4], dev->sim.regs[REG_XA_OFFS_USRH + 5]), 2048);
+
+	MPU6050_SimResetStats(&dev->bus);
+	CHECK_EQ(MPU6050_SetGyroOffset(&dev->config, &gyroOff), WRITE_OK);
+	CHECK_EQ(dev->bus.writes, 1);
+	CHECK_EQ(dev->bus.bytesWritten, 6);
+	CHECK_EQ(dev->bus.reads, verifyReads);
+	CHECK_EQ(MPU6050_BYTES_TO_INT16(dev->sim.regs[REG_XG_OFFS_USRH + 2], dev->sim.regs[REG_XG_OFFS_USRH + 3]), -42);
+
+	// The getters read the block back in one burst
+	memset(&accelOff, 0, sizeof(accelOff));
+	MPU6050_SimResetStats(&dev->bus);
+	CHECK_EQ(MPU6050_GetAccelOffset(&dev->config, &accelOff), CONN_OK);
+	CHECK_EQ(dev->bus.reads, 1);
+	CHECK_EQ(dev->bus.bytesRead, 6);
+	CHECK_EQ(accelOff.yOffset, 350);
+
+	// The first byte read back wrong is reported, the write failing is reported as such
+	badTransport.read = BadOffsetRead;
+	dev->config.transport = &badTransport;
+	CHECK_EQ(MPU6050_SetAccelOffset(&dev->config, &accelOff), MPU6050_OFFSET_VERIFY ? ERR_WRITE_OFF_Y_L : WRITE_OK);
+	dev->config.transport = &MPU6050_SimTransport;
+	MPU6050_SimInjectFault(&dev->bus, SIM_FAULT_NACK, 1);
+	CHECK_EQ(MPU6050_SetGyroOffset(&dev->config, &gyroOff), ERR_WRITE_CONN);
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_Profile fast, slow, current;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	MPU6050_SaveProfile(&dev.config, &fast, "fast");
+	CheckProfile(&dev, &fast);
+	MPU6050_SimResetStats(&dev.bus);
+
+	// One register, one byte. The same value again writes nothing
+	CHECK_EQ(MPU6050_SetAccelScale(&dev.config, ACCEL_CONFIG_SCALE_2), CONFIG_OK);
+	CheckWrites(&dev, 1, 1);
+	CHECK_EQ(dev.sim.regs[REG_ACCEL_CONFIG], ACCEL_CONFIG_SCALE_2);
+	CHECK_EQ(MPU6050_SetAccelScale(&dev.config, ACCEL_CONFIG_SCALE_2), CONFIG_OK);
+	CheckWrites(&dev, 0, 0);
+	CHECK_EQ(MPU6050_SetGyroScale(&dev.config, GYRO_CONFIG_SCALE_3), CONFIG_OK);
+	CheckWrites(&dev, 1, 1);
+	CHECK_EQ(MPU6050_SetDlpf(&dev.config, DLPF_CONFIG_6), CONFIG_OK);
+	CheckWrites(&dev, 1, 1);
+	CHECK_EQ(MPU6050_SetSampleRateDiv(&dev.config, 9), CONFIG_OK);
+	CheckWrites(&dev, 1, 1);
+	CHECK_EQ(MPU6050_SetClockSource(&dev.config, CLKSEL_CONFIG_3), CONFIG_OK);
+	CheckWrites(&dev, 1, 1);
+	CHECK_EQ(MPU6050_SetStandby(&dev.config, STBY_XG_CONFIG_SET | STBY_YG_CONFIG_SET), CONFIG_OK);
+	CheckWrites(&dev, 1, 1);
+	MPU6050_SaveProfile(&dev.config, &slow, "slow");
+	CheckProfile(&dev, &slow);
+
+	// Other bits of the register are kept, a value outside the field is refused before any transfer
+	CHECK_EQ(MPU6050_SetDlpf(&dev.config, 0x08), ERR_CONFIG_INVALID);
+	CHECK_EQ(dev.bus.transactions, 0);
+	CHECK_EQ(MPU6050_SetSampleRateDiv(&dev.config, 9), CONFIG_OK);
+	CheckWrites(&dev, 0, 0);
+
+	// Both runs changed: one burst each, whole runs as their ends changed
+	CHECK_EQ(MPU6050_ApplyProfile(&dev.config, &fast), CONFIG_OK);
+	CheckWrites(&dev, 2, 4 + 2);
+	CheckProfile(&dev, &fast);
+	CHECK_EQ(MPU6050_ApplyProfile(&dev.config, &fast), CONFIG_OK);
+	CheckWrites(&dev, 0, 0);
+
+	// SMPLRT_DIV and ACCEL_CONFIG: one burst of four, the two registers between them rewritten
+	current = fast;
+	current.smplRateDivConfig = 4;
+	current.accelConfig = ACCEL_CONFIG_SCALE_1;
+	CHECK_EQ(MPU6050_ApplyProfile(&dev.config, &current), CONFIG_OK);
+	CheckWrites(&dev, 1, 4);
+	CheckProfile(&dev, &current);
+
+	// Only PWR_MGMT_2: one byte
+	current.pwrMgmt2Config = STBY_ZA_CONFIG_SET;
+	CHECK_EQ(MPU6050_ApplyProfile(&dev.config, &current), CONFIG_OK);
+	CheckWrites(&dev, 1, 1);
+	CheckProfile(&dev, &current);
+
+	// Refused in cycle mode, where the device holds other power and accelerometer values
+	CHECK_EQ(MPU6050_EnterCycleMode(&dev.config, LP_WAKE_CTRL_CONFIG_1, 0), POWER_OK);
+	MPU6050_SimResetStats(&dev.bus);
+	CHECK_EQ(MPU6050_ApplyProfile(&dev.config, &slow), ERR_CONFIG_CYCLE_MODE);
+	CHECK_EQ(MPU6050_SetAccelScale(&dev.config, ACCEL_CONFIG_SCALE_0), ERR_CONFIG_CYCLE_MODE);
+	CHECK_EQ(dev.bus.transactions, 0);
+	CHECK_EQ(MPU6050_ExitCycleMode(&dev.config), POWER_OK);
+
+	CheckOffsets(&dev);
+
+	return TEST_RESULT();
+}
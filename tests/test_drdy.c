@@ -0,0 +1,87 @@
+// Data-ready acquisition with the INT pin latched: every read releases DATA_RDY, and the missed
+// and duplicate counters follow the interrupts, the reads and the consumer calls
+#include "MPU6050_TEST.h"
+
+static MPU6050_DataReady drdy;
+static uint8_t startReg, *startData;
+static uint16_t startLen;
+static uint8_t failStarts;
+
+// Plays a DMA read: recorded at the start, transferred by Complete
+static uint8_t TestStartRead(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len) {
+	(void)config;
+	if(failStarts){
+		failStarts--;
+		return ERR_ASYNC_CONN;
+	}
+	startReg = reg;
+	startData = data;
+	startLen = len;
+	return ASYNC_OK;
+}
+
+static void Complete(MPU6050_TestDevice *dev) {
+	HAL_StatusTypeDef status = MPU6050_SimTransport.read(&dev->hi2c, dev->config.address, startReg, startData, startLen);
+	MPU6050_DataReadyComplete(&drdy, HAL_OK == status);
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_AsyncReader reader;
+	MPU6050_Accelerations accel;
+	uint64_t periodNs;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	dev.sim.accelG[0] = 0.5f;
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	CHECK_EQ(MPU6050_ConfigInterrupts(&dev.config, LATCH_INT_EN_CONFIG_SET, DATA_RDY_EN_CONFIG_SET), INT_OK);
+	MPU6050_AsyncInit(&reader, &dev.config, TestStartRead, NULL, NULL);
+	CHECK_EQ(MPU6050_DataReadyInit(&drdy, &reader), INT_OK);
+	periodNs = 1000000000ull / MPU6050_SimSampleRateHz(&dev.sim);
+
+	// Nothing read yet
+	CHECK_EQ(MPU6050_DataReadyGetSample(&drdy, &accel, NULL, NULL), ERR_INT_NO_NEW_SAMPLE);
+	CHECK_EQ(drdy.duplicateSamples, 1);
+
+	// One interrupt, one read from INT_STATUS that releases the latched pin
+	MPU6050_SimAdvance(&dev.bus, periodNs);
+	CHECK(dev.sim.regs[REG_INT_STATUS] & DATA_RDY_INT_FLAG);
+	MPU6050_DataReadyIRQHandler(&drdy);
+	CHECK_EQ(reader.busy, TRUE);
+	CHECK_EQ(startReg, REG_INT_STATUS);
+	CHECK_EQ(startLen, MPU6050_INT_BURST_LEN);
+	Complete(&dev);
+	CHECK_EQ(dev.sim.regs[REG_INT_STATUS] & DATA_RDY_INT_FLAG, 0);
+	CHECK(reader.intStatus & DATA_RDY_INT_FLAG);
+	CHECK_EQ(MPU6050_DataReadyGetSample(&drdy, &accel, NULL, NULL), INT_OK);
+	CHECK_EQ(accel.rawAccelX, ACCEL_LSB_SEN_0 / 2);
+	CHECK_EQ(MPU6050_DataReadyGetSample(&drdy, &accel, NULL, NULL), ERR_INT_NO_NEW_SAMPLE);
+	CHECK_EQ(drdy.duplicateSamples, 2);
+	CHECK_EQ(drdy.missedSamples, 0);
+
+	// Three interrupts during one read: one is queued, one is missed
+	MPU6050_DataReadyIRQHandler(&drdy);
+	MPU6050_DataReadyIRQHandler(&drdy);
+	MPU6050_DataReadyIRQHandler(&drdy);
+	CHECK_EQ(drdy.pending, TRUE);
+	CHECK_EQ(drdy.missedSamples, 1);
+	Complete(&dev);
+	CHECK_EQ(reader.busy, TRUE);
+	CHECK_EQ(drdy.pending, FALSE);
+	Complete(&dev);
+	CHECK_EQ(reader.busy, FALSE);
+
+	// Two samples published since the last consumer call, only the newer one is delivered
+	CHECK_EQ(MPU6050_DataReadyGetSample(&drdy, &accel, NULL, NULL), INT_OK);
+	CHECK_EQ(drdy.missedSamples, 2);
+	CHECK_EQ(drdy.duplicateSamples, 2);
+
+	// A read that fails to start loses its sample
+	failStarts = 1;
+	MPU6050_DataReadyIRQHandler(&drdy);
+	CHECK_EQ(reader.busy, FALSE);
+	CHECK_EQ(drdy.missedSamples, 3);
+	CHECK_EQ(drdy.dataReadyCount, 5);
+
+	return TEST_RESULT();
+}
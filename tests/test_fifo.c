@@ -0,0 +1,175 @@
+// MPU6050_FifoDrain against the simulated FIFO: partial frames, ring wrap-around, overflow recovery
+// and the sample times reconstructed with a drifting sensor oscillator
+#include "MPU6050_TEST.h"
+
+#define FRAME_LEN		12		// Accelerometer and gyroscope
+#define SEQUENCE_MOD	20000
+#define TS_DRAINS		600		// About 4 s at 1 kHz
+#define TS_WARMUP		100		// Drains before the period estimate has settled
+#define TS_MAX_ERROR_US	500		// Half a period
+
+static MPU6050_SimBus *clockBus;
+static uint64_t sampleTimeNs[SEQUENCE_MOD];
+
+// Host clock in step with the simulated bus
+static uint32_t SimClockUs(void) {
+	return (uint32_t)(clockBus->timeNs / 1000);
+}
+
+// Accelerometer X carries the sample number, so lost or repeated frames are visible. The true
+// sample time is kept for the timestamp checks
+static void SequenceSignal(MPU6050_Sim *sim, uint64_t timeNs, float accelG[3], float gyroDps[3], float *tempC) {
+	uint32_t *sequence = sim->context;
+	(void)gyroDps; (void)tempC;
+
+	sampleTimeNs[*sequence % SEQUENCE_MOD] = timeNs;
+	accelG[0] = (float)(*sequence % SEQUENCE_MOD) / ACCEL_LSB_SEN_0;
+	(*sequence)++;
+}
+
+// Pops every sample and checks they follow *expected
+static uint16_t PopInOrder(MPU6050_FifoRing *ring, uint32_t *expected) {
+	MPU6050_FifoSample sample;
+	uint16_t popped = 0;
+
+	while(FIFO_OK == MPU6050_FifoPop(ring, &sample)){
+		CHECK_EQ(sample.accel.rawAccelX, *expected % SEQUENCE_MOD);
+		(*expected)++;
+		popped++;
+	}
+
+	return popped;
+}
+
+// Drains at irregular intervals with the sensor oscillator off by ppm. Once the period estimate has
+// settled, every reconstructed sample time stays within half a period of the true one
+static void CheckTimestamps(int32_t ppm) {
+	MPU6050_TestDevice dev;
+	MPU6050_FifoSample storage[64];
+	MPU6050_FifoSample sample;
+	MPU6050_FifoRing ring;
+	uint32_t sequence = 0;
+	uint32_t maxErrorUs = 0;
+	uint32_t checked = 0;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	dev.sim.signal = SequenceSignal;
+	dev.sim.context = &sequence;
+	dev.sim.clockErrorPpm = ppm;
+	clockBus = &dev.bus;
+	dev.config.clock = SimClockUs;
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	MPU6050_FifoRingInit(&ring, storage, 64);
+	CHECK_EQ(MPU6050_FifoEnable(&dev.config, ACCEL_FIFO_EN_CONFIG_SET | XG_FIFO_EN_CONFIG_SET | YG_FIFO_EN_CONFIG_SET | ZG_FIFO_EN_CONFIG_SET), FIFO_OK);
+
+	for(uint32_t i = 0; i < TS_DRAINS; i++){
+		// 4.3 to 9.7 ms, not a multiple of the sample period
+		MPU6050_SimAdvance(&dev.bus, 4300000 + (uint64_t)(i * 7919 % 5400) * 1000);
+		CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+
+		while(FIFO_OK == MPU6050_FifoPop(&ring, &sample)){
+			uint32_t trueUs = (uint32_t)(sampleTimeNs[(uint16_t)sample.accel.rawAccelX] / 1000);
+			uint32_t errorUs = (uint32_t)ABS((int32_t)(sample.accel.timestampUs - trueUs));
+
+			CHECK_EQ(sample.rota.timestampUs, sample.accel.timestampUs);
+			if(i >= TS_WARMUP){
+				maxErrorUs = (errorUs > maxErrorUs) ? errorUs : maxErrorUs;
+				checked++;
+			}
+		}
+	}
+
+	printf("clock error %+d ppm: %u samples, max timestamp error %u us\n", (int)ppm, (unsigned)checked, (unsigned)maxErrorUs);
+	CHECK(checked > 3000);
+	CHECK(maxErrorUs <= TS_MAX_ERROR_US);
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_FifoSample storage[8];
+	MPU6050_FifoRing ring;
+	uint32_t sequence = 0;
+	uint32_t expected;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	dev.sim.signal = SequenceSignal;
+	dev.sim.context = &sequence;
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	MPU6050_FifoRingInit(&ring, storage, 8);
+
+	CHECK_EQ(MPU6050_FifoEnable(&dev.config, ACCEL_FIFO_EN_CONFIG_SET | XG_FIFO_EN_CONFIG_SET | YG_FIFO_EN_CONFIG_SET | ZG_FIFO_EN_CONFIG_SET), FIFO_OK);
+	CHECK_EQ(MPU6050_GetFifoFrameSize(&dev.config), FRAME_LEN);
+	expected = sequence;
+
+	// Ring wrap-around: 3 to 7 frames per drain through an 8-sample ring, no frame lost or repeated
+	for(uint32_t i = 0; i < 200; i++){
+		MPU6050_SimAdvance(&dev.bus, (uint64_t)(3 + i % 5) * 1000000);
+		CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+		PopInOrder(&ring, &expected);
+	}
+	CHECK(expected > 1000);
+
+	// More frames than free slots: the rest stays in the sensor FIFO for the next drain
+	MPU6050_SimAdvance(&dev.bus, 20000000);
+	CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	CHECK_EQ(ring.count, 8);
+	CHECK(dev.sim.fifoCount >= 12 * FRAME_LEN);
+	for(uint32_t i = 0; i < 10; i++){
+		PopInOrder(&ring, &expected);
+		CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	}
+	PopInOrder(&ring, &expected);
+
+	// Partial frame: with sampling stopped, hide half of the newest frame from FIFO_COUNT.
+	// Only whole frames are read and the half frame is completed by the next drain
+	dev.sim.nextSampleNs = UINT64_MAX;
+	CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	PopInOrder(&ring, &expected);
+	dev.sim.nextSampleNs = dev.bus.timeNs;
+	MPU6050_SimAdvance(&dev.bus, 3000000);
+	dev.sim.nextSampleNs = UINT64_MAX;
+	uint16_t frames = dev.sim.fifoCount / FRAME_LEN;
+	CHECK(frames >= 2);
+	CHECK_EQ(dev.sim.fifoCount % FRAME_LEN, 0);
+	dev.sim.fifoCount -= FRAME_LEN / 2;
+	CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	CHECK_EQ(PopInOrder(&ring, &expected), frames - 1);
+	CHECK_EQ(dev.sim.fifoCount, FRAME_LEN / 2);
+	CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	CHECK_EQ(ring.count, 0);
+	dev.sim.fifoCount += FRAME_LEN / 2;
+	CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	CHECK_EQ(PopInOrder(&ring, &expected), 1);
+	dev.sim.nextSampleNs = dev.bus.timeNs;
+
+	// Overflow: 200 ms undrained is 2400 bytes, the FIFO is flushed and the stream restarts aligned
+	MPU6050_SimAdvance(&dev.bus, 200000000);
+	CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), ERR_FIFO_OVERFLOW);
+	CHECK_EQ(ring.overflows, 1);
+	CHECK_EQ(ring.count, 0);
+	CHECK_EQ(dev.sim.fifoCount % FRAME_LEN, 0);
+	CHECK(dev.sim.fifoCount < 4 * FRAME_LEN);
+
+	// Frames after the reset are contiguous again, starting at the first sample kept by the FIFO
+	MPU6050_SimAdvance(&dev.bus, 5000000);
+	CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	CHECK(ring.count > 0);
+	MPU6050_FifoSample first;
+	CHECK_EQ(MPU6050_FifoPop(&ring, &first), FIFO_OK);
+	expected = first.accel.rawAccelX + 1;
+	for(uint32_t i = 0; i < 50; i++){
+		PopInOrder(&ring, &expected);
+		MPU6050_SimAdvance(&dev.bus, 4000000);
+		CHECK_EQ(MPU6050_FifoDrain(&dev.config, &ring), FIFO_OK);
+	}
+	PopInOrder(&ring, &expected);
+	CHECK_EQ(sequence - expected, dev.sim.fifoCount / FRAME_LEN);
+	CHECK_EQ(ring.overflows, 1);
+
+	// Sample times with a slow, an exact and a fast oscillator (the drift limit is 1/16)
+	CheckTimestamps(-20000);
+	CheckTimestamps(0);
+	CheckTimestamps(30000);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,107 @@
+// The filter banks of MPU6050_BenchFilterRunAll pass the motion tone and reject the vibration
+// tone, and feeding a bank in small blocks gives the same output as one call, in the
+// conversion mode the test is built with
+#include <math.h>
+#include "MPU6050_BENCH.h"
+#include "MPU6050_TEST.h"
+
+#define MAX_PASS_ERROR_DB	0.1
+#define CHANNELS			6
+#define SAMPLES				5000
+#define DECIMATION			4
+#define TAPS				48
+
+static const double maxStopGainDb[MPU6050_BENCH_FILTER_CASES] = {-10.0, -20.0, -60.0, -60.0};
+
+static MPU6050_FilterData input[CHANNELS][SAMPLES];
+static MPU6050_FilterData once[CHANNELS][SAMPLES];
+static MPU6050_FilterData blocks[CHANNELS][SAMPLES];
+
+// Two tones and a step per channel, at about half of the full scale
+static void MakeInput(void) {
+	for(uint8_t ch = 0; ch < CHANNELS; ch++){
+		for(uint32_t i = 0; i < SAMPLES; i++){
+			double x = 0.3 * sin(2.0 * M_PI * 20.0 * i / 1000.0 + ch) + 0.2 * sin(2.0 * M_PI * 180.0 * i / 1000.0) + ((i > SAMPLES / 2) ? 0.1 : 0.0);
+#if MPU6050_CONVERSION == MPU6050_CONVERSION_FIXED
+			input[ch][i] = (int16_t)lrint(x * 32767.0);
+#else
+			input[ch][i] = (float)(x * 9.80665);
+#endif
+		}
+	}
+}
+
+static void InitBank(MPU6050_FilterBank *bank, MPU6050_Biquad *stages, float *taps) {
+	MPU6050_FilterConfig filterConfig = {.numChannels = CHANNELS, .decimation = DECIMATION, .numTaps = TAPS, .taps = taps};
+	uint8_t numStages = MPU6050_FilterDesignButterworth(stages, 4, 100.0f, 1000.0f);
+
+	MPU6050_FilterDesignNotch(&stages[numStages++], 180.0f, 1000.0f, 5.0f);
+	MPU6050_FilterDesignDecimator(taps, TAPS, DECIMATION);
+	for(uint8_t ch = 0; ch < CHANNELS; ch++){
+		filterConfig.axis[ch].numStages = numStages;
+		filterConfig.axis[ch].stages = stages;
+	}
+	CHECK_EQ(MPU6050_FilterInit(bank, &filterConfig), FILTER_OK);
+}
+
+// Block lengths around MPU6050_FILTER_BLOCK and the decimation, odd phases included
+static void CheckBlocks(void) {
+	static const uint32_t lengths[] = {1, 3, 31, 32, 33, 7, 73, 64, 2, 100};
+	MPU6050_Biquad stages[MPU6050_FILTER_MAX_STAGES];
+	float taps[TAPS];
+	MPU6050_FilterBank bank;
+	MPU6050_FilterData *data[CHANNELS];
+	uint32_t outOnce, outBlocks = 0;
+
+	InitBank(&bank, stages, taps);
+	memcpy(once, input, sizeof(input));
+	for(uint8_t ch = 0; ch < CHANNELS; ch++){
+		data[ch] = once[ch];
+	}
+	outOnce = MPU6050_FilterProcess(&bank, data, SAMPLES);
+	CHECK_EQ(outOnce, SAMPLES / DECIMATION);
+
+	MPU6050_FilterReset(&bank);
+	for(uint32_t offset = 0, l = 0; offset < SAMPLES; l++){
+		MPU6050_FilterData block[CHANNELS][100];
+		uint32_t len = lengths[l % (sizeof(lengths) / sizeof(lengths[0]))];
+
+		len = (len < SAMPLES - offset) ? len : SAMPLES - offset;
+		for(uint8_t ch = 0; ch < CHANNELS; ch++){
+			memcpy(block[ch], &input[ch][offset], len * sizeof(block[ch][0]));
+			data[ch] = block[ch];
+		}
+		uint32_t out = MPU6050_FilterProcess(&bank, data, len);
+		for(uint8_t ch = 0; ch < CHANNELS; ch++){
+			memcpy(&blocks[ch][outBlocks], block[ch], out * sizeof(block[ch][0]));
+		}
+		outBlocks += out;
+		offset += len;
+	}
+
+	CHECK_EQ(outBlocks, outOnce);
+	for(uint8_t ch = 0; ch < CHANNELS; ch++){
+		CHECK(0 == memcmp(once[ch], blocks[ch], outOnce * sizeof(once[ch][0])));
+	}
+}
+
+int main(void) {
+	static MPU6050_BenchFilterResult results[MPU6050_BENCH_FILTER_CASES];
+
+	CHECK_EQ(MPU6050_BenchFilterRunAll(results), MPU6050_BENCH_FILTER_CASES);
+	MPU6050_BenchWriteFilterJson(stdout, results, MPU6050_BENCH_FILTER_CASES);
+
+	for(uint8_t c = 0; c < MPU6050_BENCH_FILTER_CASES; c++){
+		CHECK_EQ(results[c].samples, MPU6050_BENCH_FILTER_SAMPLES);
+		CHECK(fabs(results[c].passGainDb) < MAX_PASS_ERROR_DB);
+		CHECK(results[c].stopGainDb < maxStopGainDb[c]);
+	}
+	// Every stage added rejects more of the vibration
+	CHECK(results[1].stopGainDb < results[0].stopGainDb);
+	CHECK(results[2].stopGainDb < results[1].stopGainDb);
+
+	MakeInput();
+	CheckBlocks();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,73 @@
+// Fixed-point conversion against the float conversion for every raw value and full-scale setting
+#include <math.h>
+#include "MPU6050_TEST.h"
+
+#if MPU6050_CONVERSION != MPU6050_CONVERSION_FIXED
+#error "test_fixed is built against the MPU6050_CONVERSION_FIXED library"
+#endif
+
+#define MAX_ERROR_UNITS		1.0		// mg, mdps (or mrad/s) and centi-ºC
+
+static const uint8_t accelRanges[4] = {ACCEL_CONFIG_SCALE_0, ACCEL_CONFIG_SCALE_1, ACCEL_CONFIG_SCALE_2, ACCEL_CONFIG_SCALE_3};
+static const uint8_t gyroRanges[4] = {GYRO_CONFIG_SCALE_0, GYRO_CONFIG_SCALE_1, GYRO_CONFIG_SCALE_2, GYRO_CONFIG_SCALE_3};
+static const float accelLsbSen[4] = {ACCEL_LSB_SEN_0, ACCEL_LSB_SEN_1, ACCEL_LSB_SEN_2, ACCEL_LSB_SEN_3};
+static const float gyroLsbSen[4] = {GYRO_LSB_SEN_0, GYRO_LSB_SEN_1, GYRO_LSB_SEN_2, GYRO_LSB_SEN_3};
+
+#if MPU6050_GYRO_UNITS == MPU6050_GYRO_RADS
+#define GYRO_UNIT_FACTOR	DEG_TO_RAD
+#else
+#define GYRO_UNIT_FACTOR	1.0f
+#endif
+
+static double maxAccelError, maxGyroError, maxTempError;
+
+static void CheckError(double *maxError, int32_t fixed, double reference) {
+	double error = fabs((double)fixed - reference);
+
+	if(error > *maxError){
+		*maxError = error;
+	}
+}
+
+int main(void) {
+	MPU6050_ConfigTypeDef config = {0};
+	MPU6050_Accelerations accel;
+	MPU6050_Rotations rota;
+	MPU6050_Temperature temp;
+
+	for(uint8_t a = 0; a < 4; a++){
+		for(uint8_t g = 0; g < 4; g++){
+			config.accelConfig = accelRanges[a];
+			config.gyroConfig = gyroRanges[g];
+
+			// The float library multiplies by these factors (m/s^2 and º/s or rad/s per LSB)
+			float accelScale = GRAVITY_ACCEL / accelLsbSen[a];
+			float gyroScale = GYRO_UNIT_FACTOR / gyroLsbSen[g];
+
+			for(int32_t raw = INT16_MIN; raw <= INT16_MAX; raw++){
+				accel.rawAccelX = accel.rawAccelY = accel.rawAccelZ = (int16_t)raw;
+				rota.rawRotaX = rota.rawRotaY = rota.rawRotaZ = (int16_t)raw;
+				MPU6050_ConvertSample(&config, &accel, &rota, NULL);
+
+				CHECK_EQ(accel.convertedAccelY, accel.convertedAccelX);
+				CHECK_EQ(rota.convertedRotaZ, rota.convertedRotaX);
+				CHECK_EQ(config.scaleValid, TRUE);
+				CheckError(&maxAccelError, accel.convertedAccelX, (double)MPU6050_RAW_TO_SCALED(raw, accelScale) * 1000.0 / GRAVITY_ACCEL);
+				CheckError(&maxGyroError, rota.convertedRotaX, (double)MPU6050_RAW_TO_SCALED(raw, gyroScale) * 1000.0);
+			}
+		}
+	}
+
+	for(int32_t raw = INT16_MIN; raw <= INT16_MAX; raw++){
+		temp.rawTemp = (int16_t)raw;
+		MPU6050_ConvertSample(&config, NULL, NULL, &temp);
+		CheckError(&maxTempError, temp.convertedTemp, (double)MPU6050_RAW_TO_TEMP(raw) * 100.0);
+	}
+
+	printf("max error against float: accel %.3f mg, gyro %.3f, temp %.3f centi-C\n", maxAccelError, maxGyroError, maxTempError);
+	CHECK(maxAccelError <= MAX_ERROR_UNITS);
+	CHECK(maxGyroError <= MAX_ERROR_UNITS);
+	CHECK(maxTempError <= MAX_ERROR_UNITS);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,22 @@
+// Every fusion filter tracks the simulated tumbling trace of MPU6050_BenchFusionRunAll within
+// the accuracy bounds below, in the conversion mode the test is built with
+#include "MPU6050_BENCH.h"
+#include "MPU6050_TEST.h"
+
+#define MAX_RMS_ERROR_DEG	0.2
+#define MAX_ERROR_DEG		0.5
+
+int main(void) {
+	static MPU6050_BenchFusionResult results[MPU6050_BENCH_FUSION_FILTERS];
+
+	CHECK_EQ(MPU6050_BenchFusionRunAll(results), MPU6050_BENCH_FUSION_FILTERS);
+	MPU6050_BenchWriteFusionJson(stdout, results, MPU6050_BENCH_FUSION_FILTERS);
+
+	for(uint8_t filter = 0; filter < MPU6050_BENCH_FUSION_FILTERS; filter++){
+		CHECK_EQ(results[filter].updates, MPU6050_BENCH_FUSION_SAMPLES);
+		CHECK(results[filter].rmsErrorDeg < MAX_RMS_ERROR_DEG);
+		CHECK(results[filter].maxErrorDeg < MAX_ERROR_DEG);
+	}
+
+	return TEST_RESULT();
+}
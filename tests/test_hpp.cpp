@@ -0,0 +1,87 @@
+// The C++17 front end accepts every valid sample rate and decodes like the C library. Built with
+// MPU6050_STATS, its reads also show in the stats and the connection health like the C reads
+#include "MPU6050.hpp"
+#include "MPU6050_TEST.h"
+
+// Bus calling the simulator directly
+struct SimBus {
+	static HAL_StatusTypeDef read(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+		return MPU6050_SimTransport.read(hi2c, address, reg, data, len);
+	}
+
+	static HAL_StatusTypeDef write(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+		return MPU6050_SimTransport.write(hi2c, address, reg, data, len);
+	}
+};
+
+// 8kHz: DLPF off and SMPLRT_DIV 0
+using Imu = mpu6050::Mpu6050<SimBus, MPU6050_ADDRESS_AD0_L, mpu6050::AccelScale::G4, mpu6050::GyroScale::Dps500, mpu6050::Dlpf::Hz260, 0>;
+static_assert(Imu::sampleRateHz == 8000, "8kHz with the DLPF off");
+static_assert(mpu6050::Mpu6050<SimBus, MPU6050_ADDRESS_AD0_L, mpu6050::AccelScale::G2, mpu6050::GyroScale::Dps250, mpu6050::Dlpf::Hz44, 4>::sampleRateHz == 200, "200Hz");
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_Accelerations accel = {}, accelC = {};
+	MPU6050_Rotations rota = {}, rotaC = {};
+	MPU6050_Temperature temp = {}, tempC = {};
+#if MPU6050_STATS
+	static MPU6050_Stats stats, statsC;
+#endif
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	dev.sim.accelG[0] = 0.5f;
+	dev.sim.accelG[2] = -1.0f;
+	dev.sim.gyroDps[1] = 123.0f;
+	dev.sim.tempC = 25.0f;
+
+	Imu imu(&dev.hi2c);
+	CHECK_EQ(imu.init(), INIT_OK);
+	CHECK_EQ(MPU6050_SimSampleRateHz(&dev.sim), 8000);
+	MPU6050_SimAdvance(&dev.bus, 5000000);
+
+	MPU6050_SimResetStats(&dev.bus);
+	CHECK_EQ(imu.getAllSensors(&accel, &rota, &temp), CONN_OK);
+	CHECK_EQ(dev.bus.transactions, 1);
+	CHECK_EQ(MPU6050_GetAllSensors(imu.config(), &accelC, &rotaC, &tempC), CONN_OK);
+
+	// Constant input without noise: the same sample, converted bit-exactly
+	CHECK_EQ(accel.rawAccelX, accelC.rawAccelX);
+	CHECK_EQ(accel.rawAccelZ, accelC.rawAccelZ);
+	CHECK_EQ(rota.rawRotaY, rotaC.rawRotaY);
+	CHECK(accel.convertedAccelX == accelC.convertedAccelX);
+	CHECK(accel.convertedAccelZ == accelC.convertedAccelZ);
+	CHECK(rota.convertedRotaY == rotaC.convertedRotaY);
+	CHECK(temp.convertedTemp == tempC.convertedTemp);
+
+#if MPU6050_STATS
+	// The same counters for one C++ and one C read, the connection check is not a separate call
+	MPU6050_StatsInit(imu.config(), &stats);
+	CHECK_EQ(imu.getAllSensors(&accel, &rota, &temp), CONN_OK);
+	MPU6050_StatsSnapshot(imu.config(), &stats, FALSE);
+	MPU6050_StatsInit(imu.config(), &statsC);
+	CHECK_EQ(MPU6050_GetAllSensors(imu.config(), &accelC, &rotaC, &tempC), CONN_OK);
+	CHECK_EQ(stats.transfers, 1);
+	CHECK_EQ(stats.transfers, statsC.transfers);
+	CHECK_EQ(stats.reads, statsC.reads);
+	CHECK_EQ(stats.bytesRead, statsC.bytesRead);
+	CHECK_EQ(stats.api[STATS_BUS].calls, statsC.api[STATS_BUS].calls);
+	CHECK_EQ(stats.api[STATS_GET_ALL].calls, 1);
+	CHECK_EQ(stats.api[STATS_CHECK_CONN].calls, 0);
+
+	// Failed C++ reads count as errors and lose the connection, the next one reconnects
+	MPU6050_StatsInit(imu.config(), &stats);
+	MPU6050_SimInjectFault(&dev.bus, SIM_FAULT_NACK, MPU6050_LOST_ERRORS);
+	for(uint8_t i = 0; i < MPU6050_LOST_ERRORS; i++){
+		CHECK_EQ(imu.getAllSensors(&accel, &rota, &temp), ERR_CONN_0);
+	}
+	CHECK_EQ(imu.config()->connState, CONN_STATE_LOST);
+	CHECK_EQ(stats.connLost, 1);
+	CHECK_EQ(stats.api[STATS_GET_ALL].errors, MPU6050_LOST_ERRORS);
+	CHECK_EQ(imu.getAllSensors(&accel, &rota, &temp), CONN_OK);
+	CHECK_EQ(imu.config()->connState, CONN_STATE_CONNECTED);
+	CHECK_EQ(stats.reconnects, 1);
+	CHECK_EQ(stats.api[STATS_GET_ALL].calls, MPU6050_LOST_ERRORS + 1);
+#endif
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,167 @@
+// The Linux transport over a fake I2C_RDWR ioctl: every register read is one write and one
+// read message, batched reads fill each ioctl up to the 42 messages of the kernel, writes
+// above 32 bytes are refused and errno maps to the HAL status
+#include <errno.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "MPU6050_TEST.h"
+
+#define MAX_CALLS		8
+#define NUM_BLOCKS		50
+
+// Fake device: auto-incremented register file, every ioctl recorded
+static uint8_t regs[256];
+static uint32_t calls;
+static uint32_t callMsgs[MAX_CALLS];
+static struct i2c_msg lastMsgs[I2C_RDWR_IOCTL_MAX_MSGS];
+static uint8_t badAddress;
+static uint32_t failCall;				// 1-based ioctl that fails, 0: none
+static int failErrno;
+
+static int FakeIoctl(int fd, unsigned long request, void *arg) {
+	struct i2c_rdwr_ioctl_data *transfer = (struct i2c_rdwr_ioctl_data *)arg;
+	uint8_t pointer = 0;
+	(void)fd;
+
+	if(request != I2C_RDWR || transfer->nmsgs > I2C_RDWR_IOCTL_MAX_MSGS){
+		errno = EINVAL;
+		return -1;
+	}
+	if(calls < MAX_CALLS){
+		callMsgs[calls] = transfer->nmsgs;
+	}
+	calls++;
+	if(calls == failCall){
+		errno = failErrno;
+		return -1;
+	}
+
+	memcpy(lastMsgs, transfer->msgs, transfer->nmsgs * sizeof(transfer->msgs[0]));
+	for(uint32_t m = 0; m < transfer->nmsgs; m++){
+		struct i2c_msg *msg = &transfer->msgs[m];
+
+		if(msg->addr != MPU6050_ADDRESS_AD0_L){
+			badAddress = TRUE;
+		}
+		if(msg->flags & I2C_M_RD){
+			for(uint16_t i = 0; i < msg->len; i++){
+				msg->buf[i] = regs[pointer++];
+			}
+		}
+		else{
+			pointer = msg->buf[0];
+			for(uint16_t i = 1; i < msg->len; i++){
+				regs[pointer++] = msg->buf[i];
+			}
+		}
+	}
+
+	return (int)transfer->nmsgs;
+}
+
+static void ResetCalls(void) {
+	calls = 0;
+	memset(callMsgs, 0, sizeof(callMsgs));
+}
+
+static void CheckReadBlocks(I2C_HandleTypeDef *hi2c, uint8_t numBlocks, uint32_t expectedCalls) {
+	static uint8_t data[NUM_BLOCKS][2];
+	MPU6050_RegBlock blocks[NUM_BLOCKS];
+
+	for(uint8_t b = 0; b < numBlocks; b++){
+		blocks[b] = (MPU6050_RegBlock){(uint8_t)(2 * b), data[b], sizeof(data[b])};
+	}
+	memset(data, 0, sizeof(data));
+	ResetCalls();
+	CHECK_EQ(MPU6050_DefaultTransport.readBlocks(hi2c, MPU6050_ADDRESS_AD0_L, blocks, numBlocks), HAL_OK);
+	CHECK_EQ(calls, expectedCalls);
+	for(uint32_t c = 0; c < expectedCalls; c++){
+		uint32_t left = 2u * numBlocks - c * MPU6050_LINUX_MAX_MSGS;
+		CHECK_EQ(callMsgs[c], (left < MPU6050_LINUX_MAX_MSGS) ? left : MPU6050_LINUX_MAX_MSGS);
+	}
+	for(uint8_t b = 0; b < numBlocks; b++){
+		CHECK_EQ(data[b][0], regs[2 * b]);
+		CHECK_EQ(data[b][1], regs[2 * b + 1]);
+	}
+}
+
+int main(void) {
+	I2C_HandleTypeDef hi2c = {.fd = -1, .context = NULL, .ioctlFn = FakeIoctl};
+	MPU6050_ConfigTypeDef config;
+	MPU6050_FifoSample samples[4];
+	MPU6050_FifoRing ring;
+	MPU6050_Accelerations accel;
+	uint8_t data[MPU6050_LINUX_MAX_WRITE + 1];
+
+	CHECK_EQ(MPU6050_LINUX_MAX_MSGS, I2C_RDWR_IOCTL_MAX_MSGS);
+	for(uint16_t r = 0; r < sizeof(regs); r++){
+		regs[r] = (uint8_t)(r * 7 + 1);
+	}
+	regs[REG_FIFO_COUNTH] = 0;
+	regs[REG_FIFO_COUNTL] = 0;
+	regs[REG_WHO_AM_I] = MPU6050_WHO_AM_I_VALUE;
+
+	// Library calls on the default transport
+	memset(&config, 0, sizeof(config));
+	config.hi2c = &hi2c;
+	config.address = MPU6050_ADDRESS_AD0_L;
+	ResetCalls();
+	CHECK_EQ(MPU6050_GetAllSensors(&config, &accel, NULL, NULL), CONN_OK);
+	CHECK_EQ(calls, 1);
+	CHECK_EQ(callMsgs[0], 2);
+	CHECK_EQ(lastMsgs[0].flags, 0);
+	CHECK_EQ(lastMsgs[0].len, 1);
+	CHECK_EQ(lastMsgs[1].flags, I2C_M_RD);
+	CHECK_EQ(lastMsgs[1].len, MPU6050_SENSORS_BURST_LEN);
+	CHECK_EQ(accel.rawAccelX, MPU6050_BYTES_TO_INT16(regs[REG_ACCEL_XOUT_H], regs[REG_ACCEL_XOUT_H + 1]));
+
+	// INT_STATUS and FIFO_COUNT of a drain share one ioctl
+	config.fifoEnConfig = ACCEL_FIFO_EN_CONFIG_SET;
+	MPU6050_FifoRingInit(&ring, samples, sizeof(samples) / sizeof(samples[0]));
+	regs[REG_INT_STATUS] = 0;
+	ResetCalls();
+	CHECK_EQ(MPU6050_FifoDrain(&config, &ring), FIFO_OK);
+	CHECK_EQ(calls, 1);
+	CHECK_EQ(callMsgs[0], 4);
+
+	// 21 blocks fill one ioctl exactly, the next ones start another
+	CheckReadBlocks(&hi2c, 1, 1);
+	CheckReadBlocks(&hi2c, MPU6050_LINUX_MAX_MSGS / 2, 1);
+	CheckReadBlocks(&hi2c, MPU6050_LINUX_MAX_MSGS / 2 + 1, 2);
+	CheckReadBlocks(&hi2c, NUM_BLOCKS, 3);
+
+	// Writes: register and data in one message, up to 32 data bytes
+	for(uint8_t i = 0; i < sizeof(data); i++){
+		data[i] = (uint8_t)(0xA0 + i);
+	}
+	ResetCalls();
+	CHECK_EQ(MPU6050_DefaultTransport.write(&hi2c, MPU6050_ADDRESS_AD0_L, 0x40, data, MPU6050_LINUX_MAX_WRITE), HAL_OK);
+	CHECK_EQ(calls, 1);
+	CHECK_EQ(callMsgs[0], 1);
+	CHECK_EQ(lastMsgs[0].len, MPU6050_LINUX_MAX_WRITE + 1);
+	CHECK(0 == memcmp(&regs[0x40], data, MPU6050_LINUX_MAX_WRITE));
+	CHECK_EQ(MPU6050_DefaultTransport.write(&hi2c, MPU6050_ADDRESS_AD0_L, 0x40, data, MPU6050_LINUX_MAX_WRITE + 1), HAL_ERROR);
+	CHECK_EQ(calls, 1);
+
+	// errno to HAL status, a batched read stops at the first failed ioctl
+	failErrno = ETIMEDOUT;
+	failCall = 1;
+	ResetCalls();
+	CHECK_EQ(MPU6050_DefaultTransport.read(&hi2c, MPU6050_ADDRESS_AD0_L, REG_WHO_AM_I, data, 1), HAL_TIMEOUT);
+	failErrno = EAGAIN;
+	ResetCalls();
+	CHECK_EQ(MPU6050_DefaultTransport.read(&hi2c, MPU6050_ADDRESS_AD0_L, REG_WHO_AM_I, data, 1), HAL_BUSY);
+	failErrno = EIO;
+	failCall = 2;
+	ResetCalls();
+	MPU6050_RegBlock blocks[NUM_BLOCKS];
+	for(uint8_t b = 0; b < NUM_BLOCKS; b++){
+		blocks[b] = (MPU6050_RegBlock){b, &data[0], 1};
+	}
+	CHECK_EQ(MPU6050_DefaultTransport.readBlocks(&hi2c, MPU6050_ADDRESS_AD0_L, blocks, NUM_BLOCKS), HAL_ERROR);
+	CHECK_EQ(calls, 2);
+
+	CHECK_EQ(badAddress, FALSE);
+
+	return TEST_RESULT();
+}
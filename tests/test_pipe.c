@@ -0,0 +1,189 @@
+// MPU6050_PipeRun gives the output of a sequential decode, bias removal, moving average and
+// conversion whatever the number of threads and the chunk size, in file order
+#include "MPU6050_PIPE.h"
+#include "MPU6050_TEST.h"
+
+#define FRAMES			200000
+#define AVERAGE_LEN		8
+#define MAX_THREADS		8
+
+typedef struct {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+} CaptureFile;
+
+// Ordered output of one run
+typedef struct {
+	uint32_t count;
+	uint32_t chunks;
+	uint32_t badFirstFrames;
+	MPU6050_Accelerations accel[FRAMES];
+	MPU6050_Rotations rota[FRAMES];
+	MPU6050_Temperature temp[FRAMES];
+} PipeOutput;
+
+static CaptureFile file;
+static PipeOutput expected, output;
+
+static uint8_t MemorySink(void *context, const uint8_t *data, uint16_t len) {
+	CaptureFile *f = (CaptureFile *)context;
+
+	if(f->size + len > f->capacity){
+		f->capacity = 2 * (f->size + len);
+		f->data = realloc(f->data, f->capacity);
+		if(NULL == f->data){
+			return FALSE;
+		}
+	}
+	memcpy(&f->data[f->size], data, len);
+	f->size += len;
+
+	return TRUE;
+}
+
+static void OnOrdered(void *context, const MPU6050_PipeChunk *chunk) {
+	PipeOutput *out = (PipeOutput *)context;
+
+	if(chunk->firstFrame != out->count || out->count + chunk->count > FRAMES){
+		out->badFirstFrames++;
+		return;
+	}
+	memcpy(&out->accel[out->count], chunk->accel, chunk->count * sizeof(*chunk->accel));
+	memcpy(&out->rota[out->count], chunk->rota, chunk->count * sizeof(*chunk->rota));
+	memcpy(&out->temp[out->count], chunk->temp, chunk->count * sizeof(*chunk->temp));
+	out->count += chunk->count;
+	out->chunks++;
+}
+
+// Slow random walk near saturation on AX, so the bias removal clips now and then
+static void WriteCapture(MPU6050_ConfigTypeDef *config) {
+	static uint8_t buffer[2 * 4096];
+	MPU6050_CaptureWriter writer;
+	int16_t raw[MPU6050_CAPTURE_CHANNELS] = {32000, 0, 16384, -2000, 0, 0, 0};
+	uint32_t seed = 1;
+
+	CHECK_EQ(MPU6050_CaptureWriterInit(&writer, buffer, sizeof(buffer), MemorySink, &file), CAPTURE_OK);
+	CHECK_EQ(MPU6050_CaptureBegin(&writer, config, MPU6050_CAPTURE_ALL), CAPTURE_OK);
+	for(uint32_t n = 0; n < FRAMES; n++){
+		for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+			seed = seed * 1103515245u + 12345u;
+			raw[i] = (int16_t)(raw[i] + (int16_t)((seed >> 16) % 201) - 100);
+		}
+		CHECK_EQ(MPU6050_CaptureWriteRaw(&writer, raw, 1000 * n), CAPTURE_OK);
+	}
+	CHECK_EQ(MPU6050_CaptureFlush(&writer), CAPTURE_OK);
+}
+
+static int16_t SubSat(int16_t value, int16_t bias) {
+	int32_t result = (int32_t)value - bias;
+	return (int16_t)((result > INT16_MAX) ? INT16_MAX : (result < INT16_MIN) ? INT16_MIN : result);
+}
+
+// Reference: one pass over the file, one frame at a time
+static void RunSequential(const MPU6050_PipeConfig *pipeConfig) {
+	static int16_t history[FRAMES][MPU6050_CAPTURE_CHANNELS];
+	MPU6050_CaptureReader reader;
+	MPU6050_CaptureFrame frame;
+	MPU6050_ConfigTypeDef config;
+
+	memset(&config, 0, sizeof(config));
+	CHECK_EQ(MPU6050_CaptureReaderInit(&reader, file.data, file.size), CAPTURE_OK);
+	MPU6050_CaptureApplyHeader(&reader.header, &config);
+
+	for(uint32_t n = 0; CAPTURE_OK == MPU6050_CaptureReadFrame(&reader, &frame); n++){
+		int16_t out[MPU6050_CAPTURE_CHANNELS];
+		for(uint8_t i = 0; i < 3; i++){
+			frame.raw[i] = SubSat(frame.raw[i], pipeConfig->accelBias[i]);
+			frame.raw[4 + i] = SubSat(frame.raw[4 + i], pipeConfig->gyroBias[i]);
+		}
+		memcpy(history[n], frame.raw, sizeof(frame.raw));
+
+		int32_t len = (n + 1 < AVERAGE_LEN) ? (int32_t)n + 1 : AVERAGE_LEN;
+		for(uint8_t i = 0; i < MPU6050_CAPTURE_CHANNELS; i++){
+			int32_t sum = 0;
+			for(int32_t k = 0; k < len; k++){
+				sum += history[n - k][i];
+			}
+			out[i] = (int16_t)((sum >= 0) ? (sum + len / 2) / len : (sum - len / 2) / len);
+		}
+
+		expected.accel[n].rawAccelX = out[0];
+		expected.accel[n].rawAccelY = out[1];
+		expected.accel[n].rawAccelZ = out[2];
+		expected.temp[n].rawTemp = out[3];
+		expected.rota[n].rawRotaX = out[4];
+		expected.rota[n].rawRotaY = out[5];
+		expected.rota[n].rawRotaZ = out[6];
+		expected.accel[n].timestampUs = expected.rota[n].timestampUs = expected.temp[n].timestampUs = frame.timestampUs;
+		MPU6050_ConvertSample(&config, &expected.accel[n], &expected.rota[n], &expected.temp[n]);
+		expected.count++;
+	}
+}
+
+// Every field compared, padding left out
+static uint32_t CountMismatches(void) {
+	uint32_t mismatches = 0;
+
+	for(uint32_t n = 0; n < FRAMES; n++){
+		const MPU6050_Accelerations *a = &output.accel[n], *ea = &expected.accel[n];
+		const MPU6050_Rotations *r = &output.rota[n], *er = &expected.rota[n];
+		const MPU6050_Temperature *t = &output.temp[n], *et = &expected.temp[n];
+
+		if(a->rawAccelX != ea->rawAccelX || a->rawAccelY != ea->rawAccelY || a->rawAccelZ != ea->rawAccelZ ||
+		   a->convertedAccelX != ea->convertedAccelX || a->convertedAccelY != ea->convertedAccelY || a->convertedAccelZ != ea->convertedAccelZ ||
+		   r->rawRotaX != er->rawRotaX || r->rawRotaY != er->rawRotaY || r->rawRotaZ != er->rawRotaZ ||
+		   r->convertedRotaX != er->convertedRotaX || r->convertedRotaY != er->convertedRotaY || r->convertedRotaZ != er->convertedRotaZ ||
+		   t->rawTemp != et->rawTemp || t->convertedTemp != et->convertedTemp ||
+		   a->timestampUs != ea->timestampUs || r->timestampUs != er->timestampUs || t->timestampUs != et->timestampUs){
+			mismatches++;
+		}
+	}
+
+	return mismatches;
+}
+
+int main(void) {
+	static const uint32_t chunkBytes[] = {1000, 16384, 262144};
+	MPU6050_TestDevice dev;
+	MPU6050_PipeConfig pipeConfig;
+	MPU6050_PipeStats stats;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	WriteCapture(&dev.config);
+
+	memset(&pipeConfig, 0, sizeof(pipeConfig));
+	pipeConfig.accelBias[0] = -1000;
+	pipeConfig.accelBias[2] = 300;
+	pipeConfig.gyroBias[1] = 25;
+	pipeConfig.averageLen = AVERAGE_LEN;
+	pipeConfig.ordered = OnOrdered;
+	pipeConfig.context = &output;
+	RunSequential(&pipeConfig);
+	CHECK_EQ(expected.count, FRAMES);
+
+	for(uint8_t c = 0; c < sizeof(chunkBytes) / sizeof(chunkBytes[0]); c++){
+		for(uint8_t threads = 1; threads <= MAX_THREADS; threads *= 2){
+			memset(&output, 0, sizeof(output));
+			pipeConfig.threads = threads;
+			pipeConfig.chunkBytes = chunkBytes[c];
+
+			CHECK_EQ(MPU6050_PipeRun(file.data, file.size, &pipeConfig, &stats), PIPE_OK);
+			CHECK_EQ(stats.frames, FRAMES);
+			CHECK_EQ(stats.corruptBlocks, 0);
+			CHECK_EQ(output.count, FRAMES);
+			CHECK_EQ(output.chunks, stats.chunks);
+			CHECK_EQ(output.badFirstFrames, 0);
+			CHECK_EQ(CountMismatches(), 0);
+			printf("%u threads, %u-byte chunks: %u chunks, %.0f samples/s\n", stats.threads, chunkBytes[c], stats.chunks, stats.samplesPerSec);
+		}
+	}
+
+	pipeConfig.averageLen = MPU6050_PIPE_MAX_AVERAGE + 1;
+	CHECK_EQ(MPU6050_PipeRun(file.data, file.size, &pipeConfig, &stats), ERR_PIPE_CONFIG);
+
+	free(file.data);
+
+	return TEST_RESULT();
+}
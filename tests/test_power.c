@@ -0,0 +1,77 @@
+// The power manager enters the cycle mode once idle and wakes up on simulated motion, also when
+// a FIFO drain read INT_STATUS (and cleared MOT_INT) before MPU6050_PowerUpdate
+#include "MPU6050_TEST.h"
+
+#define IDLE_TIMEOUT_MS		100
+#define STEP_NS				10000000ull
+#define WAKE_PERIOD_NS		200000000ull	// LP_WAKE_CTRL_CONFIG_1: 5Hz
+
+static MPU6050_SimBus *clockBus;
+
+// Host clock in step with the simulated bus
+static uint32_t SimClockUs(void) {
+	return (uint32_t)(clockBus->timeNs / 1000);
+}
+
+static void RunIdle(MPU6050_TestDevice *dev, MPU6050_PowerManager *pm) {
+	for(uint32_t t = 0; t <= IDLE_TIMEOUT_MS + 20; t += 10){
+		MPU6050_SimAdvance(&dev->bus, STEP_NS);
+		CHECK_EQ(MPU6050_PowerUpdate(pm), POWER_OK);
+	}
+	CHECK_EQ(MPU6050_PowerGetMode(pm), POWER_MODE_CYCLE);
+	CHECK(dev->sim.regs[REG_PWR_MGMT_1] & CYCLE_CONFIG_SET);
+	CHECK_EQ(dev->sim.regs[REG_PWR_MGMT_2] & GET_LP_WAKE_CTRL_CONFIG, LP_WAKE_CTRL_CONFIG_1);
+	CHECK_EQ(dev->sim.regs[REG_INT_ENABLE], MOT_EN_CONFIG_SET);
+}
+
+// Motion raises MOT_INT at the next wake-up of the sensor, which fires the INT pin
+static void Move(MPU6050_TestDevice *dev, MPU6050_PowerManager *pm, float accelXG) {
+	dev->sim.accelG[0] = accelXG;
+	MPU6050_SimAdvance(&dev->bus, WAKE_PERIOD_NS + STEP_NS);
+	CHECK(dev->sim.regs[REG_INT_STATUS] & MOT_INT_FLAG);
+	MPU6050_PowerIRQHandler(pm);
+}
+
+static void CheckAwake(MPU6050_TestDevice *dev, MPU6050_PowerManager *pm, uint32_t wakeUps) {
+	CHECK_EQ(MPU6050_PowerUpdate(pm), POWER_OK);
+	CHECK_EQ(pm->wakeUps, wakeUps);
+	CHECK_EQ(MPU6050_PowerGetMode(pm), POWER_MODE_ACTIVE);
+	CHECK_EQ(dev->sim.regs[REG_PWR_MGMT_1] & CYCLE_CONFIG_SET, 0);
+	CHECK_EQ(dev->sim.regs[REG_PWR_MGMT_2], 0);
+	CHECK_EQ(dev->sim.regs[REG_INT_ENABLE], DATA_RDY_EN_CONFIG_SET);
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_PowerManager pm;
+	static MPU6050_FifoSample samples[64];
+	MPU6050_FifoRing ring;
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	clockBus = &dev.bus;
+	dev.config.clock = SimClockUs;
+	dev.sim.accelG[2] = 1.0f;
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	CHECK_EQ(MPU6050_ConfigInterrupts(&dev.config, 0x0, DATA_RDY_EN_CONFIG_SET), INT_OK);
+	CHECK_EQ(MPU6050_ConfigMotion(&dev.config, 20, 1, 0), POWER_OK);
+	CHECK_EQ(MPU6050_PowerInit(&pm, &dev.config, LP_WAKE_CTRL_CONFIG_1, IDLE_TIMEOUT_MS), POWER_OK);
+	MPU6050_FifoRingInit(&ring, samples, sizeof(samples) / sizeof(samples[0]));
+	CHECK_EQ(MPU6050_FifoEnable(&dev.config, ACCEL_FIFO_EN_CONFIG_SET), FIFO_OK);
+
+	// Idle, then motion read by MPU6050_PowerUpdate itself
+	RunIdle(&dev, &pm);
+	CHECK_EQ(pm.idleEntries, 1);
+	Move(&dev, &pm, 0.5f);
+	CheckAwake(&dev, &pm, 1);
+
+	// Idle again, then motion whose flag a FIFO drain clears before the update
+	RunIdle(&dev, &pm);
+	CHECK_EQ(pm.idleEntries, 2);
+	Move(&dev, &pm, 0.0f);
+	MPU6050_FifoDrain(&dev.config, &ring);
+	CHECK_EQ(dev.sim.regs[REG_INT_STATUS] & MOT_INT_FLAG, 0);
+	CheckAwake(&dev, &pm, 2);
+	CHECK_EQ(dev.config.intStatusPending, 0);
+
+	return TEST_RESULT();
+}
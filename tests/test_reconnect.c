@@ -0,0 +1,86 @@
+// A lost device is re-initialized with the offsets last written by the library, not with
+// whatever its offset registers hold when it comes back. MPU6050_Init forgets the settings its
+// reset clears, so a later reconnection does not bring them back
+#include "MPU6050_TEST.h"
+
+static void LoseAndReconnect(MPU6050_TestDevice *dev) {
+	MPU6050_SimInjectFault(&dev->bus, SIM_FAULT_NACK, MPU6050_LOST_ERRORS);
+	for(uint8_t i = 0; i < MPU6050_LOST_ERRORS; i++){
+		CHECK_EQ(MPU6050_GetAllSensors(&dev->config, NULL, NULL, NULL), ERR_CONN_0);
+	}
+	CHECK_EQ(dev->config.connState, CONN_STATE_LOST);
+	CHECK_EQ(MPU6050_GetAllSensors(&dev->config, NULL, NULL, NULL), CONN_OK);
+	CHECK_EQ(dev->config.connState, CONN_STATE_CONNECTED);
+}
+
+static void CheckSimOffsets(MPU6050_Sim *sim, uint8_t reg, const int16_t expected[3]) {
+	for(uint8_t axis = 0; axis < 3; axis++){
+		CHECK_EQ(MPU6050_BYTES_TO_INT16(sim->regs[reg + 2 * axis], sim->regs[reg + 2 * axis + 1]), expected[axis]);
+	}
+}
+
+int main(void) {
+	MPU6050_TestDevice dev;
+	MPU6050_AccelOffsets accelOff = {-1200, 350, 2048};
+	MPU6050_GyroOffsets gyroOff = {17, -42, 1000};
+	static const int16_t accelExpected[3] = {-1200, 350, 2048};
+	static const int16_t gyroExpected[3] = {17, -42, 1000};
+	static const int16_t zero[3] = {0, 0, 0};
+
+	MPU6050_TestDeviceInit(&dev, MPU6050_ADDRESS_AD0_L);
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	CHECK_EQ(MPU6050_SetAccelOffset(&dev.config, &accelOff), WRITE_OK);
+	CHECK_EQ(MPU6050_SetGyroOffset(&dev.config, &gyroOff), WRITE_OK);
+
+	// The device drops off the bus and comes back power cycled, with garbage in the offsets
+	MPU6050_SimInjectFault(&dev.bus, SIM_FAULT_NACK, MPU6050_LOST_ERRORS);
+	for(uint8_t i = 0; i < MPU6050_LOST_ERRORS; i++){
+		CHECK_EQ(MPU6050_GetAllSensors(&dev.config, NULL, NULL, NULL), ERR_CONN_0);
+	}
+	CHECK_EQ(dev.config.connState, CONN_STATE_LOST);
+	MPU6050_SimReset(&dev.sim, dev.bus.timeNs);
+	for(uint8_t reg = REG_XA_OFFS_USRH; reg < REG_XA_OFFS_USRH + 6; reg++){
+		dev.sim.regs[reg] = 0x5A;
+	}
+
+	CHECK_EQ(MPU6050_GetAllSensors(&dev.config, NULL, NULL, NULL), CONN_OK);
+	CHECK_EQ(dev.config.connState, CONN_STATE_CONNECTED);
+	CheckSimOffsets(&dev.sim, REG_XA_OFFS_USRH, accelExpected);
+	CheckSimOffsets(&dev.sim, REG_XG_OFFS_USRH, gyroExpected);
+
+	// MPU6050_Init clears the offsets, a later reconnection leaves them at their reset value
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	LoseAndReconnect(&dev);
+	CheckSimOffsets(&dev.sim, REG_XA_OFFS_USRH, zero);
+	CheckSimOffsets(&dev.sim, REG_XG_OFFS_USRH, zero);
+
+	// FIFO, interrupts, auxiliary master, motion detection and cycle mode, then MPU6050_Init
+	MPU6050_PowerManager pm;
+	CHECK_EQ(MPU6050_FifoEnable(&dev.config, ACCEL_FIFO_EN_CONFIG_SET), FIFO_OK);
+	CHECK_EQ(MPU6050_ConfigInterrupts(&dev.config, LATCH_INT_EN_CONFIG_SET, DATA_RDY_EN_CONFIG_SET), INT_OK);
+	CHECK_EQ(MPU6050_AuxEnable(&dev.config, I2C_MST_CLK_CONFIG_13, 0), AUX_OK);
+	CHECK_EQ(MPU6050_ConfigMotion(&dev.config, 10, 1, 0), POWER_OK);
+	CHECK_EQ(MPU6050_PowerInit(&pm, &dev.config, LP_WAKE_CTRL_CONFIG_1, 100), POWER_OK);
+	CHECK_EQ(MPU6050_EnterCycleMode(&dev.config, LP_WAKE_CTRL_CONFIG_1, MOT_EN_CONFIG_SET), POWER_OK);
+	CHECK_EQ(MPU6050_PowerGetMode(&pm), POWER_MODE_CYCLE);
+	CHECK(dev.sim.regs[REG_PWR_MGMT_1] & CYCLE_CONFIG_SET);
+
+	CHECK_EQ(MPU6050_Init(&dev.config), INIT_OK);
+	CHECK_EQ(MPU6050_PowerGetMode(&pm), POWER_MODE_ACTIVE);
+	CHECK_EQ(dev.config.fifoEnConfig, 0);
+	CHECK_EQ(dev.config.intPinConfig, 0);
+	CHECK_EQ(dev.config.intEnableConfig, 0);
+	CHECK_EQ(dev.config.auxEnabled, FALSE);
+	CHECK_EQ(dev.config.motThrConfig, 0);
+
+	// The reconnection only restores what MPU6050_Init configured
+	LoseAndReconnect(&dev);
+	CHECK_EQ(dev.sim.regs[REG_PWR_MGMT_1] & CYCLE_CONFIG_SET, 0);
+	CHECK_EQ(dev.sim.regs[REG_FIFO_EN], 0);
+	CHECK_EQ(dev.sim.regs[REG_INT_PIN_CFG], 0);
+	CHECK_EQ(dev.sim.regs[REG_INT_ENABLE], 0);
+	CHECK_EQ(dev.sim.regs[REG_MOT_THR], 0);
+	CHECK_EQ(dev.sim.regs[REG_USER_CTRL] & (I2C_MST_EN_CONFIG_SET | FIFO_EN_CONFIG_SET), 0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,198 @@
+// MPU6050_SchedTrigger reads every device of two blocking simulated buses without recursing
+// from one completion into the next start. With non-blocking reads of simulated latency, the
+// two buses transfer in parallel and complete out of order, the devices of one bus go
+// back-to-back, and the age and jitter of every device follow the injected latency
+#include <stdint.h>
+#include "MPU6050_SCHED.h"
+#include "MPU6050_TEST.h"
+
+#define BUSES		2
+#define CYCLES		100
+#define PERIOD_US	1000
+
+static MPU6050_Transport depthTransport;
+static uintptr_t minDepth = UINTPTR_MAX, maxDepth;
+static uint32_t nowUs;
+
+static uint32_t TestClock(void) {
+	return nowUs;
+}
+
+// Simulated DMA: one transfer in flight per bus, finished by the event loop of RunAsyncCycle
+typedef struct {
+	MPU6050_ConfigTypeDef *config;
+	uint8_t reg;
+	uint8_t *data;
+	uint16_t len;
+	uint8_t pending;
+	uint32_t endUs;
+} DmaTransfer;
+
+static MPU6050_TestDevice *dmaDev;
+static DmaTransfer dma[BUSES];
+static uint32_t latencyUs[BUSES];
+static uint32_t sameBusOverlaps, parallelStarts;
+
+static uint8_t DmaStartRead(MPU6050_ConfigTypeDef *config, uint8_t reg, uint8_t *data, uint16_t len) {
+	uint8_t b = (config->hi2c == &dmaDev[0].hi2c) ? 0 : 1;
+
+	if(dma[b].pending){
+		sameBusOverlaps++;
+	}
+	if(dma[b ^ 1].pending){
+		parallelStarts++;
+	}
+	dma[b] = (DmaTransfer){config, reg, data, len, TRUE, nowUs + latencyUs[b]};
+
+	return ASYNC_OK;
+}
+
+// One trigger, then the transfers complete in time order until both buses are idle. Returns
+// the bus of the first completion
+static uint8_t RunAsyncCycle(MPU6050_Scheduler *sched) {
+	uint8_t first = BUSES;
+
+	MPU6050_SchedTrigger(sched);
+	while(dma[0].pending || dma[1].pending){
+		uint8_t b = (dma[0].pending && (!dma[1].pending || dma[0].endUs <= dma[1].endUs)) ? 0 : 1;
+		DmaTransfer *t = &dma[b];
+
+		nowUs = t->endUs;
+		t->pending = FALSE;
+		if(BUSES == first){
+			first = b;
+		}
+		HAL_StatusTypeDef status = MPU6050_SimTransport.read(t->config->hi2c, t->config->address, t->reg, t->data, t->len);
+		MPU6050_SchedComplete(sched, t->config->hi2c, HAL_OK == status);
+	}
+
+	return first;
+}
+
+// Simulator read that records the stack position it is called from
+static HAL_StatusTypeDef DepthRead(I2C_HandleTypeDef *hi2c, uint8_t address, uint8_t reg, uint8_t *data, uint16_t len) {
+	volatile uint8_t marker = 0;
+	uintptr_t depth = (uintptr_t)&marker;
+
+	minDepth = (depth < minDepth) ? depth : minDepth;
+	maxDepth = (depth > maxDepth) ? depth : maxDepth;
+
+	return MPU6050_SimTransport.read(hi2c, address, reg, data, len);
+}
+
+int main(void) {
+	static MPU6050_TestDevice dev[BUSES];
+	static MPU6050_Sim second[BUSES];
+	static MPU6050_ConfigTypeDef secondConfig[BUSES];
+	static MPU6050_Scheduler sched;
+	MPU6050_Accelerations accel;
+	uint32_t ageUs;
+	uint8_t index;
+
+	depthTransport = MPU6050_SimTransport;
+	depthTransport.read = DepthRead;
+
+	// Two devices (AD0 low and high) on each bus, every device with its own X acceleration
+	MPU6050_SchedInit(&sched, TestClock, PERIOD_US);
+	for(uint8_t b = 0; b < BUSES; b++){
+		MPU6050_TestDeviceInit(&dev[b], MPU6050_ADDRESS_AD0_L);
+		MPU6050_SimInit(&second[b], MPU6050_ADDRESS_AD0_H);
+		CHECK(MPU6050_SimAttach(&dev[b].bus, &second[b]));
+		dev[b].sim.accelG[0] = 0.25f * (2 * b);
+		second[b].accelG[0] = 0.25f * (2 * b + 1);
+
+		secondConfig[b] = dev[b].config;
+		secondConfig[b].address = MPU6050_ADDRESS_AD0_H;
+		dev[b].config.transport = &depthTransport;
+		secondConfig[b].transport = &depthTransport;
+
+		CHECK_EQ(MPU6050_Init(&dev[b].config), INIT_OK);
+		CHECK_EQ(MPU6050_Init(&secondConfig[b]), INIT_OK);
+		MPU6050_SimAdvance(&dev[b].bus, 5000000);
+
+		CHECK_EQ(MPU6050_SchedAddDevice(&sched, &dev[b].config, NULL, &index), SCHED_OK);
+		CHECK_EQ(index, 2 * b);
+		CHECK_EQ(MPU6050_SchedAddDevice(&sched, &secondConfig[b], NULL, &index), SCHED_OK);
+		CHECK_EQ(index, 2 * b + 1);
+		MPU6050_SimResetStats(&dev[b].bus);
+	}
+
+	minDepth = UINTPTR_MAX;
+	maxDepth = 0;
+	for(uint32_t c = 0; c < CYCLES; c++){
+		nowUs += PERIOD_US;
+		MPU6050_SchedTrigger(&sched);
+	}
+
+	// Every read is issued from the same frame: the start loop, not a chain of completions
+	CHECK(minDepth == maxDepth);
+
+	// One burst per device and cycle, nothing left in flight or queued
+	for(uint8_t b = 0; b < BUSES; b++){
+		CHECK_EQ(dev[b].bus.transactions, 2 * CYCLES);
+		CHECK_EQ(dev[b].bus.errors, 0);
+	}
+	for(uint8_t i = 0; i < sched.numDevices; i++){
+		CHECK_EQ(sched.devices[i].samples, CYCLES);
+		CHECK_EQ(sched.devices[i].overruns, 0);
+		CHECK_EQ(sched.devices[i].maxJitter, 0);
+		CHECK_EQ(sched.devices[i].queued, FALSE);
+		CHECK_EQ(sched.devices[i].reader.busy, FALSE);
+
+		CHECK_EQ(MPU6050_SchedGetSample(&sched, i, &accel, NULL, NULL, &ageUs), SCHED_OK);
+		CHECK_EQ(accel.rawAccelX, i * ACCEL_LSB_SEN_0 / 4);
+		CHECK_EQ(ageUs, 0);
+	}
+
+	// A device that fails to start does not stall the other device of its bus
+	MPU6050_SimInjectFault(&dev[0].bus, SIM_FAULT_NACK, 1);
+	nowUs += PERIOD_US;
+	MPU6050_SchedTrigger(&sched);
+	CHECK_EQ(sched.devices[0].samples, CYCLES);
+	CHECK_EQ(sched.devices[0].reader.errors, 1);
+	CHECK_EQ(sched.devices[1].samples, CYCLES + 1);
+	CHECK_EQ(sched.devices[2].samples, CYCLES + 1);
+	CHECK_EQ(sched.devices[3].samples, CYCLES + 1);
+
+	// Non-blocking reads: bus 0 takes 300us or 400us per read (100us of jitter), bus 1 170us
+	static MPU6050_Scheduler asyncSched;
+	uint32_t cycleStartUs = nowUs;
+	uint32_t firstOnBus1 = 0;
+
+	dmaDev = dev;
+	MPU6050_SchedInit(&asyncSched, TestClock, PERIOD_US);
+	for(uint8_t b = 0; b < BUSES; b++){
+		CHECK_EQ(MPU6050_SchedAddDevice(&asyncSched, &dev[b].config, DmaStartRead, NULL), SCHED_OK);
+		CHECK_EQ(MPU6050_SchedAddDevice(&asyncSched, &secondConfig[b], DmaStartRead, NULL), SCHED_OK);
+	}
+	for(uint32_t c = 0; c < CYCLES; c++){
+		cycleStartUs += PERIOD_US;
+		nowUs = cycleStartUs;
+		latencyUs[0] = (c & 1) ? 400 : 300;
+		latencyUs[1] = 170;
+		firstOnBus1 += (1 == RunAsyncCycle(&asyncSched));
+	}
+
+	// Bus 0 is started first but bus 1 completes first. Every start on bus 1 finds bus 0 busy,
+	// and the second read of bus 0 overlaps the one of bus 1 when bus 0 takes 300us
+	CHECK_EQ(firstOnBus1, CYCLES);
+	CHECK_EQ(parallelStarts, 2 * CYCLES + CYCLES / 2);
+	CHECK_EQ(sameBusOverlaps, 0);
+
+	// The second device of a bus waits for the first one: twice the latency and its jitter
+	static const uint32_t maxJitter[2 * BUSES] = {100, 200, 0, 0};
+	nowUs = cycleStartUs + PERIOD_US;
+	for(uint8_t i = 0; i < asyncSched.numDevices; i++){
+		uint32_t lastLatencyUs = latencyUs[i / 2];
+
+		CHECK_EQ(asyncSched.devices[i].samples, CYCLES);
+		CHECK_EQ(asyncSched.devices[i].overruns, 0);
+		CHECK_EQ(asyncSched.devices[i].reader.errors, 0);
+		CHECK_EQ(asyncSched.devices[i].maxJitter, maxJitter[i]);
+		CHECK_EQ(MPU6050_SchedGetSample(&asyncSched, i, &accel, NULL, NULL, &ageUs), SCHED_OK);
+		CHECK_EQ(accel.rawAccelX, i * ACCEL_LSB_SEN_0 / 4);
+		CHECK_EQ(ageUs, PERIOD_US - (i % 2 + 1) * lastLatencyUs);
+	}
+
+	return TEST_RESULT();
+}